@@ -0,0 +1,74 @@
+#version 430 core
+
+// 视锥体剔除,每个线程测试一个物体,可见时在材质对应的区域追加一条间接绘制命令
+layout(local_size_x = 64) in;
+
+#include "../include/Objects.glsl"
+
+// 网格在共享顶点缓冲与元素缓冲中的范围,C++端对应IndirectMeshRange
+struct MeshRange
+{
+    uint count;
+    uint firstIndex;
+    int baseVertex;
+    uint padding;
+};
+
+// 间接绘制命令,C++端对应DrawElementsIndirectCommand
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer ObjectBuffer
+{
+    ObjectData objects[];
+};
+layout(std430, binding = 1) readonly buffer MeshBuffer
+{
+    MeshRange meshes[];
+};
+layout(std430, binding = 2) writeonly buffer CommandBuffer
+{
+    DrawCommand commands[];
+};
+// 每个材质的可见命令数量,每帧剔除前清零,同时作为绘制数量缓冲
+layout(std430, binding = 3) buffer DrawCountBuffer
+{
+    uint drawCounts[];
+};
+// 每个材质的命令区域起点
+layout(std430, binding = 4) readonly buffer CommandOffsetBuffer
+{
+    uint commandOffsets[];
+};
+
+// 视锥体平面,法线指向内部并已归一化
+uniform vec4 frustumPlanes[6];
+// 物体数量
+uniform uint objectCount;
+
+void main()
+{
+    uint objectIndex = gl_GlobalInvocationID.x;
+    if(objectIndex >= objectCount)
+        return;
+
+    ObjectData object = objects[objectIndex];
+    vec3 center = object.boundingSphere.xyz;
+    float radius = object.boundingSphere.w;
+    for(int i = 0; i < 6; i++)
+    {
+        if(dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius)
+            return;
+    }
+
+    // baseInstance为物体下标,顶点着色器通过每实例前进一次的属性读到它
+    MeshRange mesh = meshes[object.meshIndex];
+    uint slot = commandOffsets[object.materialIndex] + atomicAdd(drawCounts[object.materialIndex], 1u);
+    commands[slot] = DrawCommand(mesh.count, 1u, mesh.firstIndex, mesh.baseVertex, objectIndex);
+}
@@ -0,0 +1,79 @@
+#version 330 core
+
+// 关键字见Lighting.vs.glsl
+#pragma keywords DIRECTION_LIGHT SHADOWS
+
+#ifndef DIRECTION_LIGHT
+flat in vec4 lightPositionRadius;
+flat in vec3 lightAttenuation;
+flat in vec3 lightAmbient;
+flat in vec3 lightDiffuse;
+flat in vec3 lightSpecular;
+flat in int isFirstLight;
+#endif
+
+#include "../include/Frame.glsl"
+#include "../PhongLight/include/Lighting.glsl"
+#ifdef SHADOWS
+#include "../PhongLight/include/Shadows.glsl"
+#endif
+
+// 几何缓冲,与DeferredRenderer::Attachment一致
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2D gDiffuse;
+uniform sampler2D gSpecular;
+// 裁剪矩阵乘视图矩阵的逆,由深度重建世界坐标
+uniform mat4 inverseViewProjection;
+
+out vec4 finalColor;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, texel, 0).r;
+    // 没有几何体的像素
+    if(depth == 1.0f)
+    {
+        discard;
+    }
+    vec3 ndc = vec3(gl_FragCoord.xy / vec2(textureSize(gDepth, 0)), depth) * 2.0f - 1.0f;
+    vec4 worldPosition = inverseViewProjection * vec4(ndc, 1.0f);
+    vec3 position = worldPosition.xyz / worldPosition.w;
+
+    vec4 normalShininess = texelFetch(gNormal, texel, 0);
+    vec3 normal = normalize(normalShininess.xyz);
+    vec3 diffuseColor = texelFetch(gDiffuse, texel, 0).rgb;
+    vec3 specularColor = texelFetch(gSpecular, texel, 0).rgb;
+    vec3 viewDir = normalize(cameraPosition - position);
+
+#ifdef DIRECTION_LIGHT
+#ifdef SHADOWS
+    float shadow = sampleDirectionShadow(position, normal);
+#else
+    float shadow = 1.0f;
+#endif
+    vec3 result = shadeDirectionLight(directionLight, normal, viewDir, diffuseColor, diffuseColor, specularColor, normalShininess.w, shadow);
+#else
+    // 体积是影响范围的外接多面体,范围外的像素不计算
+    if(length(position - lightPositionRadius.xyz) > lightPositionRadius.w)
+    {
+        discard;
+    }
+    PointLight pointLight;
+    pointLight.position = lightPositionRadius.xyz;
+    pointLight.constant = lightAttenuation.x;
+    pointLight.linear = lightAttenuation.y;
+    pointLight.quadratic = lightAttenuation.z;
+    pointLight.ambient = lightAmbient;
+    pointLight.diffuse = lightDiffuse;
+    pointLight.specular = lightSpecular;
+#ifdef SHADOWS
+    float shadow = 1 == isFirstLight ? samplePointShadow(position, normal) : 1.0f;
+#else
+    float shadow = 1.0f;
+#endif
+    vec3 result = shadePointLight(pointLight, position, normal, viewDir, diffuseColor, diffuseColor, specularColor, normalShininess.w, shadow);
+#endif
+    finalColor = vec4(result, 1.0f);
+}
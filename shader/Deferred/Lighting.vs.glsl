@@ -0,0 +1,46 @@
+#version 330 core
+
+// 延迟渲染光照阶段
+// 默认: 每个点光源实例化绘制一个包围其影响范围的体积,只有体积覆盖的像素计算该光源
+// DIRECTION_LIGHT: 平行光影响所有像素,绘制覆盖屏幕的三角形,顶点由gl_VertexID生成
+// SHADOWS: 平行光使用级联阴影,点光源中只有第一个即LightData中的点光源使用立方体阴影
+#pragma keywords DIRECTION_LIGHT SHADOWS
+
+#ifndef DIRECTION_LIGHT
+// 单位半径的体积顶点
+layout(location = 0) in vec3 vertexPosition;
+// 光源影响范围,xyz为位置,w为半径,来自PointLightList
+layout(location = 1) in vec4 lightBounds;
+// 光源参数,与Lighting.glsl中的PointLight相同
+layout(location = 2) in vec3 lightAttenuationIn;
+layout(location = 3) in vec3 lightAmbientIn;
+layout(location = 4) in vec3 lightDiffuseIn;
+layout(location = 5) in vec3 lightSpecularIn;
+
+// 每个光源的数据在体积内不变,不插值
+flat out vec4 lightPositionRadius;
+flat out vec3 lightAttenuation;
+flat out vec3 lightAmbient;
+flat out vec3 lightDiffuse;
+flat out vec3 lightSpecular;
+// 是否为第一个光源
+flat out int isFirstLight;
+#endif
+
+#include "../include/Frame.glsl"
+
+void main()
+{
+#ifdef DIRECTION_LIGHT
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
+#else
+    gl_Position = viewProjection * vec4(lightBounds.xyz + vertexPosition * lightBounds.w, 1.0f);
+    lightPositionRadius = lightBounds;
+    lightAttenuation = lightAttenuationIn;
+    lightAmbient = lightAmbientIn;
+    lightDiffuse = lightDiffuseIn;
+    lightSpecular = lightSpecularIn;
+    isFirstLight = 0 == gl_InstanceID ? 1 : 0;
+#endif
+}
@@ -6,13 +6,13 @@ layout(location = 1) in vec3 vertexNormal;
 out vec3 worldVertexPosition;
 out vec3 worldVertexNormal;
 
+uniform mat4 mvp;
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(vertexPosition, 1.0f);
+    gl_Position = mvp * vec4(vertexPosition, 1.0f);
     worldVertexPosition = vec3(model * vec4(vertexPosition, 1.0f));
-    worldVertexNormal = mat3(transpose(inverse(model))) * vertexNormal;
+    worldVertexNormal = normalMatrix * vertexNormal;
 }
@@ -14,21 +14,21 @@ out vec3 worldVertexNormal;
 // 输出顶点UV
 out vec2 vertexUV;
 
+// 模型视图裁剪矩阵
+uniform mat4 mvp;
 // 模型矩阵
 uniform mat4 model;
-// 视图矩阵
-uniform mat4 view;
-// 裁剪矩阵
-uniform mat4 projection;
+// 法线矩阵,模型矩阵左上3x3的逆转置
+uniform mat3 normalMatrix;
 
 void main()
 {
     // 输出顶点位置
-    gl_Position = projection * view * model * vec4(vertexPosition, 1.0f);
+    gl_Position = mvp * vec4(vertexPosition, 1.0f);
     // 输出世界坐标系的顶点位置
     worldVertexPosition = vec3(model * vec4(vertexPosition, 1.0f));
     // 输出世界坐标系的法线
-    worldVertexNormal = mat3(transpose(inverse(model))) * vertexNormal;
+    worldVertexNormal = normalMatrix * vertexNormal;
     // 输出顶点UV
     vertexUV = vertexUVIn;
 }
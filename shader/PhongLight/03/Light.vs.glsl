@@ -2,11 +2,10 @@
 
 layout(location = 0) in vec3 vertexPosition;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// CPU端预先相乘的模型视图裁剪矩阵
+uniform mat4 mvp;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(vertexPosition, 1.0f);
+    gl_Position = mvp * vec4(vertexPosition, 1.0f);
 }
@@ -2,11 +2,10 @@
 
 layout(location = 0) in vec3 vertexPosition;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// 模型-视图-裁剪矩阵,在CPU上计算
+uniform mat4 mvp;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(vertexPosition, 1.0f);
+    gl_Position = mvp * vec4(vertexPosition, 1.0f);
 }
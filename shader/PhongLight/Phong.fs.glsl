@@ -0,0 +1,107 @@
+#version 330 core
+
+// 特性关键字,由ShaderPermutation按组合注入为#define,每个变体只编译需要的代码
+// MATERIAL_MAPS: 漫反射与镜面反射使用贴图,否则使用材质颜色
+// EMISSION_MAP: 叠加自发光贴图
+// DIRECTION_LIGHT: 使用平行光,否则使用带衰减的点光源
+// GBUFFER: 延迟渲染的几何阶段,输出法线、漫反射与镜面反射颜色,不计算光照
+// CLUSTERED: 分簇前向渲染,累积片段所在簇的所有点光源,与DIRECTION_LIGHT同时使用时叠加平行光
+// SHADOWS: 平行光使用级联阴影,点光源使用立方体阴影,分簇时只有第一个点光源带阴影,GBUFFER时由光照阶段计算
+#pragma keywords MATERIAL_MAPS EMISSION_MAP DIRECTION_LIGHT GBUFFER CLUSTERED SHADOWS
+
+// 使用贴图时才需要UV
+#if defined(MATERIAL_MAPS) || defined(EMISSION_MAP)
+#define HAS_UV
+#endif
+
+in vec3 worldVertexPosition;
+in vec3 worldVertexNormal;
+#ifdef HAS_UV
+in vec2 vertexUV;
+#endif
+
+#include "../include/Frame.glsl"
+#include "include/Lighting.glsl"
+#ifdef CLUSTERED
+#include "include/Clusters.glsl"
+#endif
+#ifdef SHADOWS
+#include "include/Shadows.glsl"
+#endif
+
+uniform Material material;
+
+#ifdef GBUFFER
+// 几何缓冲,位置由深度缓冲重建,顺序与DeferredRenderer::Attachment一致
+// 法线,w为镜面反射指数
+layout(location = 0) out vec4 gNormal;
+// 漫反射颜色
+layout(location = 1) out vec4 gDiffuse;
+// 镜面反射颜色
+layout(location = 2) out vec4 gSpecular;
+// 光照累积
+layout(location = 3) out vec4 gLighting;
+#else
+out vec4 finalColor;
+#endif
+
+void main()
+{
+    // 材质颜色
+#ifdef MATERIAL_MAPS
+    vec3 diffuseColor = texture(material.diffuse, vertexUV).rgb;
+    vec3 specularColor = texture(material.specular, vertexUV).rgb;
+    vec3 ambientColor = diffuseColor;
+#else
+    vec3 diffuseColor = material.diffuse;
+    vec3 specularColor = material.specular;
+    vec3 ambientColor = material.ambient;
+#endif
+
+#ifdef GBUFFER
+    // 只写入几何缓冲,光照在延迟渲染的光照阶段计算
+    // 几何缓冲不单独保存环境光颜色,光照阶段以漫反射颜色作为环境光颜色,与使用贴图的材质相同
+    gNormal = vec4(normalize(worldVertexNormal), material.shininess);
+    gDiffuse = vec4(diffuseColor, 1.0f);
+    gSpecular = vec4(specularColor, 1.0f);
+    vec3 result = vec3(0.0f);
+#else
+    vec3 normal = normalize(worldVertexNormal);
+    vec3 viewDirRef = normalize(cameraPosition - worldVertexPosition);
+    // 阴影可见度,只采样用到的光源
+#if defined(SHADOWS) && defined(DIRECTION_LIGHT)
+    float directionShadow = sampleDirectionShadow(worldVertexPosition, normal);
+#else
+    float directionShadow = 1.0f;
+#endif
+#if defined(SHADOWS) && (defined(CLUSTERED) || !defined(DIRECTION_LIGHT))
+    float pointShadow = samplePointShadow(worldVertexPosition, normal);
+#else
+    float pointShadow = 1.0f;
+#endif
+#ifdef CLUSTERED
+    vec3 result = shadeClusteredLights(worldVertexPosition, normal, viewDirRef, ambientColor, diffuseColor, specularColor, material.shininess,
+                                       pointShadow);
+#ifdef DIRECTION_LIGHT
+    result += shadeDirectionLight(directionLight, normal, viewDirRef, ambientColor, diffuseColor, specularColor, material.shininess,
+                                  directionShadow);
+#endif
+#elif defined(DIRECTION_LIGHT)
+    vec3 result = shadeDirectionLight(directionLight, normal, viewDirRef, ambientColor, diffuseColor, specularColor, material.shininess,
+                                      directionShadow);
+#else
+    vec3 result = shadePointLight(light, worldVertexPosition, normal, viewDirRef, ambientColor, diffuseColor, specularColor, material.shininess,
+                                  pointShadow);
+#endif
+#endif
+
+#ifdef EMISSION_MAP
+    result += texture(material.emission, vertexUV).rgb;
+#endif
+#ifdef GBUFFER
+    // 自发光作为光照累积的初始值
+    gLighting = vec4(result, 1.0f);
+#else
+    finalColor = vec4(result, 1.0f);
+#endif
+}
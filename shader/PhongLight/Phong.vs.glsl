@@ -0,0 +1,96 @@
+#version 330 core
+
+// 特性关键字,MATERIAL_MAPS与EMISSION_MAP见Phong.fs.glsl
+// 默认: 模型-视图-裁剪矩阵、模型矩阵与法线矩阵来自逐物体的uniform,均在CPU上计算
+// INSTANCED: 同样的三个矩阵来自每实例前进一次的顶点属性,一次绘制所有实例
+// INDIRECT: 模型矩阵与法线矩阵来自物体存储缓冲,物体下标由间接绘制命令的baseInstance给出,需要OpenGL 4.3
+// 法线矩阵总是预先计算,顶点着色器中不做矩阵求逆
+#pragma keywords MATERIAL_MAPS EMISSION_MAP INSTANCED INDIRECT
+
+#ifdef INDIRECT
+// 存储缓冲与binding布局限定符在330中以扩展的形式使用,其余部分与3.3路径共用
+#extension GL_ARB_shader_storage_buffer_object : require
+#extension GL_ARB_shading_language_420pack : require
+#endif
+
+// 使用贴图时才需要UV
+#if defined(MATERIAL_MAPS) || defined(EMISSION_MAP)
+#define HAS_UV
+#endif
+
+// 顶点位置
+layout(location = 0) in vec3 vertexPosition;
+// 顶点法线
+layout(location = 1) in vec3 vertexNormal;
+#ifdef HAS_UV
+// 顶点UV
+layout(location = 2) in vec2 vertexUVIn;
+#endif
+#ifdef INSTANCED
+// 实例模型-视图-裁剪矩阵,占用3到6四个属性位置
+layout(location = 3) in mat4 instanceMVP;
+// 实例模型矩阵,占用7到10四个属性位置
+layout(location = 7) in mat4 instanceModel;
+// 实例法线矩阵,占用11到13三个属性位置
+layout(location = 11) in mat3 instanceNormalMatrix;
+#endif
+#ifdef INDIRECT
+// 物体下标,每实例前进一次,从baseInstance开始读取
+layout(location = 3) in uint objectIndex;
+#endif
+
+// 输出世界坐标系_顶点位置
+out vec3 worldVertexPosition;
+// 输出世界坐标系_顶点法线
+out vec3 worldVertexNormal;
+#ifdef HAS_UV
+// 输出顶点UV
+out vec2 vertexUV;
+#endif
+
+// 视图矩阵、裁剪矩阵
+#include "../include/Frame.glsl"
+
+#ifdef INDIRECT
+#include "../include/Objects.glsl"
+
+// 所有物体的数据,与剔除计算着色器共用
+layout(std430, binding = 0) readonly buffer ObjectBuffer
+{
+    ObjectData objects[];
+};
+#endif
+
+#if !defined(INSTANCED) && !defined(INDIRECT)
+// 模型-视图-裁剪矩阵
+uniform mat4 mvp;
+// 模型矩阵
+uniform mat4 model;
+// 法线矩阵
+uniform mat3 normalMatrix;
+#endif
+
+void main()
+{
+    vec4 position = vec4(vertexPosition, 1.0f);
+#ifdef INSTANCED
+    vec4 worldPosition = instanceModel * position;
+    gl_Position = instanceMVP * position;
+    worldVertexNormal = instanceNormalMatrix * vertexNormal;
+#elif defined(INDIRECT)
+    // 存储缓冲中不保存逐帧的矩阵,世界坐标乘每帧一次的裁剪矩阵乘视图矩阵
+    vec4 worldPosition = objects[objectIndex].model * position;
+    gl_Position = viewProjection * worldPosition;
+    worldVertexNormal = objects[objectIndex].normalMatrix * vertexNormal;
+#else
+    vec4 worldPosition = model * position;
+    gl_Position = mvp * position;
+    worldVertexNormal = normalMatrix * vertexNormal;
+#endif
+    // 输出世界坐标系的顶点位置
+    worldVertexPosition = vec3(worldPosition);
+#ifdef HAS_UV
+    // 输出顶点UV
+    vertexUV = vertexUVIn;
+#endif
+}
@@ -0,0 +1,54 @@
+// 分簇前向渲染的光源列表,需要先包含Frame.glsl与Lighting.glsl
+// C++端由ClusteredLighting每帧生成,簇的划分与UniformBlocks.h中的ClusterData一致
+
+// 分簇参数,std140布局
+layout(std140) uniform ClusterData
+{
+    // x、y方向的块数量,z方向的切片数量,w为光源数量
+    ivec4 clusterGridSize;
+    // x、y为每像素的块数量,z、w把观察空间深度的对数映射到切片
+    vec4 clusterScale;
+};
+
+// 每个簇在光源下标列表中的起点与数量
+uniform usamplerBuffer clusterGrid;
+// 所有簇的光源下标
+uniform usamplerBuffer clusterLightIndices;
+// 光源参数,每个光源为PointLightData的5个vec4
+uniform samplerBuffer clusterLights;
+
+// 读取一个光源,纹素布局与std140的PointLight相同
+PointLight fetchClusterLight(int index)
+{
+    int texel = index * 5;
+    vec4 positionConstant = texelFetch(clusterLights, texel);
+    vec4 attenuation = texelFetch(clusterLights, texel + 1);
+    PointLight pointLight;
+    pointLight.position = positionConstant.xyz;
+    pointLight.constant = positionConstant.w;
+    pointLight.linear = attenuation.x;
+    pointLight.quadratic = attenuation.y;
+    pointLight.ambient = texelFetch(clusterLights, texel + 2).rgb;
+    pointLight.diffuse = texelFetch(clusterLights, texel + 3).rgb;
+    pointLight.specular = texelFetch(clusterLights, texel + 4).rgb;
+    return pointLight;
+}
+
+// 累积片段所在簇的所有点光源,参数与shadePointLight相同,shadow只作用于第一个光源,即LightData中的点光源
+vec3 shadeClusteredLights(vec3 position, vec3 normal, vec3 viewDir,
+                          vec3 ambientColor, vec3 diffuseColor, vec3 specularColor, float shininess, float shadow)
+{
+    float viewDepth = -(view * vec4(position, 1.0f)).z;
+    vec3 clusterPosition = vec3(gl_FragCoord.xy * clusterScale.xy, log(viewDepth) * clusterScale.z + clusterScale.w);
+    ivec3 cluster = clamp(ivec3(floor(clusterPosition)), ivec3(0), clusterGridSize.xyz - 1);
+    int clusterIndex = (cluster.z * clusterGridSize.y + cluster.y) * clusterGridSize.x + cluster.x;
+    uvec2 range = texelFetch(clusterGrid, clusterIndex).xy;
+    vec3 result = vec3(0.0f);
+    for(uint i = 0u; i < range.y; i++)
+    {
+        int lightIndex = int(texelFetch(clusterLightIndices, int(range.x + i)).r);
+        result += shadePointLight(fetchClusterLight(lightIndex), position, normal, viewDir,
+                                  ambientColor, diffuseColor, specularColor, shininess, 0 == lightIndex ? shadow : 1.0f);
+    }
+    return result;
+}
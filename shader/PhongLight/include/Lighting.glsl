@@ -0,0 +1,80 @@
+// 材质,定义MATERIAL_MAPS时漫反射与镜面反射使用贴图,定义EMISSION_MAP时带自发光贴图
+struct Material
+{
+#ifdef MATERIAL_MAPS
+    sampler2D diffuse;
+    sampler2D specular;
+#else
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+#endif
+#ifdef EMISSION_MAP
+    sampler2D emission;
+#endif
+    float shininess;
+};
+
+// 平行光
+struct DirectionLight
+{
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// 点光源,constant/linear/quadratic为衰减系数
+struct PointLight
+{
+    vec3 position;
+    float constant;
+    float linear;
+    float quadratic;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// 光源数据,std140布局,C++端对应UniformBlocks.h中的LightData
+layout(std140) uniform LightData
+{
+    // 点光源
+    PointLight light;
+    // 平行光
+    DirectionLight directionLight;
+};
+
+// 点光源的Phong光照,颜色依次为材质的环境光、漫反射与镜面反射颜色,normal为单位法线,viewDir为指向相机的单位向量
+// shadow为阴影可见度,只作用于漫反射与镜面反射
+vec3 shadePointLight(PointLight pointLight, vec3 position, vec3 normal, vec3 viewDir,
+                     vec3 ambientColor, vec3 diffuseColor, vec3 specularColor, float shininess, float shadow)
+{
+    float distance = length(position - pointLight.position);
+    float attenuation = 1 / (pointLight.constant + pointLight.linear * distance + pointLight.quadratic * distance * distance);
+    vec3 lightDirInv = normalize(pointLight.position - position);
+    vec3 ambient = pointLight.ambient * ambientColor;
+    ambient *= attenuation;
+    float diff = max(dot(lightDirInv, normal), 0.0f);
+    vec3 diffuse = pointLight.diffuse * diff * diffuseColor;
+    diffuse *= attenuation;
+    vec3 lightReflect = normalize(reflect(-lightDirInv, normal));
+    float spec = pow(max(dot(lightReflect, viewDir), 0.0f), shininess);
+    vec3 specular = pointLight.specular * spec * specularColor;
+    specular *= attenuation;
+    return ambient + (diffuse + specular) * shadow;
+}
+
+// 平行光的Phong光照,参数与shadePointLight相同
+vec3 shadeDirectionLight(DirectionLight directionalLight, vec3 normal, vec3 viewDir,
+                         vec3 ambientColor, vec3 diffuseColor, vec3 specularColor, float shininess, float shadow)
+{
+    vec3 lightDirInv = normalize(-directionalLight.direction);
+    vec3 ambient = directionalLight.ambient * ambientColor;
+    float diff = max(dot(lightDirInv, normal), 0.0f);
+    vec3 diffuse = directionalLight.diffuse * diff * diffuseColor;
+    vec3 lightReflect = normalize(reflect(-lightDirInv, normal));
+    float spec = pow(max(dot(lightReflect, viewDir), 0.0f), shininess);
+    vec3 specular = directionalLight.specular * spec * specularColor;
+    return ambient + (diffuse + specular) * shadow;
+}
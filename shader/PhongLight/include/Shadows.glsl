@@ -0,0 +1,55 @@
+// 平行光的级联阴影与点光源的立方体阴影,需要先包含Frame.glsl
+// C++端由ShadowMaps生成,静态物体与动态物体各一层,两层的可见度相乘
+
+// 阴影参数,std140布局,C++端对应UniformBlocks.h中的ShadowData
+layout(std140) uniform ShadowData
+{
+    // 每级把世界坐标变换到阴影贴图的纹理坐标与深度
+    mat4 cascadeMatrices[3];
+    // 每级覆盖到的观察空间深度
+    vec4 cascadeSplits;
+    // 每级一个纹素在世界空间中的大小
+    vec4 cascadeTexelSizes;
+    // xyz为点光源位置,w为影响半径
+    vec4 pointShadowBounds;
+    // 深度偏移与法线偏移
+    vec4 shadowBias;
+};
+
+// 级联阴影,每级为数组的一层
+uniform sampler2DArrayShadow cascadeStaticMap;
+uniform sampler2DArrayShadow cascadeDynamicMap;
+// 点光源阴影,保存到光源的距离除以影响半径
+uniform samplerCubeShadow pointStaticMap;
+uniform samplerCubeShadow pointDynamicMap;
+
+// 平行光的可见度,0为完全在阴影中,最后一级之外没有阴影
+float sampleDirectionShadow(vec3 position, vec3 normal)
+{
+    float viewDepth = -(view * vec4(position, 1.0f)).z;
+    int cascade = viewDepth < cascadeSplits.x ? 0 : (viewDepth < cascadeSplits.y ? 1 : 2);
+    if(viewDepth >= cascadeSplits.z)
+    {
+        return 1.0f;
+    }
+    // 沿法线偏移一个纹素左右,避免倾斜表面的自阴影
+    vec3 offsetPosition = position + normal * cascadeTexelSizes[cascade] * shadowBias.z;
+    vec3 coord = (cascadeMatrices[cascade] * vec4(offsetPosition, 1.0f)).xyz;
+    vec4 shadowCoord = vec4(coord.xy, float(cascade), coord.z - shadowBias.x);
+    return texture(cascadeStaticMap, shadowCoord) * texture(cascadeDynamicMap, shadowCoord);
+}
+
+// 点光源的可见度,影响范围之外没有阴影
+float samplePointShadow(vec3 position, vec3 normal)
+{
+    vec3 toPosition = position - pointShadowBounds.xyz;
+    float distance = length(toPosition);
+    if(distance >= pointShadowBounds.w)
+    {
+        return 1.0f;
+    }
+    // 立方体贴图的纹素随距离变大,法线偏移与距离成正比
+    toPosition += normal * distance * shadowBias.w;
+    vec4 shadowCoord = vec4(toPosition, length(toPosition) / pointShadowBounds.w - shadowBias.y);
+    return texture(pointStaticMap, shadowCoord) * texture(pointDynamicMap, shadowCoord);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+
+// 关键字见Depth.vs.glsl
+#pragma keywords POINT_LIGHT
+
+#ifdef POINT_LIGHT
+in vec3 worldVertexPosition;
+
+// xyz为光源位置,w为影响半径
+uniform vec4 lightPositionRadius;
+#endif
+
+void main()
+{
+#ifdef POINT_LIGHT
+    // 立方体贴图的六个面使用同一种深度,采样时不需要知道落在哪个面
+    gl_FragDepth = length(worldVertexPosition - lightPositionRadius.xyz) / lightPositionRadius.w;
+#endif
+}
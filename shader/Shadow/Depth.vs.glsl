@@ -0,0 +1,28 @@
+#version 330 core
+
+// 阴影贴图的深度阶段,只输出深度
+// 默认: 平行光的一级级联,正交投影,深度由光栅化写入
+// POINT_LIGHT: 点光源立方体贴图的一个面,片段着色器写入到光源的距离
+#pragma keywords POINT_LIGHT
+
+// 顶点位置
+layout(location = 0) in vec3 vertexPosition;
+// 投射阴影物体的模型矩阵,每实例前进一次,占用3到6四个属性位置
+layout(location = 3) in mat4 instanceModel;
+
+// 光源的裁剪矩阵乘视图矩阵
+uniform mat4 lightViewProjection;
+
+#ifdef POINT_LIGHT
+// 输出世界坐标系的顶点位置
+out vec3 worldVertexPosition;
+#endif
+
+void main()
+{
+    vec4 worldPosition = instanceModel * vec4(vertexPosition, 1.0f);
+    gl_Position = lightViewProjection * worldPosition;
+#ifdef POINT_LIGHT
+    worldVertexPosition = vec3(worldPosition);
+#endif
+}
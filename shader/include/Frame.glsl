@@ -0,0 +1,12 @@
+// 每帧共享数据,std140布局,C++端对应UniformBlocks.h中的FrameData
+layout(std140) uniform FrameData
+{
+    // 视图矩阵
+    mat4 view;
+    // 裁剪矩阵
+    mat4 projection;
+    // 裁剪矩阵乘视图矩阵,每帧在CPU上计算一次
+    mat4 viewProjection;
+    // 相机位置
+    vec3 cameraPosition;
+};
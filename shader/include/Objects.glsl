@@ -0,0 +1,16 @@
+// 物体数据,std430布局,C++端对应IndirectRenderer.h中的IndirectObjectData
+struct ObjectData
+{
+    // 模型矩阵
+    mat4 model;
+    // 法线矩阵,模型矩阵左上3x3的逆转置
+    mat3 normalMatrix;
+    // 世界坐标系包围球,xyz为球心,w为半径
+    vec4 boundingSphere;
+    // 网格下标
+    uint meshIndex;
+    // 材质下标,决定绘制命令写入的区域
+    uint materialIndex;
+    uint padding0;
+    uint padding1;
+};
@@ -0,0 +1,128 @@
+#ifndef OPENGLTUTORIAL_BVH_H
+#define OPENGLTUTORIAL_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FrustumCuller.h"
+#include "glm/glm.hpp"
+
+// 射线与最近物体查询结果
+struct BVHHit
+{
+    // 物体下标
+    uint32_t index;
+    // 到物体包围盒的距离,起点在包围盒内时为0
+    float distance;
+};
+
+// 包围体层次结构,按分箱SAH构建二叉树后合并为4叉树,按深度优先顺序线性存储
+// 每个节点以结构数组保存4个子节点的包围盒,一次SSE指令测试4个子节点
+// 子树的物体在排序后的物体数组中连续,完全在视锥体内的子树不再逐个测试
+class BVH
+{
+public:
+    // 节点宽度
+    static const int Width = 4;
+    // 叶子最多物体数量
+    static const uint32_t MaxLeafSize = 8;
+    // SAH分箱数量
+    static const int BinCount = 16;
+    // 超过这个深度后改为中位数切分,保证遍历栈不会溢出
+    static const int MaxSAHDepth = 40;
+    // 遍历栈大小
+    static const int StackSize = 256;
+    // 空子节点
+    static const int32_t EmptyChild = -2;
+    // 叶子子节点
+    static const int32_t LeafChild = -1;
+
+    // 4叉节点,同一分量的4个值连续存放,可以直接作为SSE寄存器读取
+    struct alignas(16) Node
+    {
+        // 4个子节点的包围盒
+        float minX[Width];
+        float minY[Width];
+        float minZ[Width];
+        float maxX[Width];
+        float maxY[Width];
+        float maxZ[Width];
+        // 子节点下标,叶子为LeafChild,空为EmptyChild
+        int32_t children[Width];
+        // 子树在排序后的物体数组中的起点
+        uint32_t first[Width];
+        // 子树的物体数量
+        uint32_t count[Width];
+    };
+
+private:
+    // 节点,根节点为0,父节点下标小于子节点
+    std::vector<Node> nodes;
+    // 按树的顺序排列的物体下标
+    std::vector<uint32_t> primitiveIndices;
+    // 按树的顺序排列的物体包围盒
+    BoxBounds orderedBounds;
+    // 物体下标到树中位置的映射
+    std::vector<uint32_t> primitivePositions;
+    // 树中位置所在的叶子,节点下标乘4加子节点序号
+    std::vector<uint32_t> leafSlots;
+    // 节点的父节点,节点下标乘4加子节点序号,根节点为0xFFFFFFFF
+    std::vector<uint32_t> parentSlots;
+
+    // 构建时的二叉树节点
+    struct BuildNode
+    {
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        uint32_t first;
+        uint32_t count;
+        int32_t left;
+        int32_t right;
+    };
+
+    // 构建时的物体,直接在数组中切分,避免通过下标随机访问
+    struct BuildPrimitive
+    {
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        glm::vec3 centroid;
+        uint32_t index;
+    };
+
+    // 按SAH递归构建二叉树,返回节点下标
+    int32_t buildBinary(std::vector<BuildNode> &buildNodes, std::vector<BuildPrimitive> &primitives,
+                        uint32_t begin, uint32_t end, int depth);
+    // 把二叉树合并为4叉节点,返回节点下标
+    uint32_t collapse(const std::vector<BuildNode> &buildNodes, int32_t buildIndex);
+    // 重新计算节点某个子节点的包围盒
+    void refitSlot(uint32_t nodeIndex, int slot);
+
+public:
+    // 构建,bounds为每个物体的包围盒
+    void build(const BoxBounds &bounds);
+    // 物体移动后保持树结构更新所有包围盒,物体数量必须与构建时相同
+    void refit(const BoxBounds &bounds);
+    // 单个物体移动后更新它到根节点路径上的包围盒
+    void update(uint32_t index, const glm::vec3 &minimum, const glm::vec3 &maximum);
+
+    // 视锥体剔除,visible为可见物体下标,按树的顺序排列,返回可见数量
+    size_t cullFrustum(const Frustum &frustum, std::vector<uint32_t> &visible) const;
+    // 射线检测,返回距离最近的包围盒,direction不需要归一化,距离以direction的长度为单位
+    bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, BVHHit &hit) const;
+    // 查询距离point最近的包围盒
+    bool findNearest(const glm::vec3 &point, float maxDistance, BVHHit &hit) const;
+
+    // 获取节点数量
+    size_t getNodeCount() const
+    {
+        return nodes.size();
+    }
+
+    // 获取物体数量
+    size_t getPrimitiveCount() const
+    {
+        return primitiveIndices.size();
+    }
+};
+
+#endif //OPENGLTUTORIAL_BVH_H
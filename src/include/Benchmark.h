@@ -0,0 +1,129 @@
+#ifndef OPENGLTUTORIAL_BENCHMARK_H
+#define OPENGLTUTORIAL_BENCHMARK_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+class Camera;
+class ClusteredLighting;
+class IndirectRenderer;
+class MipmapGenerator;
+class PointLightList;
+class RenderQueue;
+class RingBuffer;
+class ShadowMaps;
+class ThreadPool;
+struct BoxBounds;
+struct ShadowStatistics;
+struct SphereBounds;
+
+// 绘制方式开关,指向渲染循环按键切换的开关,测量时改变,每项测量结束后恢复
+struct BenchmarkSwitches
+{
+    bool *bUseInstancing;
+    bool *bUseIndirect;
+    bool *bUseCulling;
+    bool *bUseDeferred;
+    bool *bUseClustered;
+    bool *bUseShadows;
+    bool *bUseAnimation;
+    bool *bUseDirectionLight;
+};
+
+// 基准测试使用的场景,由main创建,测量只通过这里的对象与回调改变场景
+struct BenchmarkScene
+{
+    // 绘制方式开关
+    BenchmarkSwitches switches;
+    // 相机与窗口大小,测量使用与渲染循环相同的视锥体
+    Camera *camera;
+    int width;
+    int height;
+    float farPlane;
+
+    // 箱子的模型矩阵与包围体,改变箱子数量后更新
+    const std::vector<glm::mat4> *boxModels;
+    const SphereBounds *boxBounds;
+    const BoxBounds *boxAABBs;
+    // 动态箱子的数量,开启动画时旋转
+    const size_t *dynamicBoxCount;
+    // 渲染队列,测量收集与排序的耗时
+    const RenderQueue *renderQueue;
+    // 间接绘制,不支持时(OpenGL 3.3)为空
+    IndirectRenderer *indirectRenderer;
+    const RingBuffer *frameRing;
+    // 点光源及分簇,启动时的光源数量在测量后恢复
+    const PointLightList *pointLights;
+    ClusteredLighting *clusteredLighting;
+    size_t lightCount;
+    ShadowMaps *shadowMaps;
+    // 渲染线程的线程池,以及准备阶段使用的线程池,测量准备阶段的扩展时临时替换
+    ThreadPool *threadPool;
+    ThreadPool **preparePool;
+    // 流式加载每帧的上传预算
+    GLsizeiptr textureUploadBudget;
+
+    // 改变箱子数量,重新生成箱子并更新层次结构、间接绘制数据与阴影
+    std::function<void(size_t count)> setBoxCount;
+    // 改变光源数量
+    std::function<void(size_t count)> setLightCount;
+    // 按当前开关选择箱子着色器变体
+    std::function<void()> updateBoxShader;
+    // 旋转动态箱子,time为动画时间,以秒为单位
+    std::function<void(float time)> animateBoxes;
+    // 在指定线程池中生成count个箱子的模型矩阵,不改变场景
+    std::function<std::vector<glm::mat4>(size_t count, ThreadPool &pool)> makeBoxModels;
+    // 绘制一帧场景
+    std::function<void()> renderScene;
+    // 剔除箱子,收集绘制包并排序,生成绘制包并返回使用的块数量,与渲染循环中的同名步骤相同
+    std::function<void(const glm::mat4 &viewProjection)> cullBoxes;
+    std::function<void(const glm::mat4 &view, const glm::mat4 &viewProjection)> fillRenderQueue;
+    std::function<size_t(const glm::mat4 &view, const glm::mat4 &viewProjection)> prepareBoxPackets;
+};
+
+// 基准测试,每个子系统一个测量函数,输出"## Benchmark ##"开头的结果
+// 测量之间只通过场景共享状态,每项测量结束后恢复绘制开关与光源数量,箱子数量保持最后一次设置的值
+class Benchmark
+{
+public:
+    // 预热帧数与测量帧数
+    static const int WarmupFrames = 3;
+    static const int MeasureFrames = 20;
+
+    // 依次运行所有测量
+    static void run(BenchmarkScene &scene);
+
+    // 10k个物体逐个设置mat4 Uniform的耗时,按名字查询位置与通过句柄设置比较,以及值未改变时影子副本跳过上传的耗时
+    static void measureUniformSetters();
+    // 三种绘制路径与渲染队列收集排序的耗时,箱子数量从10增长到1M,最后保持1M个箱子,以及环形缓冲的状态
+    static void measureDrawPaths(BenchmarkScene &scene);
+    // 当前所有箱子的视锥体剔除耗时,依次测量各指令集单线程以及最快指令集多线程
+    static void measureCulling(const BenchmarkScene &scene);
+    // 当前所有箱子的层次结构构建、更新与查询耗时,与逐个测试比较并检查结果是否一致
+    static void measureBVH(const BenchmarkScene &scene);
+    // 延迟渲染与分簇前向渲染随光源数量的耗时,以及分簇把光源分配到簇随线程数量的扩展
+    static void measureLighting(BenchmarkScene &scene);
+    // 阴影关闭、全部缓存、动态箱子每帧旋转与每帧重绘所有阴影贴图的耗时
+    static void measureShadows(BenchmarkScene &scene);
+    // 准备阶段随线程数量的扩展,分别测量构建变换、并行生成绘制包与串行合并排序
+    static void measurePrepare(BenchmarkScene &scene);
+    // 加载500张贴图的耗时随解码线程数量的扩展,关闭与打开预解码缓存分别测量
+    static void measureTextureLoading(const BenchmarkScene &scene);
+    // 块压缩编码的耗时,以及从缓存上传RGBA8与从KTX2上传压缩数据的比较
+    static void measureCompression(const BenchmarkScene &scene);
+    // 生成Mipmap链的耗时,以及预解码缓存缺失与命中的耗时
+    static void measureMipmaps(const BenchmarkScene &scene);
+
+private:
+    // 按当前开关选择箱子变体,预热后返回每帧的平均耗时,开启动画时每帧先旋转动态箱子
+    // bInvalidateShadows为true时每帧使所有阴影贴图失效,statistics不为空时返回预热后的阴影统计
+    static double measureRender(BenchmarkScene &scene, bool bInvalidateShadows, ShadowStatistics *statistics);
+    // 同步加载贴图,从预解码缓存读取像素与Mipmap链,缓存失效时解码并在CPU上生成
+    static GLuint loadTexture(const std::string &path, bool bIsSRGB, const MipmapGenerator &generator);
+};
+
+#endif //OPENGLTUTORIAL_BENCHMARK_H
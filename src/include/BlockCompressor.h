@@ -0,0 +1,63 @@
+#ifndef OPENGLTUTORIAL_BLOCKCOMPRESSOR_H
+#define OPENGLTUTORIAL_BLOCKCOMPRESSOR_H
+
+#include <cstddef>
+
+class ThreadPool;
+
+// 块压缩编码,把RGBA8图像按4x4像素一块编码为BC1(不透明)、BC3(带透明度)或BC5(法线的xy两个通道)
+// 端点取块内包围盒并向内收缩,每个像素选最近的调色板颜色,SSE一次处理一个块的16个像素
+// 块行在线程池中并行编码,SSE与标量版本的结果逐字节相同
+class BlockCompressor
+{
+public:
+    // 压缩格式
+    enum Format
+    {
+        BC1,
+        BC3,
+        BC5
+    };
+    // 指令集
+    enum InstructionSet
+    {
+        Scalar,
+        SSE
+    };
+
+private:
+    // 线程池,为空时在调用线程编码
+    ThreadPool *threadPool;
+    // 使用的指令集
+    InstructionSet instructionSet;
+
+public:
+    // 构造函数,默认使用编译支持的最快指令集
+    explicit BlockCompressor(ThreadPool *threadPool = nullptr);
+
+    // 编译支持的最快指令集
+    static InstructionSet getBestInstructionSet();
+    // 指令集名称
+    static const char *getInstructionSetName(InstructionSet instructionSet);
+    // 是否编译了指令集
+    static bool isSupported(InstructionSet instructionSet);
+    // 格式名称
+    static const char *getFormatName(Format format);
+    // 每个块的字节数
+    static size_t getBlockSize(Format format);
+    // width x height的图像压缩后的字节数,不足一块的边缘按一块计算
+    static size_t getCompressedSize(Format format, int width, int height);
+
+    // 设置使用的指令集,不支持时保持不变
+    void setInstructionSet(InstructionSet set);
+    // 设置线程池,为空时在调用线程编码
+    void setThreadPool(ThreadPool *pool)
+    {
+        threadPool = pool;
+    }
+
+    // 编码一张RGBA8图像,output至少能容纳getCompressedSize字节,超出图像的块重复边缘像素
+    void compress(Format format, const unsigned char *pixels, int width, int height, unsigned char *output) const;
+};
+
+#endif //OPENGLTUTORIAL_BLOCKCOMPRESSOR_H
@@ -95,6 +95,11 @@ public:
     {
         return this->cameraPosition;
     }
+    // 获取摄像机的方向
+    glm::vec3 getCameraFront() const
+    {
+        return this->cameraFront;
+    }
 };
 
 #endif //OPENGLTUTORIAL_CAMERA_H
@@ -0,0 +1,89 @@
+#ifndef OPENGLTUTORIAL_CLUSTEREDLIGHTING_H
+#define OPENGLTUTORIAL_CLUSTEREDLIGHTING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "UniformBlocks.h"
+#include "UniformBuffer.h"
+
+class PointLightList;
+class ThreadPool;
+
+// 分簇前向渲染,把视锥体划分为屏幕上的块乘以按深度对数划分的切片,每帧在CPU上为每个簇生成影响它的光源列表
+// 光源列表通过纹理缓冲上传,片段着色器只遍历所在簇的光源,保留前向渲染的材质模型
+// 纹理缓冲与uniform缓冲在OpenGL 3.3中可用,与其他GL对象一样不在析构时删除
+class ClusteredLighting
+{
+public:
+    // 屏幕x、y方向的块数量与深度方向的切片数量
+    static const int TilesX = 16;
+    static const int TilesY = 9;
+    static const int Slices = 24;
+    static const int ClusterCount = TilesX * TilesY * Slices;
+    // 纹理缓冲数量,依次为簇的列表范围、光源下标与光源参数
+    static const int TextureCount = 3;
+
+private:
+    // 一个光源覆盖的簇范围,包含两端,minZ大于maxZ时不影响任何簇
+    struct ClusterRange
+    {
+        int16_t minX, maxX;
+        int16_t minY, maxY;
+        int16_t minZ, maxZ;
+    };
+    // 在线程池中并行处理,没有线程池时在调用线程处理
+    template <typename Function>
+    void parallelFor(size_t count, size_t minChunkSize, const Function &function);
+
+    // 线程池,为空时在调用线程分配
+    ThreadPool *threadPool;
+    // 每个光源覆盖的簇范围
+    std::vector<ClusterRange> ranges;
+    // 每个切片内各簇的光源数量与按簇排列的光源下标,切片之间互不影响,可以并行生成
+    std::vector<std::vector<uint32_t>> sliceCounts;
+    std::vector<std::vector<uint32_t>> sliceIndices;
+    // 每个切片在光源下标列表中的起点
+    std::vector<uint32_t> sliceOffsets;
+    // 每个簇在光源下标列表中的起点与数量
+    std::vector<glm::uvec2> clusters;
+    // 所有簇的光源下标
+    std::vector<uint32_t> lightIndices;
+
+    // 纹理缓冲及其数据缓冲
+    GLuint buffers[TextureCount];
+    GLuint textures[TextureCount];
+    // 分簇参数
+    UniformBuffer clusterUniformBuffer;
+    ClusterData clusterData;
+
+public:
+    // 构造函数,创建纹理缓冲,threadPool为空时在调用线程分配
+    explicit ClusteredLighting(ThreadPool *threadPool);
+    ClusteredLighting(const ClusteredLighting &) = delete;
+    ClusteredLighting &operator=(const ClusteredLighting &) = delete;
+
+    // 设置线程池
+    void setThreadPool(ThreadPool *pool)
+    {
+        threadPool = pool;
+    }
+    // 上传光源参数,光源改变时调用
+    void setLights(const PointLightList &lights);
+    // 把光源分配到簇,只在CPU上计算,fovY为弧度
+    void assign(const PointLightList &lights, const glm::mat4 &view, float fovY, float aspect, float nearPlane, float farPlane);
+    // 上传分配结果与分簇参数,framebufferWidth与framebufferHeight用于把像素映射到块
+    void upload(int framebufferWidth, int framebufferHeight);
+    // 把三个纹理缓冲绑定到firstUnit开始的纹理单元
+    void bind(GLuint firstUnit) const;
+
+    // 获取所有簇的光源下标总数
+    size_t getIndexCount() const
+    {
+        return lightIndices.size();
+    }
+};
+
+#endif //OPENGLTUTORIAL_CLUSTEREDLIGHTING_H
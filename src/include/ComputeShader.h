@@ -0,0 +1,46 @@
+#ifndef OPENGLTUTORIAL_COMPUTESHADER_H
+#define OPENGLTUTORIAL_COMPUTESHADER_H
+
+#include <string>
+#include <vector>
+#include "glad/glad.h"
+
+// 计算着色器程序,源码与顶点、片段着色器一样通过ShaderSource读取,支持#include与宏
+// 需要OpenGL 4.3,与其他GL对象一样不在析构时删除
+class ComputeShader
+{
+private:
+    // 程序id
+    GLuint id;
+    // 着色器路径,用于输出日志
+    std::string path;
+    // 是否链接成功
+    bool bIsValid;
+
+public:
+    // 构造函数,读取并编译计算着色器,defines为注入的宏
+    explicit ComputeShader(const std::string &path, const std::vector<std::string> &defines = std::vector<std::string>());
+    ComputeShader(const ComputeShader &) = delete;
+    ComputeShader &operator=(const ComputeShader &) = delete;
+
+    // 使用程序
+    void use() const;
+    // 查询Uniform位置,不存在时为-1
+    GLint uniformLocation(const std::string &name) const;
+    // 使用程序并按工作组数量分派
+    void dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1) const;
+
+    // 获取程序id
+    GLuint getId() const
+    {
+        return id;
+    }
+
+    // 是否链接成功
+    bool isValid() const
+    {
+        return bIsValid;
+    }
+};
+
+#endif //OPENGLTUTORIAL_COMPUTESHADER_H
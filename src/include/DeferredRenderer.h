@@ -0,0 +1,114 @@
+#ifndef OPENGLTUTORIAL_DEFERREDRENDERER_H
+#define OPENGLTUTORIAL_DEFERREDRENDERER_H
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "Mesh.h"
+#include "Shader.h"
+#include "ShaderPermutation.h"
+
+class PointLightList;
+class ShaderLibrary;
+class ShaderWatcher;
+
+// 延迟渲染,几何阶段把法线、漫反射与镜面反射颜色写入几何缓冲,位置由深度重建
+// 光照阶段每个点光源实例化绘制一个包围其影响范围的体积,以加法混合累积到光照缓冲,片段只计算覆盖它的光源
+// 光照缓冲与几何缓冲共用深度,前向绘制的物体(例如光源物体)可以在光照后直接画入,最后复制到默认帧缓冲
+// 与其他GL对象一样不在析构时删除
+class DeferredRenderer
+{
+public:
+    // 颜色附件,顺序与Phong.fs.glsl中GBUFFER的输出位置一致
+    enum Attachment
+    {
+        // 法线,w为镜面反射指数,RGBA16F
+        Normal,
+        // 漫反射颜色,RGBA8
+        Diffuse,
+        // 镜面反射颜色,RGBA8
+        Specular,
+        // 光照累积,RGBA16F,几何阶段写入自发光
+        Lighting,
+        AttachmentCount
+    };
+
+private:
+    // 几何缓冲的帧缓冲对象
+    GLuint framebuffer;
+    // 颜色附件纹理
+    GLuint textures[AttachmentCount];
+    // 深度模板纹理,光照阶段用于重建位置与限制光源体积
+    GLuint depthTexture;
+    // 几何缓冲大小
+    GLsizei width;
+    GLsizei height;
+
+    // 光源体积,外接单位球的低面数多面体
+    Mesh volumeMesh;
+    // 光源体积VAO,另外从光源缓冲读取每实例的光源参数
+    GLuint volumeVertexArray;
+    // 光源参数缓冲,PointLightData数组
+    GLuint lightBuffer;
+    // 光源影响范围缓冲,vec4数组
+    GLuint boundsBuffer;
+    // 光源数量
+    GLsizei lightCount;
+    // 全屏三角形使用的空VAO
+    GLuint emptyVertexArray;
+
+    // 光照程序的一个变体
+    struct LightingProgram
+    {
+        Shader *shader;
+        UniformHandle inverseViewProjectionHandle;
+    };
+    // 光照程序,按[是否为平行光][是否带阴影]分为四个变体,带阴影的变体第一次使用时编译
+    ShaderPermutation lightingShaders;
+    LightingProgram programs[2][2];
+    // 阴影贴图的第一个纹理单元
+    GLuint shadowTextureUnit;
+
+public:
+    // 构造函数,创建width x height的几何缓冲与光源体积
+    DeferredRenderer(GLsizei width, GLsizei height);
+    DeferredRenderer(const DeferredRenderer &) = delete;
+    DeferredRenderer &operator=(const DeferredRenderer &) = delete;
+
+    // 设置热重载监视器
+    void setWatcher(ShaderWatcher *shaderWatcher);
+    // 把不带阴影的两个光照变体提交到着色器库,与其他启动时的程序一起编译,绘制前需等待着色器库构建完成
+    void prebuildShaders(ShaderLibrary &library);
+    // 改变几何缓冲大小,大小未改变时不做任何事
+    void resize(GLsizei width, GLsizei height);
+    // 上传光源,光源改变时调用
+    void setLights(const PointLightList &lights);
+    // 设置阴影贴图绑定的第一个纹理单元,与ShadowMaps::bind一致
+    void setShadowTextureUnit(GLuint firstUnit)
+    {
+        shadowTextureUnit = firstUnit;
+    }
+
+    // 开始几何阶段,绑定几何缓冲并清除,之后用GBUFFER变体绘制不透明物体
+    void beginGeometryPass();
+    // 光照阶段,累积所有点光源,bUseDirectionLight为true时另外累积平行光
+    // bUseShadows为true时平行光与第一个点光源采样阴影贴图,阴影贴图需已绑定
+    void drawLights(const glm::mat4 &viewProjection, bool bUseDirectionLight, bool bUseShadows);
+    // 开始前向阶段,之后绘制的物体写入光照缓冲,与几何阶段的深度比较
+    void beginForwardPass();
+    // 把光照缓冲复制到默认帧缓冲,并重新绑定默认帧缓冲
+    void present();
+
+    // 获取光源数量
+    GLsizei getLightCount() const
+    {
+        return lightCount;
+    }
+
+private:
+    // 按当前大小创建附件纹理
+    void createAttachments();
+    // 获取光照程序,第一次使用时编译并设置纹理单元
+    LightingProgram &getProgram(bool bIsDirectionLight, bool bHasShadows);
+};
+
+#endif //OPENGLTUTORIAL_DEFERREDRENDERER_H
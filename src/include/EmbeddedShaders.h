@@ -0,0 +1,46 @@
+#ifndef OPENGLTUTORIAL_EMBEDDEDSHADERS_H
+#define OPENGLTUTORIAL_EMBEDDEDSHADERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 嵌入可执行文件的着色器文件,长度与哈希在构建时计算
+struct EmbeddedShader
+{
+    // 相对于shader目录的路径,例如"PhongLight/04/Light.vs.glsl"
+    const char *path;
+    // 文件内容
+    const char *data;
+    // 文件长度
+    size_t length;
+    // 文件内容的FNV-1a 64位哈希,与ShaderCache::hash一致
+    uint64_t hash;
+};
+
+// 嵌入的着色器表,由构建时的ShaderEmbed工具根据shader目录生成
+class EmbeddedShaders
+{
+private:
+    // 按路径排序的着色器表,定义在生成的EmbeddedShaders.cpp中
+    static const EmbeddedShader *const entries;
+    // 着色器数量
+    static const size_t count;
+
+public:
+    // 按路径查找,路径需要是规范化的相对路径,不存在时返回nullptr
+    static const EmbeddedShader *find(const std::string &path);
+
+    // 获取着色器数量
+    static size_t getCount()
+    {
+        return count;
+    }
+    // 获取着色器
+    static const EmbeddedShader &get(size_t index)
+    {
+        return entries[index];
+    }
+};
+
+#endif //OPENGLTUTORIAL_EMBEDDEDSHADERS_H
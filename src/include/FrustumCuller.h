@@ -0,0 +1,123 @@
+#ifndef OPENGLTUTORIAL_FRUSTUMCULLER_H
+#define OPENGLTUTORIAL_FRUSTUMCULLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+class ThreadPool;
+
+// 视锥体,6个平面的法线指向内部,xyz为单位法线,w为到原点的有向距离
+struct Frustum
+{
+    // 左、右、下、上、近、远平面
+    glm::vec4 planes[6];
+
+    // 从裁剪矩阵乘视图矩阵中提取平面
+    static Frustum fromMatrix(const glm::mat4 &viewProjection);
+};
+
+// 包围球,结构数组存储,便于一次读取多个物体的同一分量
+struct SphereBounds
+{
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+
+    // 获取包围球数量
+    size_t size() const
+    {
+        return radius.size();
+    }
+
+    // 设置包围球数量
+    void resize(size_t count);
+    // 设置第index个包围球
+    void set(size_t index, const glm::vec3 &center, float sphereRadius);
+};
+
+// 轴对齐包围盒,以中心与半长存储,结构数组存储
+struct BoxBounds
+{
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+
+    // 获取包围盒数量
+    size_t size() const
+    {
+        return extentX.size();
+    }
+
+    // 设置包围盒数量
+    void resize(size_t count);
+    // 设置第index个包围盒
+    void set(size_t index, const glm::vec3 &minimum, const glm::vec3 &maximum);
+};
+
+// 视锥体剔除,一条SIMD指令测试4个(SSE)或8个(AVX2)物体,输出紧凑的可见物体下标列表
+// 指令集在编译时确定,AVX2需要开启OPENGLTUTORIAL_ENABLE_AVX2,不支持SIMD时使用标量版本
+class FrustumCuller
+{
+public:
+    // 指令集
+    enum InstructionSet
+    {
+        Scalar,
+        SSE,
+        AVX2
+    };
+
+    // 并行剔除时每块的最少物体数量
+    static const size_t MinChunkSize = 16384;
+
+private:
+    // 线程池,为空时在调用线程剔除
+    ThreadPool *threadPool;
+    // 使用的指令集
+    InstructionSet instructionSet;
+    // 并行剔除时每块的可见物体数量,预热后不再分配
+    std::vector<size_t> chunkCounts;
+
+    // 在线程池中剔除,每块的结果先写在块的起点,再依次向前移动,cullRange(begin, end, output)返回可见数量
+    template<typename CullRange>
+    size_t cullParallel(size_t count, std::vector<uint32_t> &visible, const CullRange &cullRange);
+
+public:
+    // 构造函数,默认使用编译支持的最快指令集
+    explicit FrustumCuller(ThreadPool *threadPool = nullptr);
+
+    // 编译支持的最快指令集
+    static InstructionSet getBestInstructionSet();
+    // 指令集名称
+    static const char *getInstructionSetName(InstructionSet instructionSet);
+    // 是否编译了指令集
+    static bool isSupported(InstructionSet instructionSet);
+
+    // 设置使用的指令集,不支持时保持不变
+    void setInstructionSet(InstructionSet set);
+    // 设置线程池,为空时在调用线程剔除
+    void setThreadPool(ThreadPool *pool)
+    {
+        threadPool = pool;
+    }
+
+    // 剔除包围球,visible为升序的可见下标,返回可见数量
+    size_t cull(const Frustum &frustum, const SphereBounds &bounds, std::vector<uint32_t> &visible);
+    // 剔除包围盒,visible为升序的可见下标,返回可见数量
+    size_t cull(const Frustum &frustum, const BoxBounds &bounds, std::vector<uint32_t> &visible);
+
+    // 剔除[begin, end)范围内的包围球,可见下标写入visible,visible至少能容纳end-begin个下标
+    static size_t cullSpheres(const Frustum &frustum, const SphereBounds &bounds, size_t begin, size_t end,
+                              uint32_t *visible, InstructionSet set);
+    // 剔除[begin, end)范围内的包围盒,可见下标写入visible,visible至少能容纳end-begin个下标
+    static size_t cullBoxes(const Frustum &frustum, const BoxBounds &bounds, size_t begin, size_t end,
+                            uint32_t *visible, InstructionSet set);
+};
+
+#endif //OPENGLTUTORIAL_FRUSTUMCULLER_H
@@ -0,0 +1,114 @@
+#ifndef OPENGLTUTORIAL_GLEXTENSION_H
+#define OPENGLTUTORIAL_GLEXTENSION_H
+
+#include <string>
+#include "glad/glad.h"
+
+// glad只生成了OpenGL 3.3的函数,高版本及扩展函数在这里按glad的方式声明并在运行时加载
+
+// ARB_get_program_binary / OpenGL 4.1
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYEXTPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYEXTPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIEXTPROC)(GLuint program, GLenum pname, GLint value);
+extern PFNGLGETPROGRAMBINARYEXTPROC glext_glGetProgramBinary;
+#define glGetProgramBinary glext_glGetProgramBinary
+extern PFNGLPROGRAMBINARYEXTPROC glext_glProgramBinary;
+#define glProgramBinary glext_glProgramBinary
+extern PFNGLPROGRAMPARAMETERIEXTPROC glext_glProgramParameteri;
+#define glProgramParameteri glext_glProgramParameteri
+
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)(GLuint count);
+extern PFNGLMAXSHADERCOMPILERTHREADSEXTPROC glext_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glext_glMaxShaderCompilerThreadsKHR
+
+// OpenGL 4.3计算着色器、着色器存储缓冲与多重间接绘制
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEEXTPROC)(GLuint numGroupsX, GLuint numGroupsY, GLuint numGroupsZ);
+typedef void (APIENTRYP PFNGLMEMORYBARRIEREXTPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei drawCount, GLsizei stride);
+typedef void (APIENTRYP PFNGLCLEARBUFFERDATAEXTPROC)(GLenum target, GLenum internalFormat, GLenum format, GLenum type, const void *data);
+extern PFNGLDISPATCHCOMPUTEEXTPROC glext_glDispatchCompute;
+#define glDispatchCompute glext_glDispatchCompute
+extern PFNGLMEMORYBARRIEREXTPROC glext_glMemoryBarrier;
+#define glMemoryBarrier glext_glMemoryBarrier
+extern PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC glext_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glext_glMultiDrawElementsIndirect
+extern PFNGLCLEARBUFFERDATAEXTPROC glext_glClearBufferData;
+#define glClearBufferData glext_glClearBufferData
+
+// ARB_indirect_parameters / OpenGL 4.6,绘制数量从缓冲读取
+#ifndef GL_PARAMETER_BUFFER_ARB
+#define GL_PARAMETER_BUFFER_ARB 0x80EE
+#endif
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTEXTPROC)(GLenum mode, GLenum type, const void *indirect, GLintptr drawCount, GLsizei maxDrawCount, GLsizei stride);
+extern PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTEXTPROC glext_glMultiDrawElementsIndirectCountARB;
+#define glMultiDrawElementsIndirectCountARB glext_glMultiDrawElementsIndirectCountARB
+
+// ARB_buffer_storage / OpenGL 4.4,不可变存储与持久映射
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEEXTPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEEXTPROC glext_glBufferStorage;
+#define glBufferStorage glext_glBufferStorage
+
+// EXT_texture_compression_s3tc,BC1与BC3,BC5(RGTC)在OpenGL 3.0中已是核心功能
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// OpenGL扩展工具类
+class GLExtension
+{
+public:
+    // 是否支持程序二进制
+    static bool bProgramBinary;
+    // 是否支持并行编译着色器,支持时可以查询GL_COMPLETION_STATUS_KHR
+    static bool bParallelShaderCompile;
+    // 是否支持计算着色器、着色器存储缓冲与多重间接绘制,需要OpenGL 4.3
+    // 着色器中通过ARB_shader_storage_buffer_object与ARB_shading_language_420pack使用存储缓冲
+    static bool bMultiDrawIndirect;
+    // 是否支持从缓冲读取多重间接绘制的数量
+    static bool bIndirectParameters;
+    // 是否支持不可变存储,支持时可以持久映射缓冲
+    static bool bBufferStorage;
+    // 是否支持S3TC压缩贴图
+    static bool bTextureCompressionS3TC;
+    // 是否限制为OpenGL 3.3,需要在load之前设置,之后hasVersion对高于3.3的版本返回false
+    static bool bIsLimitedTo33;
+
+public:
+    // 加载扩展函数,需要在gladLoadGLLoader之后调用
+    static void load(GLADloadproc loader);
+    // 判断当前上下文是否支持某个扩展
+    static bool hasExtension(const std::string &name);
+    // 判断当前上下文版本是否不低于major.minor
+    static bool hasVersion(int major, int minor);
+};
+
+#endif //OPENGLTUTORIAL_GLEXTENSION_H
@@ -0,0 +1,76 @@
+#ifndef OPENGLTUTORIAL_GLSTATECACHE_H
+#define OPENGLTUTORIAL_GLSTATECACHE_H
+
+#include "glad/glad.h"
+
+// 每帧GL状态调用统计
+struct GLStateCounters
+{
+    // 实际调用GL的次数
+    unsigned int issued;
+    // 状态未改变而跳过的次数
+    unsigned int elided;
+    // 实际上传Uniform的次数,包括uniform缓冲的更新
+    unsigned int uniformsIssued;
+    // 值未改变而跳过的Uniform上传次数
+    unsigned int uniformsSkipped;
+};
+
+// GL状态缓存,记录当前上下文绑定的对象与开关状态,跳过不会改变状态的调用
+// 所有状态修改都需要经过这里,直接调用GL修改状态后需要调用invalidate
+class GLStateCache
+{
+public:
+    // 使用着色器程序
+    static void useProgram(GLuint program);
+    // 绑定顶点数组对象,元素缓冲绑定属于VAO状态,切换后重新记录
+    static void bindVertexArray(GLuint vertexArray);
+    // 激活纹理单元,unit为GL_TEXTURE0+n
+    static void activeTexture(GLenum unit);
+    // 绑定纹理到纹理单元,unit为单元序号
+    static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+    // 绑定缓冲对象
+    static void bindBuffer(GLenum target, GLuint buffer);
+    // 绑定缓冲对象到索引绑定点,同时会改变target的通用绑定
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    // 绑定缓冲对象的一段到索引绑定点
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    // 绑定帧缓冲
+    static void bindFramebuffer(GLenum target, GLuint framebuffer);
+
+    // 开启或关闭功能,例如GL_DEPTH_TEST、GL_BLEND、GL_CULL_FACE
+    static void setEnabled(GLenum capability, bool bIsEnabled);
+    // 设置深度比较函数
+    static void depthFunc(GLenum func);
+    // 设置深度写入
+    static void depthMask(GLboolean bIsWritable);
+    // 设置多边形模式,只支持GL_FRONT_AND_BACK
+    static void polygonMode(GLenum mode);
+    // 设置混合函数
+    static void blendFunc(GLenum source, GLenum destination);
+    // 设置剔除面
+    static void cullFace(GLenum face);
+
+    // 删除对象,同时清除缓存中的绑定,避免复用的对象名被误判为已绑定
+    static void deleteProgram(GLuint program);
+    static void deleteVertexArray(GLuint vertexArray);
+    static void deleteBuffer(GLuint buffer);
+    static void deleteTexture(GLuint texture);
+    static void deleteFramebuffer(GLuint framebuffer);
+
+    // 获取当前使用的着色器程序
+    static GLuint getProgram();
+
+    // 把所有缓存状态置为未知,下一次调用一定会执行
+    static void invalidate();
+    // 记录一次Uniform上传,bIsIssued为false表示值未改变而跳过
+    static void countUniformUpload(bool bIsIssued);
+    // 开始新的一帧,保存上一帧的统计并清零
+    static void beginFrame();
+    // 获取上一帧的统计
+    static GLStateCounters getFrameCounters();
+    // 获取当前帧到目前为止的统计
+    static GLStateCounters getCurrentCounters();
+};
+
+#endif //OPENGLTUTORIAL_GLSTATECACHE_H
@@ -0,0 +1,115 @@
+#ifndef OPENGLTUTORIAL_INDIRECTRENDERER_H
+#define OPENGLTUTORIAL_INDIRECTRENDERER_H
+
+#include <vector>
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "ComputeShader.h"
+
+struct Frustum;
+
+// 物体数据,std430布局,与shader/include/Objects.glsl中的ObjectData一致
+struct IndirectObjectData
+{
+    // 模型矩阵
+    glm::mat4 model;
+    // 法线矩阵,std430中mat3的每列按vec4对齐
+    glm::vec4 normalMatrix[3];
+    // 世界坐标系包围球,xyz为球心,w为半径
+    glm::vec4 boundingSphere;
+    // 网格下标
+    GLuint meshIndex;
+    // 材质下标,决定绘制命令写入的区域
+    GLuint materialIndex;
+    GLuint padding[2];
+};
+static_assert(sizeof(IndirectObjectData) == 144, "IndirectObjectData must match the std430 ObjectData layout");
+
+// 网格在共享顶点缓冲与元素缓冲中的范围
+struct IndirectMeshRange
+{
+    // 索引数量
+    GLuint count;
+    // 第一个索引
+    GLuint firstIndex;
+    // 加到索引上的顶点偏移
+    GLint baseVertex;
+    GLuint padding;
+};
+static_assert(sizeof(IndirectMeshRange) == 16, "IndirectMeshRange must match the std430 MeshRange layout");
+
+// glMultiDrawElementsIndirect读取的绘制命令
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must be tightly packed");
+
+// GPU驱动的绘制,物体数据常驻存储缓冲,计算着色器剔除后为每个可见物体写入一条间接绘制命令
+// 命令按材质分区,每个材质一次glMultiDrawElementsIndirect,CPU耗时与物体数量无关
+// 需要OpenGL 4.3,与其他GL对象一样不在析构时删除
+class IndirectRenderer
+{
+private:
+    // 剔除计算着色器
+    ComputeShader cullShader;
+    GLint frustumPlanesLocation;
+    GLint objectCountLocation;
+
+    // 物体数据缓冲
+    GLuint objectBuffer;
+    // 网格范围缓冲
+    GLuint meshBuffer;
+    // 绘制命令缓冲
+    GLuint commandBuffer;
+    // 每个材质的可见命令数量
+    GLuint drawCountBuffer;
+    // 每个材质的命令区域起点
+    GLuint commandOffsetBuffer;
+    // 物体下标0到N-1,作为每实例前进一次的属性,baseInstance选中对应的物体
+    GLuint objectIndexBuffer;
+
+    // 物体数量
+    GLuint objectCount;
+    // 物体下标缓冲的容量
+    GLuint objectIndexCapacity;
+    // 每个材质的命令区域起点,最后一项为命令总数
+    std::vector<GLuint> commandOffsets;
+
+public:
+    // 构造函数,编译剔除着色器并创建缓冲
+    IndirectRenderer();
+    IndirectRenderer(const IndirectRenderer &) = delete;
+    IndirectRenderer &operator=(const IndirectRenderer &) = delete;
+
+    // 上传网格范围,物体通过meshIndex引用
+    void setMeshes(const IndirectMeshRange *meshes, GLuint meshCount);
+    // 上传物体数据,materialIndex需小于materialCount,按材质划分命令区域
+    void setObjects(const IndirectObjectData *objects, GLuint count, GLuint materialCount);
+    // 更新从first开始的count个物体,材质下标不能改变
+    void updateObjects(GLuint first, const IndirectObjectData *objects, GLuint count);
+    // 在当前绑定的VAO中设置物体下标属性,着色器中为uint
+    void attach(GLuint location) const;
+
+    // 在GPU上剔除并生成本帧的绘制命令
+    void cull(const Frustum &frustum);
+    // 绘制一个材质的可见物体,vertexArray为包含物体下标属性的VAO
+    void draw(GLuint vertexArray, GLenum indexType, GLuint material) const;
+    // 读回一个材质的可见物体数量,会等待GPU完成剔除,只用于统计
+    GLuint readDrawCount(GLuint material) const;
+
+    // 获取物体数量
+    GLuint getObjectCount() const
+    {
+        return objectCount;
+    }
+
+    // 当前上下文是否支持GPU驱动的绘制
+    static bool isSupported();
+};
+
+#endif //OPENGLTUTORIAL_INDIRECTRENDERER_H
@@ -0,0 +1,55 @@
+#ifndef OPENGLTUTORIAL_INSTANCEBUFFER_H
+#define OPENGLTUTORIAL_INSTANCEBUFFER_H
+
+#include "glad/glad.h"
+#include "TransformMath.h"
+
+class RingBuffer;
+
+// 实例缓冲,每帧把每个实例的变换写入环形缓冲,作为每实例前进一次的顶点属性读取
+// 数据在环形缓冲中的位置每帧不同,写完后重新设置VAO中的属性指针
+class InstanceBuffer
+{
+private:
+    // 每帧数据所在的环形缓冲
+    RingBuffer &ring;
+    // 读取实例属性的VAO
+    GLuint vertexArray;
+    // 实例属性的第一个位置
+    GLuint location;
+    // 本帧写入的实例变换在环形缓冲中的偏移
+    GLintptr offset;
+    // 实例数量
+    GLsizei count;
+
+public:
+    // 每个实例占用的属性位置数量
+    static const GLuint AttributeCount = 11;
+
+    // 构造函数,实例数据从ring中分配
+    explicit InstanceBuffer(RingBuffer &ring);
+    InstanceBuffer(const InstanceBuffer &) = delete;
+    InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+
+    // 为本帧分配instanceCount个实例变换,返回写入地址,写完后调用unmap,空间不足时返回nullptr且实例数量为0
+    InstanceTransform *map(GLsizei instanceCount);
+    // 结束写入,上传数据并把VAO中的属性指向本帧的数据
+    void unmap();
+    // 上传实例变换,等同于map后拷贝再unmap
+    void update(const InstanceTransform *instances, GLsizei instanceCount);
+    // 在vertexArray中设置实例属性,占用location开始的AttributeCount个位置
+    // 依次为模型-视图-裁剪矩阵(4个)、模型矩阵(4个)与法线矩阵(3个)
+    void attach(GLuint vertexArray, GLuint location);
+
+    // 获取实例数量
+    GLsizei getCount() const
+    {
+        return count;
+    }
+
+private:
+    // 在当前绑定的VAO中把属性指向offset处的数据
+    void setPointers() const;
+};
+
+#endif //OPENGLTUTORIAL_INSTANCEBUFFER_H
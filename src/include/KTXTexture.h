@@ -0,0 +1,63 @@
+#ifndef OPENGLTUTORIAL_KTXTEXTURE_H
+#define OPENGLTUTORIAL_KTXTEXTURE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "BlockCompressor.h"
+#include "MappedFile.h"
+
+// KTX2布局的块压缩贴图文件,只包含一张二维贴图及其Mipmap链,不使用超级压缩
+// 文件头、数据格式描述符与各级的位置按KTX2规范写入,各级数据从最小的一级开始存放
+// 读取时映射整个文件,各级数据直接指向映射内存,可以不经拷贝地传给glCompressedTexImage2D
+class KTXTexture
+{
+public:
+    // 一级Mipmap
+    struct Level
+    {
+        const unsigned char *data;
+        size_t size;
+        int width;
+        int height;
+    };
+
+private:
+    // 映射的文件
+    MappedFile file;
+    // 压缩格式
+    BlockCompressor::Format format;
+    // 各级Mipmap,第0级最大
+    std::vector<Level> levels;
+    // 文件是否有效
+    bool bIsValid;
+
+public:
+    // 构造函数,映射并检查文件,无效时isValid返回false
+    explicit KTXTexture(const std::string &path);
+    KTXTexture(const KTXTexture &) = delete;
+    KTXTexture &operator=(const KTXTexture &) = delete;
+
+    // 文件是否有效
+    bool isValid() const
+    {
+        return bIsValid;
+    }
+    // 获取压缩格式
+    BlockCompressor::Format getFormat() const
+    {
+        return format;
+    }
+    // 获取各级Mipmap
+    const std::vector<Level> &getLevels() const
+    {
+        return levels;
+    }
+
+    // 写入文件,levels为从第0级开始的压缩数据,各级尺寸由width与height逐级减半得到
+    // bIsSRGB为true时按颜色贴图写入sRGB格式与传输函数
+    static bool write(const std::string &path, BlockCompressor::Format format, bool bIsSRGB, int width, int height,
+                      const std::vector<std::vector<unsigned char>> &levels);
+};
+
+#endif //OPENGLTUTORIAL_KTXTEXTURE_H
@@ -0,0 +1,58 @@
+#ifndef OPENGLTUTORIAL_MAPPEDFILE_H
+#define OPENGLTUTORIAL_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 只读内存映射文件,映射期间数据指针一直有效
+class MappedFile
+{
+private:
+    // 映射的数据
+    const char *data;
+    // 数据长度
+    size_t size;
+    // 复制模式下的文件内容
+    std::vector<char> copy;
+#ifdef _WIN32
+    // Windows文件句柄
+    void *fileHandle;
+    // Windows映射句柄
+    void *mappingHandle;
+#else
+    // POSIX文件描述符
+    int fileDescriptor;
+#endif
+
+public:
+    // 构造函数,映射失败时isOpen返回false
+    // bIsCopy为true时把文件读入内存而不映射,用于可能被其他进程截断的文件,避免访问映射时出错
+    explicit MappedFile(const std::string &path, bool bIsCopy = false);
+    // 析构函数,解除映射
+    ~MappedFile();
+
+    // 禁止拷贝,映射只能有一个所有者
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // 是否映射成功,空文件也视为成功
+    bool isOpen() const;
+
+    // 获取映射数据
+    const char *getData() const
+    {
+        return data;
+    }
+    // 获取数据长度
+    size_t getSize() const
+    {
+        return size;
+    }
+
+private:
+    // 关闭映射
+    void close();
+};
+
+#endif //OPENGLTUTORIAL_MAPPEDFILE_H
@@ -0,0 +1,79 @@
+#ifndef OPENGLTUTORIAL_MESH_H
+#define OPENGLTUTORIAL_MESH_H
+
+#include "glad/glad.h"
+#include "MeshBuilder.h"
+#include <vector>
+
+// 顶点属性布局,offset与components以float为单位
+struct VertexAttribute
+{
+    // 属性位置
+    GLuint location;
+    // 分量数量
+    GLint components;
+    // 在顶点中的偏移
+    size_t offset;
+};
+
+// 索引网格,持有顶点缓冲、元素缓冲与默认VAO
+// 与UniformBuffer一样生命周期与上下文相同,不在析构时删除GL对象
+class Mesh
+{
+private:
+    // 顶点缓冲id
+    GLuint vertexBuffer;
+    // 元素缓冲id
+    GLuint elementBuffer;
+    // 默认VAO
+    GLuint vertexArray;
+    // 索引数量
+    GLsizei indexCount;
+    // 索引类型,顶点少于65536个时使用16位索引
+    GLenum indexType;
+    // 顶点属性布局
+    std::vector<VertexAttribute> attributes;
+    // 顶点大小,以字节为单位
+    GLsizei vertexSize;
+    // 优化后的统计
+    MeshStatistics statistics;
+
+public:
+    // 构造函数,上传MeshBuilder构建的网格并创建默认VAO
+    Mesh(const MeshData &data, const std::vector<VertexAttribute> &attributes);
+    Mesh(const Mesh &) = delete;
+    Mesh &operator=(const Mesh &) = delete;
+
+    // 创建新的VAO并设置网格的顶点属性与元素缓冲,返回时VAO保持绑定,便于追加实例属性
+    GLuint createVertexArray() const;
+    // 使用默认VAO绘制
+    void draw() const;
+    // 使用指定VAO实例化绘制
+    void drawInstanced(GLuint instancedVertexArray, GLsizei instanceCount) const;
+
+    // 获取默认VAO
+    GLuint getVertexArray() const
+    {
+        return vertexArray;
+    }
+
+    // 获取索引数量
+    GLsizei getIndexCount() const
+    {
+        return indexCount;
+    }
+
+    // 获取索引类型
+    GLenum getIndexType() const
+    {
+        return indexType;
+    }
+
+    // 获取优化后的统计
+    const MeshStatistics &getStatistics() const
+    {
+        return statistics;
+    }
+};
+
+#endif //OPENGLTUTORIAL_MESH_H
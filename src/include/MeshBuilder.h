@@ -0,0 +1,69 @@
+#ifndef OPENGLTUTORIAL_MESHBUILDER_H
+#define OPENGLTUTORIAL_MESHBUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 网格统计,用于比较优化前后的顶点着色器调用次数与顶点读取量
+struct MeshStatistics
+{
+    // 顶点数量
+    size_t vertexCount;
+    // 索引数量
+    size_t indexCount;
+    // 模拟的顶点后变换缓存未命中次数,即顶点着色器调用次数
+    size_t transformedVertices;
+    // 每个三角形平均变换的顶点数,最差为3
+    float acmr;
+    // 每个顶点平均变换的次数,最好为1
+    float atvr;
+    // 模拟的显存读取字节数,按缓存行计算
+    size_t fetchedBytes;
+    // 读取字节数与顶点数据大小之比,最好为1
+    float overfetch;
+};
+
+// 构建完成的网格数据,顶点按float存储,stride为每个顶点的float数量
+struct MeshData
+{
+    // 顶点数据
+    std::vector<float> vertices;
+    // 三角形索引
+    std::vector<uint32_t> indices;
+    // 每个顶点的float数量
+    size_t stride;
+    // 优化前的统计,原始数据按无索引绘制计算
+    MeshStatistics before;
+    // 优化后的统计
+    MeshStatistics after;
+};
+
+// 网格构建,把展开的三角形顶点合并为索引网格,并按顶点缓存及读取顺序优化
+class MeshBuilder
+{
+public:
+    // 模拟的顶点后变换缓存大小,FIFO
+    static const size_t TransformCacheSize = 16;
+    // 模拟的显存缓存行大小
+    static const size_t FetchLineSize = 64;
+    // 模拟的顶点读取缓存行数量,LRU
+    static const size_t FetchCacheLines = 64;
+
+    // 构建网格:合并相同顶点、优化三角形顺序、按首次使用重排顶点,输出优化前后的统计
+    // vertices为vertexCount个展开的顶点,每三个组成一个三角形
+    static MeshData build(const std::string &name, const float *vertices, size_t vertexCount, size_t stride);
+
+    // 合并按位相同的顶点,生成索引
+    static void weldVertices(const float *vertices, size_t vertexCount, size_t stride,
+                             std::vector<float> &outVertices, std::vector<uint32_t> &outIndices);
+    // 按Tom Forsyth的线性算法重排三角形,提高顶点后变换缓存命中率
+    static void optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount);
+    // 按索引中首次出现的顺序重排顶点,提高顶点读取的局部性
+    static void optimizeVertexFetch(std::vector<float> &vertices, std::vector<uint32_t> &indices, size_t stride);
+    // 模拟顶点后变换缓存与顶点读取缓存,统计索引网格
+    static MeshStatistics analyze(const std::vector<uint32_t> &indices, size_t vertexCount, size_t stride);
+};
+
+#endif //OPENGLTUTORIAL_MESHBUILDER_H
@@ -0,0 +1,56 @@
+#ifndef OPENGLTUTORIAL_MIPMAPGENERATOR_H
+#define OPENGLTUTORIAL_MIPMAPGENERATOR_H
+
+#include <cstddef>
+
+class ThreadPool;
+
+// 在CPU上生成RGBA8图像的Mipmap链,每一级由上一级按2x2像素的盒式滤波缩小一半,边长为奇数时舍去最后一列或一行
+// sRGB图像的RGB通道先查表转换到16位线性值再平均,平均后查表转换回sRGB,透明度与线性图像直接按8位整数平均
+// 每一级的像素行在线程池中分块并行,SSE一次缩小4个像素,两种指令集的结果逐字节相同
+class MipmapGenerator
+{
+public:
+    // 指令集
+    enum InstructionSet
+    {
+        Scalar,
+        SSE
+    };
+
+private:
+    // 线程池,为空时在调用线程缩小
+    ThreadPool *threadPool;
+    // 使用的指令集
+    InstructionSet instructionSet;
+
+public:
+    // 构造函数,默认使用编译支持的最快指令集
+    explicit MipmapGenerator(ThreadPool *threadPool = nullptr);
+
+    // 编译支持的最快指令集
+    static InstructionSet getBestInstructionSet();
+    // 指令集名称
+    static const char *getInstructionSetName(InstructionSet instructionSet);
+    // 是否编译了指令集
+    static bool isSupported(InstructionSet instructionSet);
+    // width x height的图像缩小到1x1的级数,包括第0级
+    static int getLevelCount(int width, int height);
+    // 完整Mipmap链的RGBA8字节数
+    static size_t getChainSize(int width, int height);
+
+    // 设置使用的指令集,不支持时保持不变
+    void setInstructionSet(InstructionSet set);
+    // 设置线程池,为空时在调用线程缩小
+    void setThreadPool(ThreadPool *pool)
+    {
+        threadPool = pool;
+    }
+
+    // 把一级RGBA8图像缩小一半写入target,target的边长为max(width / 2, 1) x max(height / 2, 1)
+    void downsample(const unsigned char *source, int width, int height, bool bIsSRGB, unsigned char *target) const;
+    // 生成完整的Mipmap链,chain至少能容纳getChainSize字节,各级从第0级开始依次紧密存放
+    void generate(const unsigned char *pixels, int width, int height, bool bIsSRGB, unsigned char *chain) const;
+};
+
+#endif //OPENGLTUTORIAL_MIPMAPGENERATOR_H
@@ -0,0 +1,52 @@
+#ifndef OPENGLTUTORIAL_POINTLIGHTLIST_H
+#define OPENGLTUTORIAL_POINTLIGHTLIST_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+#include "UniformBlocks.h"
+
+// 点光源列表,光源参数与着色器中的PointLight相同,另外保存由衰减推出的影响范围
+// 影响范围外光照低于CutoffIntensity,延迟渲染与分簇只让范围内的片段计算该光源
+class PointLightList
+{
+private:
+    // 光源参数,按std140布局,可以直接作为顶点属性或缓冲上传
+    std::vector<PointLightData> lights;
+    // 影响范围,xyz为光源位置,w为半径
+    std::vector<glm::vec4> bounds;
+
+public:
+    // 视为无影响的光照强度,8位颜色中约为5级
+    static const float CutoffIntensity;
+
+    // 获取光源数量
+    size_t size() const
+    {
+        return lights.size();
+    }
+    // 设置光源数量
+    void resize(size_t count);
+    // 设置第index个光源,同时计算影响范围
+    void set(size_t index, const PointLightData &light);
+    // 获取第index个光源
+    const PointLightData &get(size_t index) const
+    {
+        return lights[index];
+    }
+    // 获取所有光源参数
+    const PointLightData *getLights() const
+    {
+        return lights.data();
+    }
+    // 获取所有影响范围
+    const glm::vec4 *getBounds() const
+    {
+        return bounds.data();
+    }
+
+    // 由衰减计算影响半径,即最亮分量衰减到CutoffIntensity的距离
+    static float computeRadius(const PointLightData &light);
+};
+
+#endif //OPENGLTUTORIAL_POINTLIGHTLIST_H
@@ -0,0 +1,101 @@
+#ifndef OPENGLTUTORIAL_RENDERQUEUE_H
+#define OPENGLTUTORIAL_RENDERQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 绘制包,排序键与调用者定义的数据下标
+struct RenderPacket
+{
+    // 排序键
+    uint64_t key;
+    // 调用者定义的数据,一般为绘制数据的下标
+    uint32_t payload;
+};
+
+// 渲染队列,收集绘制包后按64位键基数排序,按键的顺序提交可以减少程序、材质与VAO的切换
+// 不透明物体的键从高到低为: 层(4) 程序(12) 材质(12) VAO(12) 深度(24),同一状态内从前往后绘制
+// 透明物体的键从高到低为: 层(4) 反转深度(24) 程序(12) 材质(12) VAO(12),从后往前绘制
+// 缓冲每帧复用,只在容量不足时扩大,预热后不再分配内存
+class RenderQueue
+{
+public:
+    // 层,层越小越先绘制
+    enum Layer
+    {
+        Opaque = 0,
+        Transparent = 1
+    };
+
+    // 键中各字段的位数
+    static const int LayerBits = 4;
+    static const int ProgramBits = 12;
+    static const int MaterialBits = 12;
+    static const int VertexArrayBits = 12;
+    static const int DepthBits = 24;
+
+private:
+    // 绘制包
+    std::vector<RenderPacket> packets;
+    // 排序时的临时缓冲
+    std::vector<RenderPacket> scratch;
+    // 本帧绘制包数量
+    size_t count;
+
+    // 扩大容量
+    void grow();
+
+public:
+    // 构造函数,预留initialCapacity个绘制包
+    explicit RenderQueue(size_t initialCapacity = 1024);
+    RenderQueue(const RenderQueue &) = delete;
+    RenderQueue &operator=(const RenderQueue &) = delete;
+
+    // 生成排序键,程序、材质与VAO超出位数时只保留低位,depth为0到1之间的归一化深度
+    static uint64_t makeKey(Layer layer, uint32_t program, uint32_t material, uint32_t vertexArray, float depth);
+    // 从键中取出材质
+    static uint32_t getMaterial(uint64_t key);
+
+    // 清空队列,保留容量
+    void clear()
+    {
+        count = 0;
+    }
+
+    // 加入绘制包
+    void push(uint64_t key, uint32_t payload)
+    {
+        if(count == packets.size())
+            grow();
+        packets[count].key = key;
+        packets[count].payload = payload;
+        count++;
+    }
+
+    // 追加另一个队列的全部绘制包,用于合并各线程并行填充的命令列表
+    void append(const RenderQueue &other);
+
+    // 按键从小到大排序,键相同的绘制包保持加入顺序
+    void sort();
+
+    // 获取绘制包数量
+    size_t size() const
+    {
+        return count;
+    }
+
+    // 获取第index个绘制包,排序后为提交顺序
+    const RenderPacket &operator[](size_t index) const
+    {
+        return packets[index];
+    }
+
+    // 获取容量,预热后保持不变
+    size_t getCapacity() const
+    {
+        return packets.size();
+    }
+};
+
+#endif //OPENGLTUTORIAL_RENDERQUEUE_H
@@ -0,0 +1,96 @@
+#ifndef OPENGLTUTORIAL_RINGBUFFER_H
+#define OPENGLTUTORIAL_RINGBUFFER_H
+
+#include <vector>
+#include "glad/glad.h"
+
+// 环形缓冲中的一次分配,offset为相对于缓冲起点的字节偏移,空间不足时data为nullptr
+struct RingAllocation
+{
+    // 写入地址
+    void *data;
+    // 在缓冲中的偏移
+    GLintptr offset;
+    // 分配大小
+    GLsizeiptr size;
+};
+
+// 每帧动态数据的环形缓冲,缓冲分为regionCount个帧区域,每帧在一个区域内顺序分配
+// 支持不可变存储时整个缓冲持久映射,直接写入映射内存,区域在GPU读取完之前由栅栏保护,不需要驱动拷贝
+// 只有OpenGL 3.3时每帧孤立整个缓冲,分配写入内存副本,flush时用glBufferSubData上传
+// 与其他GL对象一样不在析构时删除
+class RingBuffer
+{
+private:
+    // 缓冲对象id
+    GLuint id;
+    // 每个帧区域的大小
+    GLsizeiptr regionSize;
+    // 帧区域数量
+    GLuint regionCount;
+    // 当前帧区域
+    GLuint region;
+    // 当前帧已分配的字节数
+    GLsizeiptr head;
+    // 回退路径中已上传的字节数
+    GLsizeiptr flushed;
+    // 持久映射的地址
+    unsigned char *mapped;
+    // 回退路径中的内存副本
+    std::vector<unsigned char> staging;
+    // 每个帧区域最后一次使用后插入的栅栏
+    std::vector<GLsync> fences;
+    // 是否持久映射
+    bool bIsPersistent;
+    // 等待栅栏时真正阻塞的次数
+    GLuint stallCount;
+
+public:
+    // 构造函数,regionSize为每帧可以分配的字节数
+    explicit RingBuffer(GLsizeiptr regionSize, GLuint regionCount = 3);
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    // 保证每帧至少可以分配size字节,不够时等待GPU空闲后重新创建缓冲,只能在两帧之间调用
+    void reserve(GLsizeiptr size);
+    // 开始一帧,切换到下一个帧区域,区域仍在被GPU读取时等待
+    void beginFrame();
+    // 在当前帧区域中分配,alignment需为2的幂
+    RingAllocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+    // 在绘制使用分配的数据之前调用,回退路径上传新写入的部分,持久映射时不做任何事
+    void flush();
+    // 结束一帧,为当前帧区域插入栅栏
+    void endFrame();
+
+    // 获取缓冲对象id,reserve之后可能改变
+    GLuint getId() const
+    {
+        return id;
+    }
+
+    // 获取每帧可以分配的字节数
+    GLsizeiptr getRegionSize() const
+    {
+        return regionSize;
+    }
+
+    // 是否持久映射
+    bool isPersistent() const
+    {
+        return bIsPersistent;
+    }
+
+    // 获取等待栅栏时真正阻塞的次数
+    GLuint getStallCount() const
+    {
+        return stallCount;
+    }
+
+private:
+    // 创建缓冲,持久映射时映射整个缓冲
+    void create();
+    // 等待一个帧区域的栅栏并删除
+    void waitRegion(GLuint index);
+};
+
+#endif //OPENGLTUTORIAL_RINGBUFFER_H
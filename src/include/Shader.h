@@ -1,11 +1,15 @@
 #ifndef OPENGLTUTORIAL_SHADER_H
 #define OPENGLTUTORIAL_SHADER_H
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <utility>
+#include <vector>
 #include "glad/glad.h"
+#include "GLStateCache.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
@@ -16,30 +20,352 @@ enum class ShaderType
     VertexShader, FragmentShader, ShaderProgram
 };
 
+// Uniform句柄,指向Shader内部Uniform表的下标,渲染循环中使用句柄避免字符串查找
+struct UniformHandle
+{
+    // Uniform表下标,-1表示无效句柄
+    int index;
+
+    UniformHandle() : index(-1) {}
+    explicit UniformHandle(int index) : index(index) {}
+
+    // 判断句柄是否有效
+    bool isValid() const
+    {
+        return index >= 0;
+    }
+};
+
+// Uniform表项,只保存渲染时需要的数据,保证表紧凑
+struct UniformEntry
+{
+    // Uniform位置
+    GLint location;
+    // Uniform类型,例如GL_FLOAT_MAT4
+    GLenum type;
+    // Uniform数组大小,非数组为1
+    GLint size;
+    // 影子副本下标,位置相同的表项共用一个副本,-1表示没有位置
+    int shadowIndex;
+};
+
+// Uniform影子副本,保存最近一次上传的值,值按位相同时跳过上传
+struct UniformShadow
+{
+    // 最近一次上传的值,最大为mat4
+    unsigned char data[sizeof(glm::mat4)];
+    // 是否已经上传过
+    bool bIsValid;
+};
+
+// Uniform类型特性,检查C++类型与GLSL类型是否匹配并上传
+template <typename T>
+struct UniformTraits;
+
+template <>
+struct UniformTraits<int>
+{
+    // int可以设置int、bool及采样器
+    static bool accepts(GLenum type);
+    static void upload(GLint location, const int &value)
+    {
+        glUniform1i(location, value);
+    }
+};
+
+template <>
+struct UniformTraits<unsigned int>
+{
+    static bool accepts(GLenum type)
+    {
+        return GL_UNSIGNED_INT == type;
+    }
+    static void upload(GLint location, const unsigned int &value)
+    {
+        glUniform1ui(location, value);
+    }
+};
+
+template <>
+struct UniformTraits<float>
+{
+    static bool accepts(GLenum type)
+    {
+        return GL_FLOAT == type;
+    }
+    static void upload(GLint location, const float &value)
+    {
+        glUniform1f(location, value);
+    }
+};
+
+template <>
+struct UniformTraits<glm::vec2>
+{
+    static bool accepts(GLenum type)
+    {
+        return GL_FLOAT_VEC2 == type;
+    }
+    static void upload(GLint location, const glm::vec2 &value)
+    {
+        glUniform2fv(location, 1, &value[0]);
+    }
+};
+
+template <>
+struct UniformTraits<glm::vec3>
+{
+    static bool accepts(GLenum type)
+    {
+        return GL_FLOAT_VEC3 == type;
+    }
+    static void upload(GLint location, const glm::vec3 &value)
+    {
+        glUniform3fv(location, 1, &value[0]);
+    }
+};
+
+template <>
+struct UniformTraits<glm::vec4>
+{
+    static bool accepts(GLenum type)
+    {
+        return GL_FLOAT_VEC4 == type;
+    }
+    static void upload(GLint location, const glm::vec4 &value)
+    {
+        glUniform4fv(location, 1, &value[0]);
+    }
+};
+
+template <>
+struct UniformTraits<glm::mat3>
+{
+    static bool accepts(GLenum type)
+    {
+        return GL_FLOAT_MAT3 == type;
+    }
+    static void upload(GLint location, const glm::mat3 &value)
+    {
+        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+};
+
+template <>
+struct UniformTraits<glm::mat4>
+{
+    static bool accepts(GLenum type)
+    {
+        return GL_FLOAT_MAT4 == type;
+    }
+    static void upload(GLint location, const glm::mat4 &value)
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+};
+
+// 着色器构建模式
+enum class ShaderBuildMode
+{
+    // 构造时等待编译链接完成
+    Immediate,
+    // 构造时只提交编译链接,由ShaderLibrary统一等待
+    Deferred
+};
+
+// 正在构建的着色器程序,提交编译与链接后暂不查询状态
+struct ShaderBuild
+{
+    // 着色器程序
+    GLuint program;
+    // 顶点着色器
+    GLuint vertexShader;
+    // 片段着色器
+    GLuint fragmentShader;
+    // 程序二进制缓存键
+    uint64_t cacheKey;
+    // 是否从缓存加载
+    bool bIsFromCache;
+};
+
+class ShaderSource;
+class ShaderLibrary;
+
 // Shader工具类
 class Shader
 {
+    friend class ShaderLibrary;
 private:
     // 着色器程序id
     GLuint id;
+    // 顶点着色器文件路径
+    std::string vertexPath;
+    // 片段着色器文件路径
+    std::string fragmentPath;
+    // 注入到源码中的宏,区分同一源码的不同变体
+    std::vector<std::string> defines;
+    // Uniform表,链接后通过反射生成,下标即句柄,重建程序后保持不变
+    std::vector<UniformEntry> uniformEntries;
+    // Uniform名字,与Uniform表一一对应,只在获取句柄时使用
+    std::vector<std::string> uniformNames;
+    // 按名字排序的Uniform表下标,用于二分查找
+    std::vector<int> uniformOrder;
+    // Uniform影子副本,由Uniform表项的shadowIndex引用
+    std::vector<UniformShadow> uniformShadows;
+    // 依赖的着色器文件,包括入口文件与所有#include的文件
+    std::vector<std::string> dependencies;
+    // 包含关系图,first包含second
+    std::vector<std::pair<std::string, std::string>> includeGraph;
+    // 延迟构建的状态
+    ShaderBuild pendingBuild;
+    // 是否正在构建
+    bool bIsBuilding;
+    // 构建开始时间
+    std::chrono::steady_clock::time_point buildStartTime;
 public:
     // 着色器构造方法
-    Shader(const std::string &vertexShaderSource, const std::string &fragmentShaderSource);
+    Shader(const std::string &vertexShaderSource, const std::string &fragmentShaderSource,
+           ShaderBuildMode mode = ShaderBuildMode::Immediate);
+    // 着色器变体构造方法,defines中的每个宏以"#define 宏 1"注入两个阶段的源码
+    Shader(const std::string &vertexShaderSource, const std::string &fragmentShaderSource,
+           const std::vector<std::string> &defines, ShaderBuildMode mode = ShaderBuildMode::Immediate);
+
+    Shader(const Shader &) = delete;
+    Shader &operator=(const Shader &) = delete;
+
     // 着色器使用方法
     void use();
+    // 使用新的源码重建程序,新程序链接成功后才替换旧程序,失败时继续使用旧程序
+    bool reload(const ShaderSource &vertexSource, const ShaderSource &fragmentSource);
+    // 获取着色器程序id
+    GLuint getId() const
+    {
+        return id;
+    }
+    // 获取顶点着色器文件路径
+    const std::string &getVertexPath() const
+    {
+        return vertexPath;
+    }
+    // 获取片段着色器文件路径
+    const std::string &getFragmentPath() const
+    {
+        return fragmentPath;
+    }
+    // 获取注入的宏
+    const std::vector<std::string> &getDefines() const
+    {
+        return defines;
+    }
+    // 获取依赖的着色器文件
+    const std::vector<std::string> &getDependencies() const
+    {
+        return dependencies;
+    }
+    // 获取包含关系图
+    const std::vector<std::pair<std::string, std::string>> &getIncludeGraph() const
+    {
+        return includeGraph;
+    }
+    // 判断是否依赖某个文件,用于修改文件后只重建受影响的程序
+    bool dependsOn(const std::string &path) const;
     // 设置Uniform变量整数类型
     void setUniform1i(const std::string &name, int value);
     // 设置Uniform变量浮点数类型
-    void setUniform1f(const std::string &name, int value);
+    void setUniform1f(const std::string &name, float value);
     // 设置Uniform变量vec3类型
     void setUniform3fv(const std::string &name, glm::vec3 value);
+    // 设置Uniform变量3x3矩阵类型
+    void setUniformMatrix3fv(const std::string &name, glm::mat3 value);
     // 设置Uniform变量齐次矩阵类型
     void setUniformMatrix4fv(const std::string &name, glm::mat4 value);
+
+    // 获取Uniform句柄,不存在时返回无效句柄
+    UniformHandle uniform(const std::string &name) const;
+
+    // 通过句柄设置Uniform变量,T为int、unsigned int、float、glm::vec2/3/4或glm::mat3/4
+    // 与最近一次上传的值按位相同时跳过GL调用;上传前按需切换到本程序,不要求调用者先use
+    template <typename T>
+    void set(UniformHandle handle, const T &value)
+    {
+        static_assert(sizeof(T) <= sizeof(UniformShadow::data), "uniform type is larger than the shadow copy");
+        if(!handle.isValid())
+        {
+            return;
+        }
+        const UniformEntry &entry = uniformEntries[handle.index];
+        if(entry.location < 0)
+        {
+            return;
+        }
+        if(!UniformTraits<T>::accepts(entry.type))
+        {
+            std::cout << "ERROR::SHADER::UNIFORM::TYPE_MISMATCH " << uniformNames[handle.index] << std::endl;
+            return;
+        }
+        UniformShadow &shadow = uniformShadows[entry.shadowIndex];
+        if(shadow.bIsValid && 0 == std::memcmp(shadow.data, &value, sizeof(T)))
+        {
+            GLStateCache::countUniformUpload(false);
+            return;
+        }
+        std::memcpy(shadow.data, &value, sizeof(T));
+        shadow.bIsValid = true;
+        GLStateCache::useProgram(id);
+        UniformTraits<T>::upload(entry.location, value);
+        GLStateCache::countUniformUpload(true);
+    }
+
+    // 通过句柄设置Uniform变量整数类型
+    void setUniform1i(UniformHandle handle, int value)
+    {
+        set(handle, value);
+    }
+    // 通过句柄设置Uniform变量浮点数类型
+    void setUniform1f(UniformHandle handle, float value)
+    {
+        set(handle, value);
+    }
+    // 通过句柄设置Uniform变量vec3类型
+    void setUniform3fv(UniformHandle handle, const glm::vec3 &value)
+    {
+        set(handle, value);
+    }
+    // 通过句柄设置Uniform变量3x3矩阵类型
+    void setUniformMatrix3fv(UniformHandle handle, const glm::mat3 &value)
+    {
+        set(handle, value);
+    }
+    // 通过句柄设置Uniform变量齐次矩阵类型
+    void setUniformMatrix4fv(UniformHandle handle, const glm::mat4 &value)
+    {
+        set(handle, value);
+    }
 private:
-    // 读取着色器文件
-    std::string readShaderFile(const std::string &path);
-    // 着色器检查
-    void checkShader(GLuint id, ShaderType type);
+    // 获取用于输出的名字,变体附带注入的宏
+    std::string getName() const;
+    // 延迟构建是否已经完成,完成后调用finishBuild不会阻塞
+    bool isBuildComplete() const;
+    // 等待延迟构建完成
+    void finishBuild();
+    // 提交编译与链接,不查询任何状态,驱动可以在后台线程完成编译
+    void beginBuild(const ShaderSource &vertexSource, const ShaderSource &fragmentSource, ShaderBuild &build);
+    // 构建是否已经完成,不支持并行编译扩展时总是返回true
+    bool isBuildComplete(const ShaderBuild &build) const;
+    // 等待构建完成并检查结果,链接成功返回true
+    bool endBuild(ShaderBuild &build);
+    // 记录源码依赖的文件及包含关系
+    void recordDependencies(const ShaderSource &vertexSource, const ShaderSource &fragmentSource);
+    // 着色器检查,成功返回true
+    bool checkShader(GLuint id, ShaderType type);
+    // 反射所有活动的Uniform,生成Uniform表,重建程序后把影子副本中的值恢复到新程序
+    void reflectUniforms();
+    // 按GL类型上传影子副本中的值
+    static void uploadShadow(GLint location, GLenum type, const UniformShadow &shadow);
+    // 将共享uniform块绑定到固定的绑定点
+    void bindUniformBlocks();
+    // 根据名字查找Uniform表下标,不存在时返回-1
+    int findUniform(const std::string &name) const;
 };
 
 #endif //OPENGLTUTORIAL_SHADER_H
@@ -0,0 +1,42 @@
+#ifndef OPENGLTUTORIAL_SHADERCACHE_H
+#define OPENGLTUTORIAL_SHADERCACHE_H
+
+#include <cstdint>
+#include <string>
+#include "glad/glad.h"
+
+class ShaderSource;
+
+// 着色器程序二进制缓存,缓存文件以源码及驱动信息的哈希命名
+class ShaderCache
+{
+private:
+    // 缓存目录
+    static std::string cacheDirectory;
+
+public:
+    // 设置缓存目录
+    static void setCacheDirectory(const std::string &directory);
+    // 缓存是否可用,需要驱动支持程序二进制
+    static bool isEnabled();
+
+    // 计算缓存键,由预处理后的源码、渲染器名字及版本号组成
+    static uint64_t makeKey(const ShaderSource &vertexSource, const ShaderSource &fragmentSource);
+    // FNV-1a 64位哈希,seed用于串联多段数据
+    static uint64_t hash(const void *data, size_t length, uint64_t seed = 14695981039346656037ULL);
+
+    // 在链接前调用,提示驱动保留程序二进制
+    static void prepareProgram(GLuint program);
+    // 从缓存加载程序二进制,驱动拒绝时返回false
+    static bool load(GLuint program, uint64_t key);
+    // 将链接成功的程序二进制写入缓存
+    static void store(GLuint program, uint64_t key);
+
+private:
+    // 缓存文件路径
+    static std::string cachePath(uint64_t key);
+    // 逐级创建目录
+    static void createDirectories(const std::string &directory);
+};
+
+#endif //OPENGLTUTORIAL_SHADERCACHE_H
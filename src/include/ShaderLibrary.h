@@ -0,0 +1,39 @@
+#ifndef OPENGLTUTORIAL_SHADERLIBRARY_H
+#define OPENGLTUTORIAL_SHADERLIBRARY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Shader.h"
+
+// 着色器库,批量构建着色器程序
+// 先提交所有程序的编译与链接,再轮询完成状态,驱动可以在自己的线程中并行编译
+class ShaderLibrary
+{
+private:
+    // 着色器程序
+    std::vector<std::unique_ptr<Shader>> shaders;
+    // 已提交、等待下一次build的程序,包括不属于着色器库的程序
+    std::vector<Shader *> submitted;
+
+public:
+    // 添加着色器程序,立即提交编译与链接,返回的指针在着色器库销毁前有效
+    Shader *add(const std::string &vertexShaderSource, const std::string &fragmentShaderSource);
+    // 提交由别处持有的延迟构建程序,与添加的程序在同一次build中等待,程序需在build前保持有效
+    void submit(Shader *shader);
+    // 等待所有已提交的程序构建完成,之后可以继续提交并再次构建
+    void build();
+
+    // 获取着色器程序数量
+    size_t size() const
+    {
+        return shaders.size();
+    }
+    // 获取着色器程序
+    Shader *get(size_t index) const
+    {
+        return shaders[index].get();
+    }
+};
+
+#endif //OPENGLTUTORIAL_SHADERLIBRARY_H
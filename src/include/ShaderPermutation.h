@@ -0,0 +1,74 @@
+#ifndef OPENGLTUTORIAL_SHADERPERMUTATION_H
+#define OPENGLTUTORIAL_SHADERPERMUTATION_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Shader.h"
+
+class ShaderLibrary;
+class ShaderWatcher;
+
+// 着色器排列,一份源码通过"#pragma keywords"声明特性关键字,每种关键字组合编译为一个变体
+// 变体在第一次请求时才编译,之后缓存在内存中;注入的宏参与源码哈希,因此磁盘上的程序二进制缓存也按变体区分
+// 启动时已知的变体可以通过prebuild提交到着色器库,与其他程序一起并行编译
+class ShaderPermutation
+{
+private:
+    // 顶点着色器文件路径
+    std::string vertexPath;
+    // 片段着色器文件路径
+    std::string fragmentPath;
+    // 两个阶段声明的关键字,下标即关键字掩码中的位
+    std::vector<std::string> keywords;
+    // 已构建的变体,键为关键字掩码
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>> variants;
+    // 热重载监视器,新构建的变体自动加入监视
+    ShaderWatcher *watcher;
+
+public:
+    // 关键字数量上限,与掩码位数一致
+    static const size_t MaxKeywords = 32;
+
+    // 构造函数,只读取源码中声明的关键字,不编译任何变体
+    ShaderPermutation(const std::string &vertexShaderSource, const std::string &fragmentShaderSource);
+
+    ShaderPermutation(const ShaderPermutation &) = delete;
+    ShaderPermutation &operator=(const ShaderPermutation &) = delete;
+
+    // 设置热重载监视器,已构建的变体立即加入监视
+    void setWatcher(ShaderWatcher *shaderWatcher);
+
+    // 将关键字名字转换为掩码,未声明的关键字被忽略,保证同一组合只有一个变体
+    uint32_t keywordMask(const std::vector<std::string> &names) const;
+    // 以延迟模式提交一组变体的编译与链接,已存在的变体被跳过,使用前需调用library.build()等待完成
+    void prebuild(const std::vector<uint32_t> &masks, ShaderLibrary &library);
+    // 获取变体,第一次请求时编译,返回的指针在排列销毁前有效
+    Shader *get(uint32_t mask);
+    // 按关键字名字获取变体
+    Shader *get(const std::vector<std::string> &names)
+    {
+        return get(keywordMask(names));
+    }
+
+    // 获取声明的关键字
+    const std::vector<std::string> &getKeywords() const
+    {
+        return keywords;
+    }
+    // 获取已构建的变体数量
+    size_t getVariantCount() const
+    {
+        return variants.size();
+    }
+
+private:
+    // 按关键字掩码生成注入的宏,按声明顺序排列
+    std::vector<std::string> makeDefines(uint32_t mask) const;
+    // 创建变体并加入监视
+    Shader *createVariant(uint32_t mask, ShaderBuildMode mode);
+};
+
+#endif //OPENGLTUTORIAL_SHADERPERMUTATION_H
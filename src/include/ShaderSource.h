@@ -0,0 +1,135 @@
+#ifndef OPENGLTUTORIAL_SHADERSOURCE_H
+#define OPENGLTUTORIAL_SHADERSOURCE_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "glad/glad.h"
+#include "MappedFile.h"
+
+// 着色器源码,路径相对于shader目录,默认读取构建时嵌入可执行文件的源码并展开#include
+// 设置了磁盘目录时通过内存映射读取文件,用于开发时修改与热重载
+// 展开结果是一组指向嵌入数据或映射内存的片段,直接交给glShaderSource,不拷贝源码
+class ShaderSource
+{
+private:
+    // 从磁盘加载着色器的目录,为空时使用嵌入的源码
+    static std::string overrideDirectory;
+
+    // 映射的文件,只在从磁盘加载时使用
+    std::vector<std::unique_ptr<MappedFile>> mappedFiles;
+    // 文件路径,下标即#line指令中的源字符串编号
+    std::vector<std::string> files;
+    // 文件内容哈希,与文件路径一一对应
+    std::vector<uint64_t> fileHashes;
+    // 包含关系,first包含second,均为文件下标
+    std::vector<std::pair<int, int>> includes;
+
+    // 源码片段
+    std::vector<const GLchar *> segments;
+    // 源码片段长度
+    std::vector<GLint> lengths;
+    // 生成的#line与#define指令,deque保证追加时已有字符串地址不变
+    std::deque<std::string> generatedText;
+    // 注入到#version之后的宏,用于编译着色器变体
+    std::vector<std::string> defines;
+    // 源码中通过"#pragma keywords"声明的特性关键字
+    std::vector<std::string> keywords;
+    // 入口文件#version声明的版本号,没有#version时为0,决定#line指令的行号偏移
+    int version;
+
+    // 是否复制文件内容而不映射
+    bool bIsCopy;
+    // 是否加载成功
+    bool bIsValid;
+    // 错误信息
+    std::string error;
+
+public:
+    // 构造函数,加载相对于shader目录的path并展开其中的#include
+    // bIsCopy为true时读入内存而不映射,用于热重载时正在被编辑器写入的文件,对嵌入的源码无效
+    explicit ShaderSource(const std::string &path, bool bIsCopy = false);
+    // 构造函数,额外在#version之后为defines中的每个宏注入"#define 宏 1"
+    ShaderSource(const std::string &path, const std::vector<std::string> &defines, bool bIsCopy = false);
+
+    // 禁止拷贝,片段指针指向本对象持有的映射
+    ShaderSource(const ShaderSource &) = delete;
+    ShaderSource &operator=(const ShaderSource &) = delete;
+
+    // 是否加载成功
+    bool isValid() const
+    {
+        return bIsValid;
+    }
+    // 获取错误信息
+    const std::string &getError() const
+    {
+        return error;
+    }
+    // 获取源码片段数量
+    GLsizei getSegmentCount() const
+    {
+        return (GLsizei)segments.size();
+    }
+    // 获取源码片段
+    const GLchar *const *getSegments() const
+    {
+        return segments.data();
+    }
+    // 获取源码片段长度
+    const GLint *getLengths() const
+    {
+        return lengths.data();
+    }
+    // 获取依赖的文件,第一个为入口文件
+    const std::vector<std::string> &getFiles() const
+    {
+        return files;
+    }
+    // 获取包含关系
+    const std::vector<std::pair<int, int>> &getIncludes() const
+    {
+        return includes;
+    }
+
+    // 获取声明的特性关键字,按首次出现的顺序
+    const std::vector<std::string> &getKeywords() const
+    {
+        return keywords;
+    }
+    // 获取注入的宏
+    const std::vector<std::string> &getDefines() const
+    {
+        return defines;
+    }
+
+    // 对展开后的源码做哈希,用于缓存键
+    uint64_t hash(uint64_t seed) const;
+
+    // 规范化路径,统一分隔符并消除"."与".."
+    static std::string normalizePath(const std::string &path);
+
+    // 设置从磁盘加载着色器的目录,例如"../shader",为空时使用嵌入的源码
+    static void setOverrideDirectory(const std::string &directory);
+    // 获取从磁盘加载着色器的目录
+    static const std::string &getOverrideDirectory();
+    // 将相对于shader目录的路径转换为实际加载的路径
+    static std::string resolvePath(const std::string &path);
+
+private:
+    // 展开一个文件,返回false表示出错
+    bool expand(const std::string &path, int parent, int depth);
+    // 添加源码片段
+    void addSegment(const char *data, size_t length);
+    // 添加#line指令,恢复编译错误中的行号与文件编号
+    void addLineDirective(int line, int fileIndex);
+    // 添加注入的#define指令
+    void addDefines();
+    // 解析"#pragma keywords"之后的关键字列表
+    void parseKeywords(const char *begin, const char *end);
+};
+
+#endif //OPENGLTUTORIAL_SHADERSOURCE_H
@@ -0,0 +1,97 @@
+#ifndef OPENGLTUTORIAL_SHADERWATCHER_H
+#define OPENGLTUTORIAL_SHADERWATCHER_H
+
+#include <atomic>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Shader.h"
+#include "ShaderSource.h"
+
+// 着色器热重载,后台线程监视着色器文件,修改后重新读取受影响程序的源码
+// 渲染线程在帧开始时调用update替换程序,不会等待文件读取
+class ShaderWatcher
+{
+private:
+    // 监视的着色器
+    struct WatchEntry
+    {
+        // 着色器
+        Shader *shader;
+        // 顶点着色器文件路径
+        std::string vertexPath;
+        // 片段着色器文件路径
+        std::string fragmentPath;
+        // 注入的宏,重新读取源码时保持同一变体
+        std::vector<std::string> defines;
+        // 依赖的文件,后台线程读取新源码后更新
+        std::vector<std::string> dependencies;
+    };
+
+    // 等待渲染线程替换的程序源码
+    struct PendingReload
+    {
+        // 着色器
+        Shader *shader;
+        // 顶点着色器源码
+        std::unique_ptr<ShaderSource> vertexSource;
+        // 片段着色器源码
+        std::unique_ptr<ShaderSource> fragmentSource;
+    };
+
+    // 监视的着色器,受mutex保护
+    std::vector<WatchEntry> entries;
+    // 等待替换的程序源码,受mutex保护
+    std::vector<PendingReload> pendingReloads;
+    // 互斥量,持有期间不做任何文件操作
+    std::mutex mutex;
+    // 后台线程
+    std::thread thread;
+    // 后台线程是否运行
+    std::atomic<bool> bIsRunning;
+
+#ifdef __linux__
+    // inotify描述符
+    int inotifyDescriptor;
+    // inotify监视描述符到目录的映射,只在后台线程访问
+    std::map<int, std::string> watchDirectories;
+#else
+    // 文件最后修改时间,只在后台线程访问
+    std::map<std::string, time_t> modifyTimes;
+#endif
+
+public:
+    // 构造函数
+    ShaderWatcher();
+    // 析构函数,停止后台线程
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher &) = delete;
+    ShaderWatcher &operator=(const ShaderWatcher &) = delete;
+
+    // 监视着色器,着色器的生命周期需要长于监视器
+    void watch(Shader *shader);
+    // 启动后台线程
+    void start();
+    // 停止后台线程
+    void stop();
+
+    // 在帧开始时调用,替换已重建的程序,返回替换成功的数量
+    // 后台线程正持有锁时直接返回,留到下一帧处理
+    int update();
+
+private:
+    // 后台线程函数
+    void run();
+    // 读取受修改文件影响的程序源码,提交给渲染线程
+    void reloadChanged(const std::set<std::string> &changedFiles);
+    // 复制所有依赖文件
+    std::set<std::string> collectDependencies();
+};
+
+#endif //OPENGLTUTORIAL_SHADERWATCHER_H
@@ -0,0 +1,156 @@
+#ifndef OPENGLTUTORIAL_SHADOWMAPS_H
+#define OPENGLTUTORIAL_SHADOWMAPS_H
+
+#include <cstddef>
+#include <vector>
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "Shader.h"
+#include "ShaderPermutation.h"
+#include "UniformBlocks.h"
+#include "UniformBuffer.h"
+
+class Mesh;
+class ShaderLibrary;
+class ShaderWatcher;
+
+// 阴影贴图的重绘统计,从创建开始累计
+struct ShadowStatistics
+{
+    // 静态层与动态层的重绘次数,级联的一级或立方体贴图的六个面算一次
+    unsigned int staticRedraws;
+    unsigned int dynamicRedraws;
+    // 绘制的投射阴影物体实例总数
+    size_t casterInstances;
+};
+
+// 缓存的阴影贴图,平行光使用级联阴影,点光源使用立方体阴影,对应LightData中的两个光源
+// 投射阴影的物体分为静态与动态两层,各自绘制到一张阴影贴图,着色器中两层的可见度相乘
+// 一张阴影贴图只在光源、覆盖范围或其范围内的物体改变时重绘,静态层在相机不离开级联的缓存范围时保持不变
+// 与其他GL对象一样不在析构时删除
+class ShadowMaps
+{
+public:
+    // 级联数量,与Shadows.glsl一致
+    static const int CascadeCount = 3;
+    // 纹理数量,依次为级联的静态层、动态层,立方体的静态层、动态层
+    static const int TextureCount = 4;
+
+private:
+    // 一张阴影贴图两层的缓存状态
+    struct CacheState
+    {
+        bool bIsStaticValid;
+        bool bIsDynamicValid;
+    };
+    // 一级级联,覆盖光源空间中以center为中心、边长为2*halfSize的正方形
+    struct Cascade
+    {
+        CacheState state;
+        glm::vec2 center;
+        float halfSize;
+        // 光源的裁剪矩阵乘视图矩阵
+        glm::mat4 viewProjection;
+    };
+
+    // 级联与立方体贴图的边长
+    GLsizei cascadeSize;
+    GLsizei cubeSize;
+    // 深度纹理,顺序见TextureCount
+    GLuint textures[TextureCount];
+    // 只有深度附件的帧缓冲
+    GLuint framebuffer;
+    // 投射阴影物体的模型矩阵缓冲与VAO
+    GLuint instanceBuffer;
+    GLuint instanceVertexArray;
+    const Mesh &casterMesh;
+
+    // 深度程序,级联与立方体两个变体,第一次绘制时获取
+    ShaderPermutation depthShaders;
+    Shader *cascadeShader;
+    Shader *pointShader;
+    UniformHandle cascadeViewProjectionHandle;
+    UniformHandle pointViewProjectionHandle;
+    UniformHandle pointPositionRadiusHandle;
+
+    // 静态物体与动态物体的模型矩阵及包围球
+    std::vector<glm::mat4> staticModels;
+    std::vector<glm::vec4> staticSpheres;
+    std::vector<glm::mat4> dynamicModels;
+    std::vector<glm::vec4> dynamicSpheres;
+    // 上一次更新后改变的动态物体在改变前后的包围球
+    std::vector<glm::vec4> changedSpheres;
+    // 平行光方向与光源空间的视图矩阵,以及场景在光源空间的深度范围
+    glm::vec3 lightDirection;
+    glm::mat4 lightView;
+    float lightNear;
+    float lightFar;
+    Cascade cascades[CascadeCount];
+    // 点光源位置与影响半径
+    glm::vec4 pointBounds;
+    CacheState pointState;
+
+    // 重绘时收集的模型矩阵
+    std::vector<glm::mat4> batch;
+    ShadowStatistics statistics;
+    UniformBuffer shadowUniformBuffer;
+    ShadowData shadowData;
+
+public:
+    // 构造函数,创建cascadeSize x cascadeSize的级联与cubeSize x cubeSize的立方体阴影,casterMesh为所有投射阴影物体共用的网格
+    ShadowMaps(GLsizei cascadeSize, GLsizei cubeSize, const Mesh &casterMesh);
+    ShadowMaps(const ShadowMaps &) = delete;
+    ShadowMaps &operator=(const ShadowMaps &) = delete;
+
+    // 设置热重载监视器
+    void setWatcher(ShaderWatcher *shaderWatcher);
+    // 把两个深度变体提交到着色器库,与其他启动时的程序一起编译,绘制前需等待着色器库构建完成
+    void prebuildShaders(ShaderLibrary &library);
+    // 设置静态物体,spheres的xyz为球心,w为半径,所有静态层失效
+    void setStaticCasters(const glm::mat4 *models, const glm::vec4 *spheres, size_t count);
+    // 设置动态物体,每帧调用,只有模型矩阵改变的物体使其前后范围内的动态层失效
+    void setDynamicCasters(const glm::mat4 *models, const glm::vec4 *spheres, size_t count);
+    // 设置平行光方向,改变时所有级联失效
+    void setDirectionLight(const glm::vec3 &direction);
+    // 设置点光源,位置或影响半径改变时立方体阴影失效
+    void setPointLight(const PointLightData &light);
+    // 使所有阴影贴图失效,下一次更新时全部重绘
+    void invalidate();
+
+    // 按相机调整级联的范围,重绘失效且需要的阴影贴图并上传阴影参数,fovY为弧度
+    // 返回是否绘制过,绘制过时视口与帧缓冲已改变,调用者需要恢复视口
+    bool update(const glm::mat4 &view, float fovY, float aspect, float nearPlane, float shadowDistance,
+                bool bUseDirectionLight, bool bUsePointLight);
+    // 把四张阴影贴图绑定到firstUnit开始的纹理单元
+    void bind(GLuint firstUnit) const;
+
+    // 获取统计
+    const ShadowStatistics &getStatistics() const
+    {
+        return statistics;
+    }
+
+    // 把着色器中Shadows.glsl的采样器设置为firstUnit开始的纹理单元
+    static void setSamplers(Shader *shader, GLuint firstUnit);
+
+private:
+    // 由平行光方向与所有物体的包围盒计算光源空间,所有级联失效
+    void updateLightSpace();
+    // 调整一级级联的范围,相机的切片离开缓存范围时重新居中,两层都失效
+    void fitCascade(int index, const glm::mat4 &inverseView, float tanHalfX, float tanHalfY, float nearDepth, float farDepth);
+    // 收集与判断函数相交的物体,上传模型矩阵,返回数量
+    template <typename Predicate>
+    GLsizei uploadCasters(const std::vector<glm::mat4> &models, const std::vector<glm::vec4> &spheres, const Predicate &predicate);
+    // 获取两个深度变体及其Uniform句柄,第一次绘制时调用,未预先构建的变体在此编译
+    void resolveShaders();
+    // 重绘一级级联的一层
+    void drawCascade(int index, bool bIsDynamic);
+    // 重绘立方体阴影的一层
+    void drawPointLight(bool bIsDynamic);
+    // 球是否与级联在光源空间的范围相交,深度方向不限
+    bool intersectsCascade(const Cascade &cascade, const glm::vec4 &sphere) const;
+    // 球是否与点光源的影响范围相交
+    bool intersectsPointLight(const glm::vec4 &sphere) const;
+};
+
+#endif //OPENGLTUTORIAL_SHADOWMAPS_H
@@ -0,0 +1,50 @@
+#ifndef OPENGLTUTORIAL_TEXTURECACHE_H
+#define OPENGLTUTORIAL_TEXTURECACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MipmapGenerator;
+
+// 预解码贴图缓存,把解码后的RGBA8像素及CPU生成的Mipmap链存放在源图片旁边的.mips文件中
+// 再次加载时直接读取缓存,跳过解码与Mipmap生成,缓存键为源文件内容与是否按sRGB缩小的哈希,源文件改变后重新生成
+class TextureCache
+{
+private:
+    // 是否读写缓存文件
+    static bool bIsEnabled;
+
+public:
+    // 解码后的贴图,pixels为从第0级开始紧密存放的RGBA8 Mipmap链
+    struct Image
+    {
+        int width;
+        int height;
+        int levelCount;
+        std::vector<unsigned char> pixels;
+    };
+
+    // 设置是否读写缓存文件,关闭时每次加载都解码并生成Mipmap链,只在没有加载进行时调用
+    static void setEnabled(bool bEnabled);
+    // 是否读写缓存文件
+    static bool isEnabled()
+    {
+        return bIsEnabled;
+    }
+
+    // 缓存文件路径,位于源图片旁边
+    static std::string cachePath(const std::string &path);
+    // 读取贴图,缓存有效时直接读取,否则解码源图片、生成Mipmap链并写入缓存,源图片无法读取时返回false
+    // 关闭缓存时不读写缓存文件,bIsCached不为空时返回是否命中缓存,多个线程可以同时加载
+    static bool load(const std::string &path, bool bIsSRGB, const MipmapGenerator &generator, Image &image,
+                     bool *bIsCached = nullptr);
+
+private:
+    // 读取缓存文件,文件缺失、损坏或键不匹配时返回false
+    static bool read(const std::string &path, uint64_t key, Image &image);
+    // 写入缓存文件
+    static void write(const std::string &path, uint64_t key, const Image &image);
+};
+
+#endif //OPENGLTUTORIAL_TEXTURECACHE_H
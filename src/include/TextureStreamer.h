@@ -0,0 +1,104 @@
+#ifndef OPENGLTUTORIAL_TEXTURESTREAMER_H
+#define OPENGLTUTORIAL_TEXTURESTREAMER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "glad/glad.h"
+#include "MipmapGenerator.h"
+#include "RingBuffer.h"
+#include "TextureCache.h"
+
+// 贴图流式加载,load立即返回贴图id,贴图先使用1x1的占位内容
+// 解码线程从预解码缓存读取带Mipmap链的像素,缓存失效时解码图片并在CPU上生成Mipmap链,不再调用glGenerateMipmap
+// 渲染线程在帧开始时调用update,把解码完成的像素写入像素缓冲后从缓冲上传
+// 每帧上传的字节数不超过预算,超出的留到下一帧,加载大量贴图时不会长时间卡住一帧
+// 像素缓冲使用环形缓冲,支持时持久映射,与其他GL对象一样不在析构时删除
+// 离线压缩的KTX2贴图由loadCompressed直接上传,不经过解码线程
+class TextureStreamer
+{
+private:
+    // 等待解码的贴图
+    struct DecodeRequest
+    {
+        GLuint texture;
+        std::string path;
+        bool bIsSRGB;
+    };
+    // 解码完成的贴图,bIsLoaded为false表示加载失败
+    struct DecodedImage
+    {
+        GLuint texture;
+        std::string path;
+        bool bIsLoaded;
+        TextureCache::Image image;
+    };
+
+    // 解码线程
+    std::vector<std::thread> decoders;
+    // Mipmap生成器,不使用线程池,多张贴图已经在多个解码线程中并行
+    MipmapGenerator generator;
+    // 互斥量,保护两个队列与停止标志,持有期间不做解码与GL调用
+    std::mutex mutex;
+    // 唤醒解码线程
+    std::condition_variable requestCondition;
+    // 通知渲染线程有贴图解码完成
+    std::condition_variable decodedCondition;
+    // 等待解码的贴图,受mutex保护
+    std::deque<DecodeRequest> requests;
+    // 解码完成等待上传的贴图,受mutex保护
+    std::deque<DecodedImage> decoded;
+    // 是否停止,受mutex保护
+    bool bIsStopping;
+
+    // 渲染线程取出的待上传贴图,按解码完成的顺序上传
+    std::deque<DecodedImage> uploads;
+    // 尚未上传的贴图数量,只在渲染线程访问
+    size_t pendingCount;
+    // 像素缓冲,每帧的区域大小即上传预算
+    RingBuffer pixelRing;
+
+    // 解码线程函数
+    void run();
+    // 从像素缓冲的偏移或内存地址上传一张贴图的Mipmap链
+    void upload(const DecodedImage &image, const unsigned char *pixels);
+
+public:
+    // 构造函数,decoderCount为解码线程数量,0表示使用硬件线程数量,uploadBudget为每帧最多上传的字节数
+    TextureStreamer(size_t decoderCount, GLsizeiptr uploadBudget);
+    // 析构函数,停止并等待解码线程
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer &) = delete;
+    TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+    // 创建贴图并提交解码,返回的贴图id立即可以绑定,上传完成前为1x1的灰色
+    // 颜色贴图的bIsSRGB为true,RGB通道在线性空间缩小;高光遮罩、法线等数据贴图为false,直接按存储的值缩小
+    GLuint load(const std::string &path, bool bIsSRGB);
+    // 从内存映射的KTX2文件上传块压缩贴图及其Mipmap链,文件无效或不支持其格式时返回0
+    // 压缩数据不需要解码,直接从映射内存同步上传
+    static GLuint loadCompressed(const std::string &path);
+    // 在帧开始时调用,按预算上传解码完成的贴图,返回本帧上传的数量
+    // 单张贴图超过预算时,本帧没有上传过其他贴图才直接从内存上传
+    size_t update();
+    // 等待所有贴图解码并上传完成,每次按预算上传,像素缓冲仍被GPU读取时会等待
+    void finish();
+
+    // 获取尚未上传的贴图数量
+    size_t getPendingCount() const
+    {
+        return pendingCount;
+    }
+
+    // 获取解码线程数量
+    size_t getDecoderCount() const
+    {
+        return decoders.size();
+    }
+};
+
+#endif //OPENGLTUTORIAL_TEXTURESTREAMER_H
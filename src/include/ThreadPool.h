@@ -0,0 +1,71 @@
+#ifndef OPENGLTUTORIAL_THREADPOOL_H
+#define OPENGLTUTORIAL_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 线程池,把一段范围切分成多个块并行处理,调用线程也参与处理并等待所有块完成
+// 每次parallelFor所有工作线程都会被唤醒并报到,不会有线程跨越两次调用
+class ThreadPool
+{
+public:
+    // 块处理函数,参数为范围起点、终点与块序号
+    typedef std::function<void(size_t begin, size_t end, size_t chunk)> ChunkFunction;
+
+private:
+    // 工作线程
+    std::vector<std::thread> workers;
+    // 互斥量,保护任务与计数
+    std::mutex mutex;
+    // 唤醒工作线程
+    std::condition_variable wakeCondition;
+    // 通知调用线程所有工作线程已完成
+    std::condition_variable doneCondition;
+    // 当前任务,受mutex保护,工作线程报到后只读
+    const ChunkFunction *task;
+    // 当前任务的范围大小
+    size_t taskCount;
+    // 当前任务的块数量
+    size_t taskChunks;
+    // 下一个待处理的块
+    std::atomic<size_t> nextChunk;
+    // 尚未完成当前任务的工作线程数量,受mutex保护
+    size_t busyWorkers;
+    // 任务代数,每次parallelFor加一,受mutex保护
+    uint64_t generation;
+    // 是否停止,受mutex保护
+    bool bIsStopping;
+
+    // 工作线程函数
+    void run();
+    // 领取并处理块,直到没有剩余的块
+    void runChunks();
+
+public:
+    // 构造函数,threadCount为包括调用线程在内的线程数量,0表示使用硬件线程数量
+    explicit ThreadPool(size_t threadCount = 0);
+    // 析构函数,停止并等待工作线程
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // 获取包括调用线程在内的线程数量
+    size_t getThreadCount() const
+    {
+        return workers.size() + 1;
+    }
+
+    // 获取count个元素、每块至少minChunkSize个元素时切分的块数量
+    size_t getChunkCount(size_t count, size_t minChunkSize) const;
+    // 把[0, count)切分为getChunkCount个连续块并行处理,块按序号从小到大对应范围
+    void parallelFor(size_t count, size_t minChunkSize, const ChunkFunction &function);
+};
+
+#endif //OPENGLTUTORIAL_THREADPOOL_H
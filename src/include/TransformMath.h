@@ -0,0 +1,34 @@
+#ifndef OPENGLTUTORIAL_TRANSFORMMATH_H
+#define OPENGLTUTORIAL_TRANSFORMMATH_H
+
+#include <cstddef>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+// 每个实例的变换,作为每实例前进一次的顶点属性读取
+// 法线矩阵每列占一个vec4,属性只读取前三个分量
+struct InstanceTransform
+{
+    // 模型-视图-裁剪矩阵
+    glm::mat4 mvp;
+    // 模型矩阵,用于输出世界坐标系的顶点位置
+    glm::mat4 model;
+    // 法线矩阵,模型矩阵左上3x3的逆转置
+    glm::vec4 normalMatrix[3];
+};
+static_assert(sizeof(InstanceTransform) == 176, "InstanceTransform must be tightly packed");
+
+// 变换计算工具类,在CPU上每个物体计算一次,顶点着色器中不再做矩阵乘法与求逆
+class TransformMath
+{
+public:
+    // 计算a * b,支持SSE时一次计算一列
+    static void multiply(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &result);
+    // 计算法线矩阵,左上3x3的逆转置用叉积求伴随矩阵得到,不求完整的4x4逆
+    static glm::mat3 normalMatrix(const glm::mat4 &model);
+    // 为indices中的count个物体计算实例变换,normalMatrices为预先计算的法线矩阵
+    static void computeInstances(const glm::mat4 &viewProjection, const glm::mat4 *models, const glm::mat3 *normalMatrices,
+                                 const uint32_t *indices, size_t count, InstanceTransform *instances);
+};
+
+#endif //OPENGLTUTORIAL_TRANSFORMMATH_H
@@ -0,0 +1,147 @@
+#ifndef OPENGLTUTORIAL_UNIFORMBLOCKS_H
+#define OPENGLTUTORIAL_UNIFORMBLOCKS_H
+
+#include <cstddef>
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+// 着色器中共享uniform块在C++端的镜像结构,按std140规则布局
+// GLSL 3.30不能在着色器中指定块的绑定点,由Shader链接后按块名绑定
+
+// uniform块绑定点
+struct UniformBlockBinding
+{
+    // 每帧数据,对应shader/include/Frame.glsl中的FrameData
+    static const GLuint Frame = 0;
+    // 光源数据,对应shader/PhongLight/include/Lighting.glsl中的LightData
+    static const GLuint Light = 1;
+    // 分簇参数,对应shader/PhongLight/include/Clusters.glsl中的ClusterData
+    static const GLuint Cluster = 2;
+    // 阴影参数,对应shader/PhongLight/include/Shadows.glsl中的ShadowData
+    static const GLuint Shadow = 3;
+};
+
+// 每帧数据,所有程序共享
+struct FrameData
+{
+    // 视图矩阵
+    glm::mat4 view;
+    // 裁剪矩阵
+    glm::mat4 projection;
+    // 裁剪矩阵乘视图矩阵
+    glm::mat4 viewProjection;
+    // 相机位置,std140中vec3按16字节对齐
+    glm::vec3 cameraPosition;
+    float padding0;
+};
+
+static_assert(offsetof(FrameData, view) == 0, "FrameData.view offset does not match std140");
+static_assert(offsetof(FrameData, projection) == 64, "FrameData.projection offset does not match std140");
+static_assert(offsetof(FrameData, viewProjection) == 128, "FrameData.viewProjection offset does not match std140");
+static_assert(offsetof(FrameData, cameraPosition) == 192, "FrameData.cameraPosition offset does not match std140");
+static_assert(sizeof(FrameData) == 208, "FrameData size does not match std140");
+
+// 点光源,对应GLSL中的PointLight
+struct PointLightData
+{
+    // 光源位置
+    glm::vec3 position;
+    // 衰减常数项,紧跟vec3之后
+    float constant;
+    // 衰减一次项
+    float linear;
+    // 衰减二次项
+    float quadratic;
+    float padding0[2];
+    // 环境光
+    glm::vec3 ambient;
+    float padding1;
+    // 漫反射光
+    glm::vec3 diffuse;
+    float padding2;
+    // 镜面光
+    glm::vec3 specular;
+    float padding3;
+};
+
+static_assert(offsetof(PointLightData, position) == 0, "PointLightData.position offset does not match std140");
+static_assert(offsetof(PointLightData, constant) == 12, "PointLightData.constant offset does not match std140");
+static_assert(offsetof(PointLightData, linear) == 16, "PointLightData.linear offset does not match std140");
+static_assert(offsetof(PointLightData, quadratic) == 20, "PointLightData.quadratic offset does not match std140");
+static_assert(offsetof(PointLightData, ambient) == 32, "PointLightData.ambient offset does not match std140");
+static_assert(offsetof(PointLightData, diffuse) == 48, "PointLightData.diffuse offset does not match std140");
+static_assert(offsetof(PointLightData, specular) == 64, "PointLightData.specular offset does not match std140");
+static_assert(sizeof(PointLightData) == 80, "PointLightData size does not match std140");
+
+// 平行光,对应GLSL中的DirectionLight
+struct DirectionLightData
+{
+    // 光照方向
+    glm::vec3 direction;
+    float padding0;
+    // 环境光
+    glm::vec3 ambient;
+    float padding1;
+    // 漫反射光
+    glm::vec3 diffuse;
+    float padding2;
+    // 镜面光
+    glm::vec3 specular;
+    float padding3;
+};
+
+static_assert(offsetof(DirectionLightData, direction) == 0, "DirectionLightData.direction offset does not match std140");
+static_assert(offsetof(DirectionLightData, ambient) == 16, "DirectionLightData.ambient offset does not match std140");
+static_assert(offsetof(DirectionLightData, diffuse) == 32, "DirectionLightData.diffuse offset does not match std140");
+static_assert(offsetof(DirectionLightData, specular) == 48, "DirectionLightData.specular offset does not match std140");
+static_assert(sizeof(DirectionLightData) == 64, "DirectionLightData size does not match std140");
+
+// 光源数据,所有程序共享
+struct LightData
+{
+    // 点光源
+    PointLightData light;
+    // 平行光
+    DirectionLightData directionLight;
+};
+
+static_assert(offsetof(LightData, light) == 0, "LightData.light offset does not match std140");
+static_assert(offsetof(LightData, directionLight) == 80, "LightData.directionLight offset does not match std140");
+static_assert(sizeof(LightData) == 144, "LightData size does not match std140");
+
+// 分簇参数,分簇前向渲染的程序共享
+struct ClusterData
+{
+    // x、y方向的块数量,z方向的切片数量,w为光源数量
+    glm::ivec4 gridSize;
+    // x、y为每像素的块数量,z、w把观察空间深度的对数映射到切片: slice = log(depth) * z + w
+    glm::vec4 scale;
+};
+
+static_assert(offsetof(ClusterData, gridSize) == 0, "ClusterData.gridSize offset does not match std140");
+static_assert(offsetof(ClusterData, scale) == 16, "ClusterData.scale offset does not match std140");
+static_assert(sizeof(ClusterData) == 32, "ClusterData size does not match std140");
+
+// 阴影参数,平行光的级联阴影与点光源的立方体阴影共用
+struct ShadowData
+{
+    // 每级把世界坐标变换到阴影贴图的纹理坐标与深度,均为0到1
+    glm::mat4 cascadeMatrices[3];
+    // 每级覆盖到的观察空间深度
+    glm::vec4 cascadeSplits;
+    // 每级一个纹素在世界空间中的大小,用于沿法线偏移采样位置
+    glm::vec4 cascadeTexelSizes;
+    // 点光源阴影,xyz为光源位置,w为影响半径,阴影贴图保存到光源的距离除以半径
+    glm::vec4 pointShadowBounds;
+    // x为平行光深度偏移,y为点光源深度偏移,z为平行光法线偏移的纹素数量,w为点光源法线偏移占距离的比例
+    glm::vec4 shadowBias;
+};
+
+static_assert(offsetof(ShadowData, cascadeMatrices) == 0, "ShadowData.cascadeMatrices offset does not match std140");
+static_assert(offsetof(ShadowData, cascadeSplits) == 192, "ShadowData.cascadeSplits offset does not match std140");
+static_assert(offsetof(ShadowData, cascadeTexelSizes) == 208, "ShadowData.cascadeTexelSizes offset does not match std140");
+static_assert(offsetof(ShadowData, pointShadowBounds) == 224, "ShadowData.pointShadowBounds offset does not match std140");
+static_assert(offsetof(ShadowData, shadowBias) == 240, "ShadowData.shadowBias offset does not match std140");
+static_assert(sizeof(ShadowData) == 256, "ShadowData size does not match std140");
+
+#endif //OPENGLTUTORIAL_UNIFORMBLOCKS_H
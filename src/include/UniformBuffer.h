@@ -0,0 +1,44 @@
+#ifndef OPENGLTUTORIAL_UNIFORMBUFFER_H
+#define OPENGLTUTORIAL_UNIFORMBUFFER_H
+
+#include <string>
+#include <vector>
+#include "glad/glad.h"
+
+// uniform缓冲对象,绑定到固定的绑定点后被所有程序共享
+// 与Shader一样生命周期与上下文相同,不在析构时删除GL对象,避免在上下文销毁后调用GL
+class UniformBuffer
+{
+private:
+    // 缓冲对象id
+    GLuint id;
+    // 绑定点
+    GLuint binding;
+    // 缓冲大小
+    GLsizeiptr size;
+    // 缓冲内容的影子副本,只上传与副本不同的部分
+    std::vector<unsigned char> shadow;
+
+public:
+    // 构造函数,创建缓冲并绑定到绑定点
+    UniformBuffer(GLuint binding, GLsizeiptr size);
+    UniformBuffer(const UniformBuffer &) = delete;
+    UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+    // 更新缓冲数据,只上传与上一次内容不同的字节范围,完全相同时不调用GL
+    void update(const void *data, GLsizeiptr length, GLintptr offset = 0);
+    // 更新整个缓冲,T为UniformBlocks.h中的镜像结构
+    template <typename T>
+    void update(const T &data)
+    {
+        static_assert(sizeof(T) % 16 == 0, "std140 block size must be a multiple of 16");
+        update(&data, sizeof(T));
+    }
+    // 重新绑定到绑定点
+    void bind();
+
+    // 根据块名查找绑定点及C++端结构大小,不是共享块时返回false
+    static bool findBlock(const std::string &name, GLuint &binding, GLsizeiptr &size);
+};
+
+#endif //OPENGLTUTORIAL_UNIFORMBUFFER_H
@@ -0,0 +1,632 @@
+#include "BVH.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OPENGLTUTORIAL_BVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+// 包围盒表面积的一半,SAH只比较相对大小
+static float halfArea(const glm::vec3 &minimum, const glm::vec3 &maximum)
+{
+    glm::vec3 size = glm::max(maximum - minimum, glm::vec3(0.0f));
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+// 测试节点的4个子节点与视锥体,返回可见子节点的位掩码,insideMask为完全在视锥体内的子节点
+static int testNodeFrustum(const BVH::Node &node, const Frustum &frustum, int &insideMask)
+{
+#ifdef OPENGLTUTORIAL_BVH_SSE
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 minX = _mm_load_ps(node.minX), maxX = _mm_load_ps(node.maxX);
+    __m128 minY = _mm_load_ps(node.minY), maxY = _mm_load_ps(node.maxY);
+    __m128 minZ = _mm_load_ps(node.minZ), maxZ = _mm_load_ps(node.maxZ);
+    __m128 centerX = _mm_mul_ps(_mm_add_ps(minX, maxX), half), extentX = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+    __m128 centerY = _mm_mul_ps(_mm_add_ps(minY, maxY), half), extentY = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+    __m128 centerZ = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half), extentZ = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+    __m128 outside = zero;
+    __m128 intersecting = zero;
+    for(const glm::vec4 &plane : frustum.planes)
+    {
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), centerX), _mm_mul_ps(_mm_set1_ps(plane.y), centerY)),
+                                     _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), centerZ), _mm_set1_ps(plane.w)));
+        __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), extentX), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), extentY)),
+                                   _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), extentZ));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        intersecting = _mm_or_ps(intersecting, _mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+    }
+    __m128i valid = _mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(node.count)), _mm_setzero_si128());
+    int visibleMask = ~_mm_movemask_ps(outside) & _mm_movemask_ps(_mm_castsi128_ps(valid));
+    insideMask = visibleMask & ~_mm_movemask_ps(intersecting);
+    return visibleMask;
+#else
+    int visibleMask = 0;
+    insideMask = 0;
+    for(int slot = 0; slot < BVH::Width; slot++)
+    {
+        if(0 == node.count[slot])
+            continue;
+        glm::vec3 center(node.minX[slot] + node.maxX[slot], node.minY[slot] + node.maxY[slot], node.minZ[slot] + node.maxZ[slot]);
+        glm::vec3 extent(node.maxX[slot] - node.minX[slot], node.maxY[slot] - node.minY[slot], node.maxZ[slot] - node.minZ[slot]);
+        center *= 0.5f;
+        extent *= 0.5f;
+        bool bIsOutside = false;
+        bool bIsIntersecting = false;
+        for(const glm::vec4 &plane : frustum.planes)
+        {
+            float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            float radius = std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y + std::fabs(plane.z) * extent.z;
+            bIsOutside |= distance + radius < 0.0f;
+            bIsIntersecting |= distance - radius < 0.0f;
+        }
+        if(!bIsOutside)
+        {
+            visibleMask |= 1 << slot;
+            if(!bIsIntersecting)
+                insideMask |= 1 << slot;
+        }
+    }
+    return visibleMask;
+#endif
+}
+
+// 测试节点的4个子节点与射线,返回相交子节点的位掩码,nearDistances为进入包围盒的距离
+static int testNodeRay(const BVH::Node &node, const glm::vec3 &origin, const glm::vec3 &inverseDirection, float maxDistance,
+                       float *nearDistances)
+{
+#ifdef OPENGLTUTORIAL_BVH_SSE
+    __m128 originX = _mm_set1_ps(origin.x), inverseX = _mm_set1_ps(inverseDirection.x);
+    __m128 originY = _mm_set1_ps(origin.y), inverseY = _mm_set1_ps(inverseDirection.y);
+    __m128 originZ = _mm_set1_ps(origin.z), inverseZ = _mm_set1_ps(inverseDirection.z);
+    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), originX), inverseX);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), originX), inverseX);
+    __m128 nearDistance = _mm_max_ps(_mm_min_ps(t0, t1), _mm_setzero_ps());
+    __m128 farDistance = _mm_min_ps(_mm_max_ps(t0, t1), _mm_set1_ps(maxDistance));
+    t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), originY), inverseY);
+    t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), originY), inverseY);
+    nearDistance = _mm_max_ps(nearDistance, _mm_min_ps(t0, t1));
+    farDistance = _mm_min_ps(farDistance, _mm_max_ps(t0, t1));
+    t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), originZ), inverseZ);
+    t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), originZ), inverseZ);
+    nearDistance = _mm_max_ps(nearDistance, _mm_min_ps(t0, t1));
+    farDistance = _mm_min_ps(farDistance, _mm_max_ps(t0, t1));
+    _mm_storeu_ps(nearDistances, nearDistance);
+    __m128i valid = _mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(node.count)), _mm_setzero_si128());
+    return _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(nearDistance, farDistance), _mm_castsi128_ps(valid)));
+#else
+    int hitMask = 0;
+    for(int slot = 0; slot < BVH::Width; slot++)
+    {
+        if(0 == node.count[slot])
+            continue;
+        glm::vec3 t0 = (glm::vec3(node.minX[slot], node.minY[slot], node.minZ[slot]) - origin) * inverseDirection;
+        glm::vec3 t1 = (glm::vec3(node.maxX[slot], node.maxY[slot], node.maxZ[slot]) - origin) * inverseDirection;
+        glm::vec3 nearPoint = glm::min(t0, t1);
+        glm::vec3 farPoint = glm::max(t0, t1);
+        float nearDistance = std::max(std::max(nearPoint.x, nearPoint.y), std::max(nearPoint.z, 0.0f));
+        float farDistance = std::min(std::min(farPoint.x, farPoint.y), std::min(farPoint.z, maxDistance));
+        nearDistances[slot] = nearDistance;
+        if(nearDistance <= farDistance)
+            hitMask |= 1 << slot;
+    }
+    return hitMask;
+#endif
+}
+
+// 点到包围盒距离的平方
+static float distanceSquared(const glm::vec3 &point, const glm::vec3 &minimum, const glm::vec3 &maximum)
+{
+    glm::vec3 offset = glm::max(glm::max(minimum - point, point - maximum), glm::vec3(0.0f));
+    return glm::dot(offset, offset);
+}
+
+// 构建,bounds为每个物体的包围盒
+void BVH::build(const BoxBounds &bounds)
+{
+    uint32_t primitiveCount = (uint32_t)bounds.size();
+    nodes.clear();
+    parentSlots.clear();
+    primitiveIndices.resize(primitiveCount);
+    primitivePositions.resize(primitiveCount);
+    leafSlots.assign(primitiveCount, 0);
+    orderedBounds.resize(primitiveCount);
+    if(0 == primitiveCount)
+        return;
+
+    std::vector<BuildPrimitive> primitives(primitiveCount);
+    for(uint32_t i = 0; i < primitiveCount; i++)
+    {
+        glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+        glm::vec3 extent(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+        primitives[i].minimum = center - extent;
+        primitives[i].maximum = center + extent;
+        primitives[i].centroid = center;
+        primitives[i].index = i;
+    }
+    std::vector<BuildNode> buildNodes;
+    buildNodes.reserve((size_t)primitiveCount * 2);
+    int32_t root = buildBinary(buildNodes, primitives, 0, primitiveCount, 0);
+
+    // 物体按树的顺序排列
+    for(uint32_t position = 0; position < primitiveCount; position++)
+    {
+        uint32_t index = primitives[position].index;
+        primitiveIndices[position] = index;
+        primitivePositions[index] = position;
+        orderedBounds.set(position, primitives[position].minimum, primitives[position].maximum);
+    }
+
+    nodes.reserve(buildNodes.size() / 2 + 1);
+    collapse(buildNodes, root);
+}
+
+// 按SAH递归构建二叉树,返回节点下标
+int32_t BVH::buildBinary(std::vector<BuildNode> &buildNodes, std::vector<BuildPrimitive> &primitives,
+                         uint32_t begin, uint32_t end, int depth)
+{
+    BuildNode node;
+    node.minimum = glm::vec3(FLT_MAX);
+    node.maximum = glm::vec3(-FLT_MAX);
+    glm::vec3 centroidMinimum(FLT_MAX);
+    glm::vec3 centroidMaximum(-FLT_MAX);
+    for(uint32_t i = begin; i < end; i++)
+    {
+        const BuildPrimitive &primitive = primitives[i];
+        node.minimum = glm::min(node.minimum, primitive.minimum);
+        node.maximum = glm::max(node.maximum, primitive.maximum);
+        centroidMinimum = glm::min(centroidMinimum, primitive.centroid);
+        centroidMaximum = glm::max(centroidMaximum, primitive.centroid);
+    }
+    node.first = begin;
+    node.count = end - begin;
+    node.left = -1;
+    node.right = -1;
+    int32_t nodeIndex = (int32_t)buildNodes.size();
+    buildNodes.push_back(node);
+    if(node.count <= 2)
+        return nodeIndex;
+
+    // 沿中心点范围最大的轴分箱
+    glm::vec3 centroidExtent = centroidMaximum - centroidMinimum;
+    int axis = 0;
+    if(centroidExtent.y > centroidExtent[axis])
+        axis = 1;
+    if(centroidExtent.z > centroidExtent[axis])
+        axis = 2;
+    uint32_t middle = begin;
+    if(centroidExtent[axis] > 0.0f && depth < MaxSAHDepth)
+    {
+        struct Bin
+        {
+            glm::vec3 minimum;
+            glm::vec3 maximum;
+            uint32_t count;
+        };
+        Bin bins[BinCount];
+        for(Bin &bin : bins)
+        {
+            bin.minimum = glm::vec3(FLT_MAX);
+            bin.maximum = glm::vec3(-FLT_MAX);
+            bin.count = 0;
+        }
+        float binScale = (float)BinCount / centroidExtent[axis];
+        auto binOf = [&](const BuildPrimitive &primitive)
+        {
+            int bin = (int)((primitive.centroid[axis] - centroidMinimum[axis]) * binScale);
+            return bin < BinCount - 1 ? bin : BinCount - 1;
+        };
+        for(uint32_t i = begin; i < end; i++)
+        {
+            Bin &bin = bins[binOf(primitives[i])];
+            bin.minimum = glm::min(bin.minimum, primitives[i].minimum);
+            bin.maximum = glm::max(bin.maximum, primitives[i].maximum);
+            bin.count++;
+        }
+
+        // 从右往左累计右侧的面积与数量,再从左往右求每个切分位置的代价
+        float rightCosts[BinCount];
+        glm::vec3 rightMinimum(FLT_MAX), rightMaximum(-FLT_MAX);
+        uint32_t rightCount = 0;
+        for(int i = BinCount - 1; i > 0; i--)
+        {
+            rightMinimum = glm::min(rightMinimum, bins[i].minimum);
+            rightMaximum = glm::max(rightMaximum, bins[i].maximum);
+            rightCount += bins[i].count;
+            rightCosts[i] = rightCount ? halfArea(rightMinimum, rightMaximum) * (float)rightCount : 0.0f;
+        }
+        glm::vec3 leftMinimum(FLT_MAX), leftMaximum(-FLT_MAX);
+        uint32_t leftCount = 0;
+        float bestCost = FLT_MAX;
+        int bestSplit = -1;
+        for(int i = 0; i < BinCount - 1; i++)
+        {
+            leftMinimum = glm::min(leftMinimum, bins[i].minimum);
+            leftMaximum = glm::max(leftMaximum, bins[i].maximum);
+            leftCount += bins[i].count;
+            if(0 == leftCount || node.count == leftCount)
+                continue;
+            float cost = halfArea(leftMinimum, leftMaximum) * (float)leftCount + rightCosts[i + 1];
+            if(cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+
+        // 遍历代价按一次相交测试计算,切分不比叶子更好且物体不多时作为叶子
+        float nodeArea = halfArea(node.minimum, node.maximum);
+        if(node.count <= MaxLeafSize && (bestSplit < 0 || nodeArea + bestCost >= nodeArea * (float)node.count))
+            return nodeIndex;
+        if(bestSplit >= 0)
+        {
+            middle = (uint32_t)(std::partition(primitives.begin() + begin, primitives.begin() + end,
+                                               [&](const BuildPrimitive &primitive) { return binOf(primitive) <= bestSplit; }) - primitives.begin());
+        }
+    }
+    else if(node.count <= MaxLeafSize)
+    {
+        return nodeIndex;
+    }
+
+    // 无法按SAH切分时按中位数切分
+    if(middle == begin || middle == end)
+    {
+        middle = begin + node.count / 2;
+        std::nth_element(primitives.begin() + begin, primitives.begin() + middle, primitives.begin() + end,
+                         [&](const BuildPrimitive &a, const BuildPrimitive &b) { return a.centroid[axis] < b.centroid[axis]; });
+    }
+
+    int32_t left = buildBinary(buildNodes, primitives, begin, middle, depth + 1);
+    int32_t right = buildBinary(buildNodes, primitives, middle, end, depth + 1);
+    buildNodes[nodeIndex].left = left;
+    buildNodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+// 把二叉树合并为4叉节点,每次展开表面积最大的内部节点直到4个子节点,返回节点下标
+uint32_t BVH::collapse(const std::vector<BuildNode> &buildNodes, int32_t buildIndex)
+{
+    int32_t candidates[Width];
+    int candidateCount = 0;
+    const BuildNode &buildNode = buildNodes[buildIndex];
+    if(buildNode.left < 0)
+    {
+        // 只有根节点可能是叶子
+        candidates[candidateCount++] = buildIndex;
+    }
+    else
+    {
+        candidates[candidateCount++] = buildNode.left;
+        candidates[candidateCount++] = buildNode.right;
+    }
+    while(candidateCount < Width)
+    {
+        int expand = -1;
+        float largestArea = -1.0f;
+        for(int i = 0; i < candidateCount; i++)
+        {
+            const BuildNode &candidate = buildNodes[candidates[i]];
+            float area = halfArea(candidate.minimum, candidate.maximum);
+            if(candidate.left >= 0 && area > largestArea)
+            {
+                largestArea = area;
+                expand = i;
+            }
+        }
+        if(expand < 0)
+            break;
+        const BuildNode &candidate = buildNodes[candidates[expand]];
+        candidates[expand] = candidate.left;
+        candidates[candidateCount++] = candidate.right;
+    }
+
+    uint32_t nodeIndex = (uint32_t)nodes.size();
+    nodes.push_back(Node());
+    parentSlots.push_back(0xFFFFFFFFu);
+    for(int slot = 0; slot < Width; slot++)
+    {
+        Node &node = nodes[nodeIndex];
+        if(slot >= candidateCount)
+        {
+            node.minX[slot] = node.minY[slot] = node.minZ[slot] = FLT_MAX;
+            node.maxX[slot] = node.maxY[slot] = node.maxZ[slot] = -FLT_MAX;
+            node.children[slot] = EmptyChild;
+            node.first[slot] = 0;
+            node.count[slot] = 0;
+            continue;
+        }
+        const BuildNode &child = buildNodes[candidates[slot]];
+        node.minX[slot] = child.minimum.x;
+        node.minY[slot] = child.minimum.y;
+        node.minZ[slot] = child.minimum.z;
+        node.maxX[slot] = child.maximum.x;
+        node.maxY[slot] = child.maximum.y;
+        node.maxZ[slot] = child.maximum.z;
+        node.first[slot] = child.first;
+        node.count[slot] = child.count;
+        if(child.left < 0)
+        {
+            node.children[slot] = LeafChild;
+            for(uint32_t position = child.first; position < child.first + child.count; position++)
+            {
+                leafSlots[position] = nodeIndex * Width + slot;
+            }
+        }
+        else
+        {
+            // 递归时nodes可能重新分配,之后通过下标重新访问
+            uint32_t childIndex = collapse(buildNodes, candidates[slot]);
+            nodes[nodeIndex].children[slot] = (int32_t)childIndex;
+            parentSlots[childIndex] = nodeIndex * Width + slot;
+        }
+    }
+    return nodeIndex;
+}
+
+// 重新计算节点某个子节点的包围盒
+void BVH::refitSlot(uint32_t nodeIndex, int slot)
+{
+    Node &node = nodes[nodeIndex];
+    glm::vec3 minimum(FLT_MAX);
+    glm::vec3 maximum(-FLT_MAX);
+    if(LeafChild == node.children[slot])
+    {
+        for(uint32_t position = node.first[slot]; position < node.first[slot] + node.count[slot]; position++)
+        {
+            glm::vec3 center(orderedBounds.centerX[position], orderedBounds.centerY[position], orderedBounds.centerZ[position]);
+            glm::vec3 extent(orderedBounds.extentX[position], orderedBounds.extentY[position], orderedBounds.extentZ[position]);
+            minimum = glm::min(minimum, center - extent);
+            maximum = glm::max(maximum, center + extent);
+        }
+    }
+    else if(node.children[slot] >= 0)
+    {
+        const Node &child = nodes[node.children[slot]];
+        for(int i = 0; i < Width; i++)
+        {
+            if(0 == child.count[i])
+                continue;
+            minimum = glm::min(minimum, glm::vec3(child.minX[i], child.minY[i], child.minZ[i]));
+            maximum = glm::max(maximum, glm::vec3(child.maxX[i], child.maxY[i], child.maxZ[i]));
+        }
+    }
+    else
+    {
+        return;
+    }
+    node.minX[slot] = minimum.x;
+    node.minY[slot] = minimum.y;
+    node.minZ[slot] = minimum.z;
+    node.maxX[slot] = maximum.x;
+    node.maxY[slot] = maximum.y;
+    node.maxZ[slot] = maximum.z;
+}
+
+// 物体移动后保持树结构更新所有包围盒,子节点下标大于父节点,从后往前更新即可
+void BVH::refit(const BoxBounds &bounds)
+{
+    for(uint32_t position = 0; position < (uint32_t)primitiveIndices.size(); position++)
+    {
+        uint32_t index = primitiveIndices[position];
+        orderedBounds.centerX[position] = bounds.centerX[index];
+        orderedBounds.centerY[position] = bounds.centerY[index];
+        orderedBounds.centerZ[position] = bounds.centerZ[index];
+        orderedBounds.extentX[position] = bounds.extentX[index];
+        orderedBounds.extentY[position] = bounds.extentY[index];
+        orderedBounds.extentZ[position] = bounds.extentZ[index];
+    }
+    for(size_t nodeIndex = nodes.size(); nodeIndex-- > 0;)
+    {
+        for(int slot = 0; slot < Width; slot++)
+        {
+            refitSlot((uint32_t)nodeIndex, slot);
+        }
+    }
+}
+
+// 单个物体移动后更新它到根节点路径上的包围盒
+void BVH::update(uint32_t index, const glm::vec3 &minimum, const glm::vec3 &maximum)
+{
+    uint32_t position = primitivePositions[index];
+    orderedBounds.set(position, minimum, maximum);
+    uint32_t slot = leafSlots[position];
+    while(0xFFFFFFFFu != slot)
+    {
+        refitSlot(slot / Width, slot % Width);
+        slot = parentSlots[slot / Width];
+    }
+}
+
+// 视锥体剔除,visible为可见物体下标,按树的顺序排列,返回可见数量
+size_t BVH::cullFrustum(const Frustum &frustum, std::vector<uint32_t> &visible) const
+{
+    visible.clear();
+    if(nodes.empty())
+        return 0;
+
+    FrustumCuller::InstructionSet instructionSet = FrustumCuller::getBestInstructionSet();
+    uint32_t stack[StackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while(stackSize > 0)
+    {
+        const Node &node = nodes[stack[--stackSize]];
+        int insideMask = 0;
+        int visibleMask = testNodeFrustum(node, frustum, insideMask);
+        for(int slot = 0; slot < Width; slot++)
+        {
+            if(!(visibleMask & (1 << slot)))
+                continue;
+            uint32_t first = node.first[slot];
+            uint32_t count = node.count[slot];
+            if(insideMask & (1 << slot))
+            {
+                // 完全在视锥体内,子树的物体全部可见
+                visible.insert(visible.end(), primitiveIndices.begin() + first, primitiveIndices.begin() + first + count);
+            }
+            else if(LeafChild == node.children[slot])
+            {
+                // 与视锥体相交的叶子逐个测试物体,结果为树中位置,再转换为物体下标
+                size_t offset = visible.size();
+                visible.resize(offset + count);
+                size_t visibleCount = FrustumCuller::cullBoxes(frustum, orderedBounds, first, first + count, visible.data() + offset, instructionSet);
+                for(size_t i = offset; i < offset + visibleCount; i++)
+                {
+                    visible[i] = primitiveIndices[visible[i]];
+                }
+                visible.resize(offset + visibleCount);
+            }
+            else
+            {
+                stack[stackSize++] = (uint32_t)node.children[slot];
+            }
+        }
+    }
+    return visible.size();
+}
+
+// 射线检测,子节点按进入距离从近到远访问,已找到的最近距离用于裁剪更远的子节点
+bool BVH::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, BVHHit &hit) const
+{
+    if(nodes.empty())
+        return false;
+
+    glm::vec3 inverseDirection = 1.0f / direction;
+    float bestDistance = maxDistance;
+    bool bIsHit = false;
+    struct StackEntry
+    {
+        uint32_t node;
+        float distance;
+    };
+    StackEntry stack[StackSize];
+    int stackSize = 0;
+    stack[stackSize++] = {0, 0.0f};
+    while(stackSize > 0)
+    {
+        StackEntry entry = stack[--stackSize];
+        if(entry.distance > bestDistance)
+            continue;
+        const Node &node = nodes[entry.node];
+        float nearDistances[Width];
+        int hitMask = testNodeRay(node, origin, inverseDirection, bestDistance, nearDistances);
+
+        // 相交的内部子节点按距离从远到近入栈,近的先出栈
+        StackEntry children[Width];
+        int childCount = 0;
+        for(int slot = 0; slot < Width; slot++)
+        {
+            if(!(hitMask & (1 << slot)))
+                continue;
+            if(LeafChild == node.children[slot])
+            {
+                for(uint32_t position = node.first[slot]; position < node.first[slot] + node.count[slot]; position++)
+                {
+                    glm::vec3 center(orderedBounds.centerX[position], orderedBounds.centerY[position], orderedBounds.centerZ[position]);
+                    glm::vec3 extent(orderedBounds.extentX[position], orderedBounds.extentY[position], orderedBounds.extentZ[position]);
+                    glm::vec3 t0 = (center - extent - origin) * inverseDirection;
+                    glm::vec3 t1 = (center + extent - origin) * inverseDirection;
+                    glm::vec3 nearPoint = glm::min(t0, t1);
+                    glm::vec3 farPoint = glm::max(t0, t1);
+                    float nearDistance = std::max(std::max(nearPoint.x, nearPoint.y), std::max(nearPoint.z, 0.0f));
+                    float farDistance = std::min(std::min(farPoint.x, farPoint.y), std::min(farPoint.z, bestDistance));
+                    if(nearDistance <= farDistance)
+                    {
+                        bestDistance = nearDistance;
+                        hit.index = primitiveIndices[position];
+                        hit.distance = nearDistance;
+                        bIsHit = true;
+                    }
+                }
+            }
+            else
+            {
+                StackEntry child = {(uint32_t)node.children[slot], nearDistances[slot]};
+                int i = childCount++;
+                while(i > 0 && children[i - 1].distance < child.distance)
+                {
+                    children[i] = children[i - 1];
+                    i--;
+                }
+                children[i] = child;
+            }
+        }
+        for(int i = 0; i < childCount; i++)
+        {
+            stack[stackSize++] = children[i];
+        }
+    }
+    return bIsHit;
+}
+
+// 查询距离point最近的包围盒,子节点按距离从近到远访问
+bool BVH::findNearest(const glm::vec3 &point, float maxDistance, BVHHit &hit) const
+{
+    if(nodes.empty())
+        return false;
+
+    float bestDistanceSquared = maxDistance * maxDistance;
+    bool bIsHit = false;
+    struct StackEntry
+    {
+        uint32_t node;
+        float distanceSquared;
+    };
+    StackEntry stack[StackSize];
+    int stackSize = 0;
+    stack[stackSize++] = {0, 0.0f};
+    while(stackSize > 0)
+    {
+        StackEntry entry = stack[--stackSize];
+        if(entry.distanceSquared > bestDistanceSquared)
+            continue;
+        const Node &node = nodes[entry.node];
+        StackEntry children[Width];
+        int childCount = 0;
+        for(int slot = 0; slot < Width; slot++)
+        {
+            if(0 == node.count[slot])
+                continue;
+            float childDistanceSquared = distanceSquared(point, glm::vec3(node.minX[slot], node.minY[slot], node.minZ[slot]),
+                                                         glm::vec3(node.maxX[slot], node.maxY[slot], node.maxZ[slot]));
+            if(childDistanceSquared > bestDistanceSquared)
+                continue;
+            if(LeafChild == node.children[slot])
+            {
+                for(uint32_t position = node.first[slot]; position < node.first[slot] + node.count[slot]; position++)
+                {
+                    glm::vec3 center(orderedBounds.centerX[position], orderedBounds.centerY[position], orderedBounds.centerZ[position]);
+                    glm::vec3 extent(orderedBounds.extentX[position], orderedBounds.extentY[position], orderedBounds.extentZ[position]);
+                    float primitiveDistanceSquared = distanceSquared(point, center - extent, center + extent);
+                    if(primitiveDistanceSquared <= bestDistanceSquared)
+                    {
+                        bestDistanceSquared = primitiveDistanceSquared;
+                        hit.index = primitiveIndices[position];
+                        bIsHit = true;
+                    }
+                }
+            }
+            else
+            {
+                StackEntry child = {(uint32_t)node.children[slot], childDistanceSquared};
+                int i = childCount++;
+                while(i > 0 && children[i - 1].distanceSquared < child.distanceSquared)
+                {
+                    children[i] = children[i - 1];
+                    i--;
+                }
+                children[i] = child;
+            }
+        }
+        for(int i = 0; i < childCount; i++)
+        {
+            stack[stackSize++] = children[i];
+        }
+    }
+    if(bIsHit)
+        hit.distance = std::sqrt(bestDistanceSquared);
+    return bIsHit;
+}
@@ -8,6 +8,7 @@
 #include "stb_image.h"
 #include "Shader.h"
 #include "Camera.h"
+#include "GLStateCache.h"
 
 // GLFW窗口
 GLFWwindow *window = nullptr;
@@ -78,7 +79,7 @@ int main(int argc, char **argv)
     glEnable(GL_DEPTH_TEST);
 
     // 创建着色器
-    Shader firstShader("../shader/VertexShaderSource.glsl", "../shader/FragmentShaderSource.glsl");
+    Shader firstShader("VertexShaderSource.glsl", "FragmentShaderSource.glsl");
 
     // 顶点坐标数据
     GLfloat vertices[] =
@@ -339,11 +340,11 @@ void processInput(GLFWwindow *window)
 
     if(glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        GLStateCache::polygonMode(GL_LINE);
     }
 
     if(glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        GLStateCache::polygonMode(GL_FILL);
     }
 }
@@ -128,8 +128,8 @@ int main()
     };
 
     // 创建两个Shader
-    Shader lightShader("../shader/PhongLight/02/Light.vs.glsl","../shader/PhongLight/02/Light.fs.glsl");
-    Shader objShader("../shader/PhongLight/02/Cube.vs.glsl","../shader/PhongLight/02/Cube.fs.glsl");
+    Shader lightShader("PhongLight/02/Light.vs.glsl","PhongLight/02/Light.fs.glsl");
+    Shader objShader("PhongLight/02/Cube.vs.glsl","PhongLight/02/Cube.fs.glsl");
 
     // 立方体物体VBO
     GLuint cubeVBO;
@@ -187,15 +187,12 @@ int main()
         // 设置光物体着色器
         lightShader.use();
 
-        // 设置光物体顶点着色器模型矩阵
+        // 设置光物体顶点着色器模型视图裁剪矩阵
         glm::mat4 lightModel(1.0f);
         lightModel = glm::translate(lightModel, lightPos);
         lightModel = glm::scale(lightModel, glm::vec3(0.2));
-        lightShader.setUniformMatrix4fv("model", lightModel);
-        // 设置光物体顶点着色器视图矩阵
-        lightShader.setUniformMatrix4fv("view", view);
-        // 设置光物体顶点着色器裁剪矩阵
-        lightShader.setUniformMatrix4fv("projection", projection);
+        // 模型视图裁剪矩阵在CPU上每个物体只乘一次,而不是每个顶点都乘
+        lightShader.setUniformMatrix4fv("mvp", projection * view * lightModel);
 
         // 绘制光物体
         glBindVertexArray(lightVAO);
@@ -204,12 +201,13 @@ int main()
         // 设置立方体物体着色器
         objShader.use();
 
-        // 设置立方体物体顶点着色器模型矩阵、视图矩阵、裁剪矩阵
+        // 设置立方体物体顶点着色器模型视图裁剪矩阵、模型矩阵与法线矩阵
         glm::mat4 objModel(1.0f);
         objModel = glm::rotate(objModel, (float)(glfwGetTime()*0.5), glm::vec3(0.5f, 1.0f, 0.0f));
+        objShader.setUniformMatrix4fv("mvp", projection * view * objModel);
         objShader.setUniformMatrix4fv("model", objModel);
-        objShader.setUniformMatrix4fv("view", view);
-        objShader.setUniformMatrix4fv("projection", projection);
+        // 法线矩阵在CPU上求逆一次,顶点着色器中不再调用inverse
+        objShader.setUniformMatrix3fv("normalMatrix", glm::transpose(glm::inverse(glm::mat3(objModel))));
 
         // 相机位置
         objShader.setUniform3fv("cameraPosition", camera.getCameraPosition());
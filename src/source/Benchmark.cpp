@@ -0,0 +1,791 @@
+#include "Benchmark.h"
+#include "BVH.h"
+#include "BlockCompressor.h"
+#include "Camera.h"
+#include "ClusteredLighting.h"
+#include "FrustumCuller.h"
+#include "GLStateCache.h"
+#include "IndirectRenderer.h"
+#include "KTXTexture.h"
+#include "MipmapGenerator.h"
+#include "PointLightList.h"
+#include "RenderQueue.h"
+#include "RingBuffer.h"
+#include "Shader.h"
+#include "ShadowMaps.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+
+// 测量贴图加载使用的图片,及是否为颜色贴图
+static const char *TexturePaths[] = {"../texture/box_diffuse.png", "../texture/box_specular.png", "../texture/box_emission.jpg",
+                                     "../texture/wall.jpg"};
+static const bool TextureIsSRGB[] = {true, false, true, true};
+static const size_t TexturePathCount = sizeof(TexturePaths) / sizeof(TexturePaths[0]);
+// 测量光照与阴影时的箱子数量
+static const size_t LightingBoxCount = 10000;
+// 测量扩展时的线程数量
+static const size_t ThreadCounts[] = {1, 2, 4, 8, 16};
+
+// 从startTime到现在的毫秒数
+static double elapsed(std::chrono::steady_clock::time_point startTime)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// 与渲染循环相同的裁剪矩阵
+static glm::mat4 getProjection(const BenchmarkScene &scene)
+{
+    return glm::perspective(glm::radians(scene.camera->getCameraFOV()), (float)scene.width / (float)scene.height, 0.1f, scene.farPlane);
+}
+
+// 保存绘制开关,析构时恢复并按恢复后的开关重新选择箱子变体,测量不改变渲染循环的设置
+class ScopedSwitches
+{
+private:
+    const BenchmarkScene &scene;
+    bool bUseInstancing;
+    bool bUseIndirect;
+    bool bUseCulling;
+    bool bUseDeferred;
+    bool bUseClustered;
+    bool bUseShadows;
+    bool bUseAnimation;
+    bool bUseDirectionLight;
+
+public:
+    explicit ScopedSwitches(const BenchmarkScene &scene)
+        : scene(scene), bUseInstancing(*scene.switches.bUseInstancing), bUseIndirect(*scene.switches.bUseIndirect),
+          bUseCulling(*scene.switches.bUseCulling), bUseDeferred(*scene.switches.bUseDeferred),
+          bUseClustered(*scene.switches.bUseClustered), bUseShadows(*scene.switches.bUseShadows),
+          bUseAnimation(*scene.switches.bUseAnimation), bUseDirectionLight(*scene.switches.bUseDirectionLight)
+    {
+    }
+    ScopedSwitches(const ScopedSwitches &) = delete;
+    ScopedSwitches &operator=(const ScopedSwitches &) = delete;
+
+    ~ScopedSwitches()
+    {
+        *scene.switches.bUseInstancing = bUseInstancing;
+        *scene.switches.bUseIndirect = bUseIndirect;
+        *scene.switches.bUseCulling = bUseCulling;
+        *scene.switches.bUseDeferred = bUseDeferred;
+        *scene.switches.bUseClustered = bUseClustered;
+        *scene.switches.bUseShadows = bUseShadows;
+        *scene.switches.bUseAnimation = bUseAnimation;
+        *scene.switches.bUseDirectionLight = bUseDirectionLight;
+        scene.updateBoxShader();
+    }
+};
+
+// 依次运行所有测量
+void Benchmark::run(BenchmarkScene &scene)
+{
+    measureUniformSetters();
+    // 剔除与层次结构使用绘制路径测量最后的1M个箱子
+    measureDrawPaths(scene);
+    measureCulling(scene);
+    measureBVH(scene);
+    measureLighting(scene);
+    measureShadows(scene);
+    measurePrepare(scene);
+    measureTextureLoading(scene);
+    measureCompression(scene);
+    measureMipmaps(scene);
+}
+
+// 10k个物体逐个设置mat4 Uniform的耗时,按名字查询位置与通过句柄设置比较,以及值未改变时影子副本跳过上传的耗时
+// 使用单独编译的光源程序,只上传不绘制,结果为每次设置的平均纳秒数
+void Benchmark::measureUniformSetters()
+{
+    const size_t objectCount = 10000;
+    std::vector<glm::mat4> models(objectCount);
+    for(size_t i = 0; i < objectCount; i++)
+        models[i] = glm::translate(glm::mat4(1.0f), glm::vec3((float)i, 0.0f, 0.0f));
+    Shader shader("PhongLight/04/Light.vs.glsl", "PhongLight/04/Light.fs.glsl");
+    shader.use();
+    UniformHandle mvpHandle = shader.uniform("mvp");
+    GLuint program = shader.getId();
+    auto measure = [&](const std::function<void(size_t)> &setUniform)
+    {
+        for(int frame = 0; frame < WarmupFrames; frame++)
+        {
+            for(size_t i = 0; i < objectCount; i++)
+                setUniform(i);
+        }
+        glFinish();
+        auto startTime = std::chrono::steady_clock::now();
+        for(int frame = 0; frame < MeasureFrames; frame++)
+        {
+            for(size_t i = 0; i < objectCount; i++)
+                setUniform(i);
+        }
+        glFinish();
+        return elapsed(startTime) * 1000000.0 / ((double)MeasureFrames * objectCount);
+    };
+    // 每个物体按名字查询位置后上传,与句柄化之前的写法相同
+    double locationNanoseconds = measure([&](size_t i)
+    {
+        glUniformMatrix4fv(glGetUniformLocation(program, "mvp"), 1, GL_FALSE, &models[i][0][0]);
+    });
+    // 每个物体的值都不同,每次都上传
+    double handleNanoseconds = measure([&](size_t i)
+    {
+        shader.set(mvpHandle, models[i]);
+    });
+    // 所有物体使用相同的值,只有第一次上传,其余与影子副本比较后跳过
+    double unchangedNanoseconds = measure([&](size_t)
+    {
+        shader.set(mvpHandle, models[0]);
+    });
+    std::cout << "## Benchmark ## uniform setters " << objectCount << " objects, glGetUniformLocation + glUniformMatrix4fv = "
+              << locationNanoseconds << " ns, handle = " << handleNanoseconds << " ns, handle unchanged = " << unchangedNanoseconds
+              << " ns per set" << std::endl;
+}
+
+// 三种绘制路径与渲染队列收集排序的耗时,箱子数量从10增长到1M,最后保持1M个箱子,以及环形缓冲的状态
+// 逐个绘制超过100k后太慢不再测量,间接绘制只在支持时测量
+void Benchmark::measureDrawPaths(BenchmarkScene &scene)
+{
+    ScopedSwitches switches(scene);
+    const size_t benchmarkCounts[] = {10, 100, 1000, 10000, 100000, 1000000};
+    for(size_t count : benchmarkCounts)
+    {
+        scene.setBoxCount(count);
+        // 每帧总耗时,以及提交绘制命令的CPU耗时,依次为逐个绘制、实例化绘制与间接绘制
+        double milliseconds[3] = {-1.0, -1.0, -1.0};
+        double submitMilliseconds[3] = {-1.0, -1.0, -1.0};
+        for(int path = 0; path < 3; path++)
+        {
+            *scene.switches.bUseInstancing = (1 == path);
+            *scene.switches.bUseIndirect = (2 == path);
+            if((0 == path && count > 100000) || (2 == path && !scene.indirectRenderer))
+                continue;
+            scene.updateBoxShader();
+            for(int frame = 0; frame < WarmupFrames; frame++)
+                scene.renderScene();
+            glFinish();
+            double submitTime = 0.0;
+            auto startTime = std::chrono::steady_clock::now();
+            for(int frame = 0; frame < MeasureFrames; frame++)
+            {
+                auto submitStartTime = std::chrono::steady_clock::now();
+                scene.renderScene();
+                submitTime += elapsed(submitStartTime);
+            }
+            glFinish();
+            milliseconds[path] = elapsed(startTime) / MeasureFrames;
+            submitMilliseconds[path] = submitTime / MeasureFrames;
+        }
+        // 间接绘制的可见箱子数量,读回时等待GPU,不支持间接绘制时该路径被跳过
+        GLuint indirectVisible = scene.indirectRenderer && milliseconds[2] >= 0.0 ? scene.indirectRenderer->readDrawCount(0) : 0;
+
+        // 渲染队列收集与排序的耗时,不剔除,每个箱子一个绘制包,预热后容量不应再变化
+        double queueMilliseconds;
+        size_t queueCapacity;
+        {
+            ScopedSwitches queueSwitches(scene);
+            *scene.switches.bUseInstancing = false;
+            *scene.switches.bUseIndirect = false;
+            *scene.switches.bUseCulling = false;
+            scene.updateBoxShader();
+            glm::mat4 view = scene.camera->getViewMatrix();
+            glm::mat4 viewProjection = getProjection(scene) * view;
+            scene.cullBoxes(viewProjection);
+            for(int frame = 0; frame < WarmupFrames; frame++)
+                scene.fillRenderQueue(view, viewProjection);
+            queueCapacity = scene.renderQueue->getCapacity();
+            auto queueStartTime = std::chrono::steady_clock::now();
+            for(int frame = 0; frame < MeasureFrames; frame++)
+                scene.fillRenderQueue(view, viewProjection);
+            queueMilliseconds = elapsed(queueStartTime) / MeasureFrames;
+        }
+
+        std::cout << "## Benchmark ## boxes = " << count << ", draw loop = ";
+        if(milliseconds[0] < 0.0)
+            std::cout << "skipped";
+        else
+            std::cout << milliseconds[0] << " ms (submit " << submitMilliseconds[0] << " ms)";
+        std::cout << ", instanced = " << milliseconds[1] << " ms (submit " << submitMilliseconds[1] << " ms)";
+        if(milliseconds[2] < 0.0)
+            std::cout << ", indirect = unsupported";
+        else
+            std::cout << ", indirect = " << milliseconds[2] << " ms (submit " << submitMilliseconds[2] << " ms, visible " << indirectVisible << ")";
+        std::cout << ", queue fill and sort = " << queueMilliseconds << " ms"
+                  << (queueCapacity == scene.renderQueue->getCapacity() ? "" : " (reallocated)") << std::endl;
+    }
+    std::cout << "## Benchmark ## ring buffer " << (scene.frameRing->isPersistent() ? "persistent" : "orphaned") << ", region = "
+              << scene.frameRing->getRegionSize() / (1024 * 1024) << " MB, stalls = " << scene.frameRing->getStallCount() << std::endl;
+}
+
+// 当前所有箱子的视锥体剔除耗时,依次测量各指令集单线程以及最快指令集多线程
+void Benchmark::measureCulling(const BenchmarkScene &scene)
+{
+    Frustum frustum = Frustum::fromMatrix(getProjection(scene) * scene.camera->getViewMatrix());
+    FrustumCuller frustumCuller;
+    std::vector<uint32_t> visible;
+    auto measure = [&](bool bIsBox)
+    {
+        for(int frame = 0; frame < WarmupFrames; frame++)
+            bIsBox ? frustumCuller.cull(frustum, *scene.boxAABBs, visible) : frustumCuller.cull(frustum, *scene.boxBounds, visible);
+        auto startTime = std::chrono::steady_clock::now();
+        for(int frame = 0; frame < MeasureFrames; frame++)
+            bIsBox ? frustumCuller.cull(frustum, *scene.boxAABBs, visible) : frustumCuller.cull(frustum, *scene.boxBounds, visible);
+        return elapsed(startTime) / MeasureFrames;
+    };
+    const FrustumCuller::InstructionSet instructionSets[] = {FrustumCuller::Scalar, FrustumCuller::SSE, FrustumCuller::AVX2};
+    for(int shape = 0; shape < 2; shape++)
+    {
+        bool bIsBox = (1 == shape);
+        std::cout << "## Benchmark ## cull " << scene.boxModels->size() << (bIsBox ? " boxes" : " spheres");
+        frustumCuller.setThreadPool(nullptr);
+        for(FrustumCuller::InstructionSet set : instructionSets)
+        {
+            if(!FrustumCuller::isSupported(set))
+                continue;
+            frustumCuller.setInstructionSet(set);
+            std::cout << ", " << FrustumCuller::getInstructionSetName(set) << " = " << measure(bIsBox) << " ms";
+        }
+        frustumCuller.setThreadPool(scene.threadPool);
+        std::cout << ", " << scene.threadPool->getThreadCount() << " threads = " << measure(bIsBox) << " ms"
+                  << ", visible = " << visible.size() << std::endl;
+    }
+}
+
+// 当前所有箱子的层次结构构建、更新与查询耗时,与逐个测试比较并检查结果是否一致
+// 在单独的层次结构上测量,不改变场景用于剔除与拾取的层次结构
+void Benchmark::measureBVH(const BenchmarkScene &scene)
+{
+    const BoxBounds &boxAABBs = *scene.boxAABBs;
+    BVH bvh;
+    auto startTime = std::chrono::steady_clock::now();
+    bvh.build(boxAABBs);
+    double buildMilliseconds = elapsed(startTime);
+    BoxBounds movedAABBs = boxAABBs;
+    for(float &x : movedAABBs.centerX)
+        x += 0.25f;
+    startTime = std::chrono::steady_clock::now();
+    bvh.refit(movedAABBs);
+    double refitMilliseconds = elapsed(startTime);
+    const int updateCount = 1000;
+    std::mt19937 random(7);
+    startTime = std::chrono::steady_clock::now();
+    for(int i = 0; i < updateCount; i++)
+    {
+        uint32_t index = (uint32_t)(random() % boxAABBs.size());
+        glm::vec3 center(boxAABBs.centerX[index], boxAABBs.centerY[index], boxAABBs.centerZ[index]);
+        glm::vec3 extent(boxAABBs.extentX[index], boxAABBs.extentY[index], boxAABBs.extentZ[index]);
+        bvh.update(index, center - extent, center + extent);
+    }
+    double updateMilliseconds = elapsed(startTime);
+    bvh.refit(boxAABBs);
+    std::cout << "## Benchmark ## BVH " << boxAABBs.size() << " boxes, " << bvh.getNodeCount() << " nodes, build = " << buildMilliseconds
+              << " ms, refit = " << refitMilliseconds << " ms, " << updateCount << " updates = " << updateMilliseconds << " ms" << std::endl;
+
+    // 视锥体查询与单线程逐个测试比较
+    Frustum frustum = Frustum::fromMatrix(getProjection(scene) * scene.camera->getViewMatrix());
+    FrustumCuller frustumCuller;
+    std::vector<uint32_t> bruteVisible;
+    startTime = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < MeasureFrames; frame++)
+        frustumCuller.cull(frustum, boxAABBs, bruteVisible);
+    double bruteCullMilliseconds = elapsed(startTime) / MeasureFrames;
+    std::vector<uint32_t> visible;
+    startTime = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < MeasureFrames; frame++)
+        bvh.cullFrustum(frustum, visible);
+    double cullMilliseconds = elapsed(startTime) / MeasureFrames;
+    std::sort(visible.begin(), visible.end());
+
+    // 逐个测试所有包围盒的射线检测与最近物体查询
+    auto bruteRaycast = [&](const glm::vec3 &origin, const glm::vec3 &direction, BVHHit &hit)
+    {
+        glm::vec3 inverseDirection = 1.0f / direction;
+        bool bIsHit = false;
+        hit.distance = FLT_MAX;
+        for(size_t i = 0; i < boxAABBs.size(); i++)
+        {
+            glm::vec3 center(boxAABBs.centerX[i], boxAABBs.centerY[i], boxAABBs.centerZ[i]);
+            glm::vec3 extent(boxAABBs.extentX[i], boxAABBs.extentY[i], boxAABBs.extentZ[i]);
+            glm::vec3 t0 = (center - extent - origin) * inverseDirection;
+            glm::vec3 t1 = (center + extent - origin) * inverseDirection;
+            glm::vec3 nearPoint = glm::min(t0, t1);
+            glm::vec3 farPoint = glm::max(t0, t1);
+            float nearDistance = std::max(std::max(nearPoint.x, nearPoint.y), std::max(nearPoint.z, 0.0f));
+            float farDistance = std::min(std::min(farPoint.x, farPoint.y), farPoint.z);
+            if(nearDistance <= farDistance && nearDistance < hit.distance)
+            {
+                hit.index = (uint32_t)i;
+                hit.distance = nearDistance;
+                bIsHit = true;
+            }
+        }
+        return bIsHit;
+    };
+    auto bruteNearest = [&](const glm::vec3 &point)
+    {
+        float bestDistanceSquared = FLT_MAX;
+        for(size_t i = 0; i < boxAABBs.size(); i++)
+        {
+            glm::vec3 center(boxAABBs.centerX[i], boxAABBs.centerY[i], boxAABBs.centerZ[i]);
+            glm::vec3 extent(boxAABBs.extentX[i], boxAABBs.extentY[i], boxAABBs.extentZ[i]);
+            glm::vec3 offset = glm::max(glm::abs(point - center) - extent, glm::vec3(0.0f));
+            bestDistanceSquared = std::min(bestDistanceSquared, glm::dot(offset, offset));
+        }
+        return std::sqrt(bestDistanceSquared);
+    };
+
+    // 从相机附近随机方向发出射线,随机点查询最近的箱子
+    const int queryCount = 10000;
+    const int bruteQueryCount = 20;
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<glm::vec3> origins(queryCount);
+    std::vector<glm::vec3> directions(queryCount);
+    for(int i = 0; i < queryCount; i++)
+    {
+        origins[i] = scene.camera->getCameraPosition() + glm::vec3(unit(random), unit(random), unit(random));
+        directions[i] = glm::vec3(unit(random), unit(random), unit(random) - 1.0f);
+    }
+    int mismatches = 0;
+    BVHHit hit;
+    BVHHit bruteHit;
+    startTime = std::chrono::steady_clock::now();
+    for(int i = 0; i < queryCount; i++)
+        bvh.raycast(origins[i], directions[i], FLT_MAX, hit);
+    double rayMilliseconds = elapsed(startTime) / queryCount;
+    startTime = std::chrono::steady_clock::now();
+    for(int i = 0; i < bruteQueryCount; i++)
+        bruteRaycast(origins[i], directions[i], bruteHit);
+    double bruteRayMilliseconds = elapsed(startTime) / bruteQueryCount;
+    for(int i = 0; i < bruteQueryCount; i++)
+    {
+        bool bIsHit = bvh.raycast(origins[i], directions[i], FLT_MAX, hit);
+        if(bIsHit != bruteRaycast(origins[i], directions[i], bruteHit) || (bIsHit && hit.distance != bruteHit.distance))
+            mismatches++;
+    }
+    startTime = std::chrono::steady_clock::now();
+    for(int i = 0; i < queryCount; i++)
+        bvh.findNearest(origins[i] * 10.0f, FLT_MAX, hit);
+    double nearestMilliseconds = elapsed(startTime) / queryCount;
+    startTime = std::chrono::steady_clock::now();
+    for(int i = 0; i < bruteQueryCount; i++)
+        bruteNearest(origins[i] * 10.0f);
+    double bruteNearestMilliseconds = elapsed(startTime) / bruteQueryCount;
+    for(int i = 0; i < bruteQueryCount; i++)
+    {
+        bvh.findNearest(origins[i] * 10.0f, FLT_MAX, hit);
+        if(std::fabs(hit.distance - bruteNearest(origins[i] * 10.0f)) > 1e-4f)
+            mismatches++;
+    }
+    std::cout << "## Benchmark ## BVH queries, frustum = " << cullMilliseconds << " ms (brute force " << bruteCullMilliseconds
+              << " ms), ray = " << rayMilliseconds * 1000.0 << " us (brute force " << bruteRayMilliseconds * 1000.0
+              << " us), nearest = " << nearestMilliseconds * 1000.0 << " us (brute force " << bruteNearestMilliseconds * 1000.0
+              << " us), " << (visible == bruteVisible && 0 == mismatches ? "results match" : "results differ") << std::endl;
+}
+
+// 按当前开关选择箱子变体,预热后返回每帧的平均耗时,开启动画时每帧先旋转动态箱子
+// bInvalidateShadows为true时每帧使所有阴影贴图失效,statistics不为空时返回预热后的阴影统计
+double Benchmark::measureRender(BenchmarkScene &scene, bool bInvalidateShadows, ShadowStatistics *statistics)
+{
+    scene.updateBoxShader();
+    float animationTime = 0.0f;
+    auto renderFrame = [&]()
+    {
+        if(*scene.switches.bUseAnimation)
+        {
+            animationTime += 1.0f / 60.0f;
+            scene.animateBoxes(animationTime);
+        }
+        if(bInvalidateShadows)
+            scene.shadowMaps->invalidate();
+        scene.renderScene();
+    };
+    for(int frame = 0; frame < WarmupFrames; frame++)
+        renderFrame();
+    glFinish();
+    if(statistics)
+        *statistics = scene.shadowMaps->getStatistics();
+    auto startTime = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < MeasureFrames; frame++)
+        renderFrame();
+    glFinish();
+    return elapsed(startTime) / MeasureFrames;
+}
+
+// 延迟渲染与分簇前向渲染随光源数量的耗时,与只有一个光源的前向渲染比较,箱子使用最快的绘制路径,不带阴影
+// 之后测量分簇时把光源分配到簇的CPU耗时随线程数量的扩展,光源数量为最后一轮的10000
+void Benchmark::measureLighting(BenchmarkScene &scene)
+{
+    ScopedSwitches switches(scene);
+    scene.setBoxCount(LightingBoxCount);
+    *scene.switches.bUseInstancing = true;
+    *scene.switches.bUseIndirect = scene.indirectRenderer != nullptr;
+    *scene.switches.bUseCulling = true;
+    *scene.switches.bUseDeferred = false;
+    *scene.switches.bUseClustered = false;
+    *scene.switches.bUseShadows = false;
+    *scene.switches.bUseAnimation = false;
+    *scene.switches.bUseDirectionLight = false;
+    double forwardMilliseconds = measureRender(scene, false, nullptr);
+    const size_t lightCounts[] = {1, 100, 1000, 10000};
+    double deferredMilliseconds[4];
+    double clusteredMilliseconds[4];
+    for(int i = 0; i < 4; i++)
+    {
+        scene.setLightCount(lightCounts[i]);
+        *scene.switches.bUseDeferred = true;
+        deferredMilliseconds[i] = measureRender(scene, false, nullptr);
+        *scene.switches.bUseDeferred = false;
+        *scene.switches.bUseClustered = true;
+        clusteredMilliseconds[i] = measureRender(scene, false, nullptr);
+        *scene.switches.bUseClustered = false;
+    }
+    std::cout << "## Benchmark ## lighting " << LightingBoxCount << " boxes, forward 1 light = " << forwardMilliseconds << " ms";
+    for(int i = 0; i < 4; i++)
+        std::cout << ", " << lightCounts[i] << (1 == lightCounts[i] ? " light" : " lights") << " deferred = "
+                  << deferredMilliseconds[i] << " ms, clustered = " << clusteredMilliseconds[i] << " ms";
+    std::cout << std::endl;
+
+    ClusteredLighting &clusteredLighting = *scene.clusteredLighting;
+    glm::mat4 view = scene.camera->getViewMatrix();
+    float fovY = glm::radians(scene.camera->getCameraFOV());
+    float aspect = (float)scene.width / (float)scene.height;
+    std::cout << "## Benchmark ## cluster binning " << scene.pointLights->size() << " lights";
+    for(size_t threadCount : ThreadCounts)
+    {
+        ThreadPool pool(threadCount);
+        clusteredLighting.setThreadPool(&pool);
+        for(int frame = 0; frame < WarmupFrames; frame++)
+            clusteredLighting.assign(*scene.pointLights, view, fovY, aspect, 0.1f, scene.farPlane);
+        auto startTime = std::chrono::steady_clock::now();
+        for(int frame = 0; frame < MeasureFrames; frame++)
+            clusteredLighting.assign(*scene.pointLights, view, fovY, aspect, 0.1f, scene.farPlane);
+        std::cout << ", " << threadCount << " threads = " << elapsed(startTime) / MeasureFrames << " ms";
+    }
+    std::cout << ", light indices = " << clusteredLighting.getIndexCount() << std::endl;
+    clusteredLighting.setThreadPool(*scene.preparePool);
+    scene.setLightCount(scene.lightCount);
+}
+
+// 阴影的耗时,分簇前向渲染叠加平行光,级联阴影与点光源的立方体阴影都会用到
+// 依次为不带阴影、全部缓存、动态箱子每帧旋转,以及每帧重绘所有阴影贴图,后两种每帧旋转相同的箱子
+void Benchmark::measureShadows(BenchmarkScene &scene)
+{
+    ScopedSwitches switches(scene);
+    scene.setBoxCount(LightingBoxCount);
+    *scene.switches.bUseInstancing = true;
+    *scene.switches.bUseIndirect = scene.indirectRenderer != nullptr;
+    *scene.switches.bUseCulling = true;
+    *scene.switches.bUseDeferred = false;
+    *scene.switches.bUseClustered = true;
+    *scene.switches.bUseDirectionLight = true;
+    const char *shadowModeNames[] = {"off", "cached", "dynamic", "redraw all"};
+    std::cout << "## Benchmark ## shadows " << scene.boxModels->size() << " boxes, " << *scene.dynamicBoxCount << " dynamic";
+    for(int mode = 0; mode < 4; mode++)
+    {
+        *scene.switches.bUseShadows = mode > 0;
+        *scene.switches.bUseAnimation = mode > 1;
+        ShadowStatistics before;
+        double shadowMilliseconds = measureRender(scene, 3 == mode, &before);
+        const ShadowStatistics &after = scene.shadowMaps->getStatistics();
+        std::cout << ", " << shadowModeNames[mode] << " = " << shadowMilliseconds << " ms";
+        if(mode > 0)
+            std::cout << " (redraws per frame " << (double)(after.staticRedraws - before.staticRedraws) / MeasureFrames << " static, "
+                      << (double)(after.dynamicRedraws - before.dynamicRedraws) / MeasureFrames << " dynamic, "
+                      << (double)(after.casterInstances - before.casterInstances) / MeasureFrames << " casters)";
+    }
+    std::cout << std::endl;
+}
+
+// 准备阶段随线程数量的扩展,500k个箱子不剔除逐个绘制,分别测量构建变换、并行生成绘制包与串行合并排序
+void Benchmark::measurePrepare(BenchmarkScene &scene)
+{
+    ScopedSwitches switches(scene);
+    const size_t prepareBoxCount = 500000;
+    scene.setBoxCount(prepareBoxCount);
+    *scene.switches.bUseCulling = false;
+    *scene.switches.bUseInstancing = false;
+    *scene.switches.bUseIndirect = false;
+    *scene.switches.bUseDeferred = false;
+    scene.updateBoxShader();
+    glm::mat4 view = scene.camera->getViewMatrix();
+    glm::mat4 viewProjection = getProjection(scene) * view;
+    scene.cullBoxes(viewProjection);
+    ThreadPool *preparePool = *scene.preparePool;
+    for(size_t threadCount : ThreadCounts)
+    {
+        ThreadPool pool(threadCount);
+        *scene.preparePool = &pool;
+        const int transformRuns = 3;
+        auto startTime = std::chrono::steady_clock::now();
+        for(int run = 0; run < transformRuns; run++)
+            scene.makeBoxModels(prepareBoxCount, pool);
+        double transformMilliseconds = elapsed(startTime) / transformRuns;
+        for(int frame = 0; frame < WarmupFrames; frame++)
+            scene.fillRenderQueue(view, viewProjection);
+        startTime = std::chrono::steady_clock::now();
+        for(int frame = 0; frame < MeasureFrames; frame++)
+            scene.prepareBoxPackets(view, viewProjection);
+        double packetMilliseconds = elapsed(startTime) / MeasureFrames;
+        startTime = std::chrono::steady_clock::now();
+        for(int frame = 0; frame < MeasureFrames; frame++)
+            scene.fillRenderQueue(view, viewProjection);
+        double fillMilliseconds = elapsed(startTime) / MeasureFrames;
+        std::cout << "## Benchmark ## prepare " << prepareBoxCount << " boxes, " << threadCount << " threads, transforms = "
+                  << transformMilliseconds << " ms, packets = " << packetMilliseconds << " ms, merge and sort = "
+                  << fillMilliseconds - packetMilliseconds << " ms" << std::endl;
+    }
+    *scene.preparePool = preparePool;
+}
+
+// 加载500张贴图的耗时随解码线程数量的扩展,与在渲染线程逐张加载比较
+// 流式加载每帧调用一次update,记录从提交到全部上传的时间、有上传的帧数与单帧最长的上传耗时
+// 先关闭预解码缓存,每张贴图都解码并生成Mipmap链,再打开缓存只读取缓存文件,两种情况分别输出
+void Benchmark::measureTextureLoading(const BenchmarkScene &scene)
+{
+    // 同步加载时按行分块在线程池中生成Mipmap
+    MipmapGenerator mipmapGenerator(scene.threadPool);
+    const bool bWasCacheEnabled = TextureCache::isEnabled();
+    const size_t streamTextureCount = 500;
+    std::vector<GLuint> streamTextures(streamTextureCount);
+    for(bool bUseTextureCache : {false, true})
+    {
+        TextureCache::setEnabled(bUseTextureCache);
+        // 打开缓存时先加载一遍,保证测量时每张贴图都命中缓存
+        if(bUseTextureCache)
+        {
+            for(size_t i = 0; i < TexturePathCount; i++)
+                GLStateCache::deleteTexture(loadTexture(TexturePaths[i], TextureIsSRGB[i], mipmapGenerator));
+        }
+        auto startTime = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < streamTextureCount; i++)
+            streamTextures[i] = loadTexture(TexturePaths[i % TexturePathCount], TextureIsSRGB[i % TexturePathCount], mipmapGenerator);
+        glFinish();
+        std::cout << "## Benchmark ## load " << streamTextureCount << " textures " << (bUseTextureCache ? "cached" : "uncached")
+                  << ", synchronous = " << elapsed(startTime) << " ms";
+        for(GLuint texture : streamTextures)
+            GLStateCache::deleteTexture(texture);
+        for(size_t decoderCount : ThreadCounts)
+        {
+            TextureStreamer streamer(decoderCount, scene.textureUploadBudget);
+            startTime = std::chrono::steady_clock::now();
+            for(size_t i = 0; i < streamTextureCount; i++)
+                streamTextures[i] = streamer.load(TexturePaths[i % TexturePathCount], TextureIsSRGB[i % TexturePathCount]);
+            double submitMilliseconds = elapsed(startTime);
+            int uploadFrames = 0;
+            double maxFrameMilliseconds = 0.0;
+            while(streamer.getPendingCount() > 0)
+            {
+                auto frameStartTime = std::chrono::steady_clock::now();
+                if(streamer.update() > 0)
+                {
+                    uploadFrames++;
+                    maxFrameMilliseconds = std::max(maxFrameMilliseconds, elapsed(frameStartTime));
+                }
+                else
+                {
+                    // 没有可上传的贴图时让出CPU,相当于渲染线程在绘制这一帧
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            glFinish();
+            std::cout << ", " << decoderCount << " decoders = " << elapsed(startTime) << " ms (submit " << submitMilliseconds
+                      << " ms, " << uploadFrames << " upload frames, longest " << maxFrameMilliseconds << " ms)";
+            for(GLuint texture : streamTextures)
+                GLStateCache::deleteTexture(texture);
+        }
+        std::cout << std::endl;
+    }
+    TextureCache::setEnabled(bWasCacheEnabled);
+}
+
+// 块压缩编码一张图的耗时,标量与SSE单线程比较,以及SSE随线程数量的扩展,两种指令集的结果应逐字节相同
+// 之后比较同一张贴图从预解码缓存上传RGBA8的Mipmap链与从映射的KTX2文件上传压缩数据,以及两者的显存
+void Benchmark::measureCompression(const BenchmarkScene &scene)
+{
+    int imageWidth, imageHeight, imageChannel;
+    unsigned char *image = stbi_load(TexturePaths[0], &imageWidth, &imageHeight, &imageChannel, 4);
+    const int compressRepeats = 10;
+    for(BlockCompressor::Format format : {BlockCompressor::BC1, BlockCompressor::BC3, BlockCompressor::BC5})
+    {
+        if(!image)
+            break;
+        size_t compressedSize = BlockCompressor::getCompressedSize(format, imageWidth, imageHeight);
+        std::vector<unsigned char> scalarOutput(compressedSize);
+        std::vector<unsigned char> output(compressedSize);
+        BlockCompressor compressor;
+        auto measureCompress = [&](std::vector<unsigned char> &result)
+        {
+            auto startTime = std::chrono::steady_clock::now();
+            for(int repeat = 0; repeat < compressRepeats; repeat++)
+                compressor.compress(format, image, imageWidth, imageHeight, result.data());
+            return elapsed(startTime) / compressRepeats;
+        };
+        compressor.setInstructionSet(BlockCompressor::Scalar);
+        std::cout << "## Benchmark ## compress " << TexturePaths[0] << " " << imageWidth << "x" << imageHeight << " "
+                  << BlockCompressor::getFormatName(format) << ", scalar = " << measureCompress(scalarOutput) << " ms";
+        compressor.setInstructionSet(BlockCompressor::getBestInstructionSet());
+        for(size_t threadCount : ThreadCounts)
+        {
+            ThreadPool pool(threadCount);
+            compressor.setThreadPool(&pool);
+            std::cout << ", " << BlockCompressor::getInstructionSetName(BlockCompressor::getBestInstructionSet()) << " "
+                      << threadCount << " threads = " << measureCompress(output) << " ms";
+        }
+        std::cout << (scalarOutput == output ? ", results match" : ", RESULTS DIFFER") << std::endl;
+    }
+    stbi_image_free(image);
+
+    const char *compressedPath = "texture/box_diffuse.ktx2";
+    KTXTexture compressedFile(compressedPath);
+    GLuint compressedTexture = TextureStreamer::loadCompressed(compressedPath);
+    if(compressedFile.isValid() && compressedTexture)
+    {
+        GLStateCache::deleteTexture(compressedTexture);
+        MipmapGenerator mipmapGenerator(scene.threadPool);
+        const int loadRepeats = 10;
+        auto startTime = std::chrono::steady_clock::now();
+        for(int repeat = 0; repeat < loadRepeats; repeat++)
+            GLStateCache::deleteTexture(loadTexture(TexturePaths[0], TextureIsSRGB[0], mipmapGenerator));
+        glFinish();
+        double uncompressedMilliseconds = elapsed(startTime) / loadRepeats;
+        startTime = std::chrono::steady_clock::now();
+        for(int repeat = 0; repeat < loadRepeats; repeat++)
+            GLStateCache::deleteTexture(TextureStreamer::loadCompressed(compressedPath));
+        glFinish();
+        double compressedMilliseconds = elapsed(startTime) / loadRepeats;
+        // 未压缩的大小按RGBA8加上Mipmap计算
+        size_t compressedBytes = 0;
+        size_t uncompressedBytes = 0;
+        for(const KTXTexture::Level &level : compressedFile.getLevels())
+        {
+            compressedBytes += level.size;
+            uncompressedBytes += (size_t)level.width * level.height * 4;
+        }
+        std::cout << "## Benchmark ## load " << TexturePaths[0] << ", RGBA8 from cache = " << uncompressedMilliseconds
+                  << " ms (" << uncompressedBytes / 1024 << " KB), " << BlockCompressor::getFormatName(compressedFile.getFormat())
+                  << " from KTX2 = " << compressedMilliseconds << " ms (" << compressedBytes / 1024 << " KB)" << std::endl;
+    }
+}
+
+// 生成Mipmap链的耗时,上传后由驱动生成与在CPU上标量单线程、SSE随线程数量扩展比较,两种指令集的结果应逐字节相同
+// 之后删除缓存加载一次为缓存缺失,包括解码、生成Mipmap链与写入缓存,再加载一次为命中缓存
+void Benchmark::measureMipmaps(const BenchmarkScene &scene)
+{
+    int imageWidth, imageHeight, imageChannel;
+    unsigned char *image = stbi_load(TexturePaths[0], &imageWidth, &imageHeight, &imageChannel, 4);
+    if(!image)
+    {
+        return;
+    }
+    const int mipmapRepeats = 10;
+    GLuint mipmapTexture;
+    glGenTextures(1, &mipmapTexture);
+    GLStateCache::bindTexture(0, GL_TEXTURE_2D, mipmapTexture);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    auto startTime = std::chrono::steady_clock::now();
+    for(int repeat = 0; repeat < mipmapRepeats; repeat++)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glFinish();
+    double driverMilliseconds = elapsed(startTime) / mipmapRepeats;
+    GLStateCache::deleteTexture(mipmapTexture);
+
+    size_t chainSize = MipmapGenerator::getChainSize(imageWidth, imageHeight);
+    std::vector<unsigned char> scalarChain(chainSize);
+    std::vector<unsigned char> chain(chainSize);
+    MipmapGenerator generator;
+    auto measureGenerate = [&](std::vector<unsigned char> &result)
+    {
+        startTime = std::chrono::steady_clock::now();
+        for(int repeat = 0; repeat < mipmapRepeats; repeat++)
+            generator.generate(image, imageWidth, imageHeight, TextureIsSRGB[0], result.data());
+        return elapsed(startTime) / mipmapRepeats;
+    };
+    generator.setInstructionSet(MipmapGenerator::Scalar);
+    std::cout << "## Benchmark ## mipmaps " << TexturePaths[0] << " " << imageWidth << "x" << imageHeight
+              << (TextureIsSRGB[0] ? " sRGB" : " linear") << ", upload and glGenerateMipmap = " << driverMilliseconds
+              << " ms, scalar = " << measureGenerate(scalarChain) << " ms";
+    generator.setInstructionSet(MipmapGenerator::getBestInstructionSet());
+    for(size_t threadCount : ThreadCounts)
+    {
+        ThreadPool pool(threadCount);
+        generator.setThreadPool(&pool);
+        std::cout << ", " << MipmapGenerator::getInstructionSetName(MipmapGenerator::getBestInstructionSet()) << " "
+                  << threadCount << " threads = " << measureGenerate(chain) << " ms";
+    }
+    std::cout << (scalarChain == chain ? ", results match" : ", RESULTS DIFFER") << std::endl;
+    stbi_image_free(image);
+
+    MipmapGenerator mipmapGenerator(scene.threadPool);
+    std::remove(TextureCache::cachePath(TexturePaths[0]).c_str());
+    TextureCache::Image cachedImage;
+    bool bIsMissCached = true;
+    bool bIsHitCached = false;
+    startTime = std::chrono::steady_clock::now();
+    TextureCache::load(TexturePaths[0], TextureIsSRGB[0], mipmapGenerator, cachedImage, &bIsMissCached);
+    double missMilliseconds = elapsed(startTime);
+    startTime = std::chrono::steady_clock::now();
+    TextureCache::load(TexturePaths[0], TextureIsSRGB[0], mipmapGenerator, cachedImage, &bIsHitCached);
+    double hitMilliseconds = elapsed(startTime);
+    std::cout << "## Benchmark ## texture cache " << TexturePaths[0] << ", miss (decode, generate and write) = " << missMilliseconds
+              << " ms, hit = " << hitMilliseconds << " ms, " << cachedImage.levelCount << " levels, "
+              << cachedImage.pixels.size() / 1024 << " KB" << (!bIsMissCached && bIsHitCached ? "" : ", CACHE STATE WRONG")
+              << std::endl;
+}
+
+// 同步加载贴图,从预解码缓存读取像素与Mipmap链,缓存失效时解码并在CPU上生成
+GLuint Benchmark::loadTexture(const std::string &path, bool bIsSRGB, const MipmapGenerator &generator)
+{
+    // 贴图ID
+    GLuint textureID;
+    // 生成贴图
+    glGenTextures(1, &textureID);
+    // 读取像素与Mipmap链,缓存失效时解码图片、在CPU上生成Mipmap链并写入缓存
+    TextureCache::Image image;
+    // 判断是否加载图片成功
+    if(TextureCache::load(path, bIsSRGB, generator, image))
+    {
+        // 绑定贴图,贴图已绑定在0号单元时绑定被省略,需要激活0号单元
+        GLStateCache::bindTexture(0, GL_TEXTURE_2D, textureID);
+        GLStateCache::activeTexture(GL_TEXTURE0);
+        // 逐级设置贴图数据,不再由驱动生成Mipmap
+        const unsigned char *pixels = image.pixels.data();
+        int width = image.width;
+        int height = image.height;
+        for(int level = 0; level < image.levelCount; level++)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            pixels += (size_t)width * height * 4;
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+
+        // 设置贴图UV过大情况
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        // 设置贴图缩小生成Mipmap
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        // 设置贴图放大,失真时做线性差值融合
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Texture Load Fail, Path = " << path << std::endl;
+    }
+
+    return textureID;
+}
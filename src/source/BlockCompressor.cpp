@@ -0,0 +1,425 @@
+#include "BlockCompressor.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OPENGLTUTORIAL_BLOCK_SSE 1
+#include <emmintrin.h>
+#endif
+
+// 并行编码时每块的最少块行数
+static const size_t MinChunkRows = 4;
+
+// 读取一个块的16个RGBA像素,超出图像的部分重复边缘像素
+static void loadBlock(const unsigned char *pixels, int width, int height, int blockX, int blockY, unsigned char *block)
+{
+    int x0 = blockX * 4;
+    for(int y = 0; y < 4; y++)
+    {
+        const unsigned char *row = pixels + (size_t)std::min(blockY * 4 + y, height - 1) * width * 4;
+        if(x0 + 4 <= width)
+        {
+            std::memcpy(block + y * 16, row + x0 * 4, 16);
+            continue;
+        }
+        for(int x = 0; x < 4; x++)
+            std::memcpy(block + y * 16 + x * 4, row + std::min(x0 + x, width - 1) * 4, 4);
+    }
+}
+
+// 颜色与RGB565的转换,展开时高位复制到低位,与解码器一致
+static uint16_t toColor565(const unsigned char *color)
+{
+    return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void fromColor565(uint16_t value, unsigned char *color)
+{
+    int r = (value >> 11) & 31;
+    int g = (value >> 5) & 63;
+    int b = value & 31;
+    color[0] = (unsigned char)((r << 3) | (r >> 2));
+    color[1] = (unsigned char)((g << 2) | (g >> 4));
+    color[2] = (unsigned char)((b << 3) | (b >> 2));
+    color[3] = 0;
+}
+
+// 由包围盒计算颜色块的两个端点与调色板,包围盒向内收缩范围的1/16以减小端点附近的误差
+// 写入端点,返回两个端点是否相同,相同时所有下标为0
+static bool writeColorEndpoints(unsigned char *minColor, unsigned char *maxColor, unsigned char palette[16], unsigned char *output)
+{
+    for(int c = 0; c < 3; c++)
+    {
+        int inset = (maxColor[c] - minColor[c]) >> 4;
+        minColor[c] = (unsigned char)(minColor[c] + inset);
+        maxColor[c] = (unsigned char)(maxColor[c] - inset);
+    }
+    // 端点0不小于端点1时为4色模式,包围盒的最大值按565比较一定不小于最小值
+    uint16_t color0 = toColor565(maxColor);
+    uint16_t color1 = toColor565(minColor);
+    output[0] = (unsigned char)(color0 & 0xFF);
+    output[1] = (unsigned char)(color0 >> 8);
+    output[2] = (unsigned char)(color1 & 0xFF);
+    output[3] = (unsigned char)(color1 >> 8);
+    fromColor565(color0, palette);
+    fromColor565(color1, palette + 4);
+    for(int c = 0; c < 4; c++)
+    {
+        palette[8 + c] = (unsigned char)((2 * palette[c] + palette[4 + c]) / 3);
+        palette[12 + c] = (unsigned char)((palette[c] + 2 * palette[4 + c]) / 3);
+    }
+    return color0 == color1;
+}
+
+// 单通道块的调色板位置阈值,端点alpha0大于alpha1,位置k的值为((7-k)*alpha1 + k*alpha0)/7
+// 值不小于thresholds[k]时位置大于k,返回两个端点是否相同
+static bool writeChannelEndpoints(int minValue, int maxValue, unsigned char thresholds[7], unsigned char *output)
+{
+    int inset = (maxValue - minValue) >> 5;
+    int alpha0 = maxValue - inset;
+    int alpha1 = minValue + inset;
+    output[0] = (unsigned char)alpha0;
+    output[1] = (unsigned char)alpha1;
+    int previous = alpha1;
+    for(int k = 0; k < 7; k++)
+    {
+        int next = ((6 - k) * alpha1 + (k + 1) * alpha0) / 7;
+        thresholds[k] = (unsigned char)((previous + next + 1) / 2);
+        previous = next;
+    }
+    return alpha0 == alpha1;
+}
+
+// 调色板位置转换为单通道块的下标,位置7为alpha0(下标0),位置0为alpha1(下标1),其余为8-位置
+static int positionToIndex(int position)
+{
+    int index = (8 - position) & 7;
+    return index < 2 ? index ^ 1 : index;
+}
+
+// 写入16个3位下标
+static void writeChannelIndices(const unsigned char *indices, unsigned char *output)
+{
+    uint64_t bits = 0;
+    for(int i = 0; i < 16; i++)
+        bits |= (uint64_t)indices[i] << (3 * i);
+    for(int i = 0; i < 6; i++)
+        output[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// 标量版本,编码颜色块
+static void encodeColorScalar(const unsigned char *block, unsigned char *output)
+{
+    unsigned char minColor[4] = {255, 255, 255, 255};
+    unsigned char maxColor[4] = {0, 0, 0, 0};
+    for(int i = 0; i < 16; i++)
+    {
+        for(int c = 0; c < 3; c++)
+        {
+            minColor[c] = std::min(minColor[c], block[i * 4 + c]);
+            maxColor[c] = std::max(maxColor[c], block[i * 4 + c]);
+        }
+    }
+    unsigned char palette[16];
+    uint32_t bits = 0;
+    if(!writeColorEndpoints(minColor, maxColor, palette, output))
+    {
+        for(int i = 0; i < 16; i++)
+        {
+            // 按RGB绝对差之和选最近的颜色,相等时取下标小的
+            int bestIndex = 0;
+            int bestDistance = 0x7FFFFFFF;
+            for(int p = 0; p < 4; p++)
+            {
+                int distance = 0;
+                for(int c = 0; c < 3; c++)
+                    distance += std::abs(block[i * 4 + c] - palette[p * 4 + c]);
+                if(distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            bits |= (uint32_t)bestIndex << (2 * i);
+        }
+    }
+    for(int i = 0; i < 4; i++)
+        output[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// 标量版本,编码块中第channel个通道
+static void encodeChannelScalar(const unsigned char *block, int channel, unsigned char *output)
+{
+    int minValue = 255;
+    int maxValue = 0;
+    for(int i = 0; i < 16; i++)
+    {
+        minValue = std::min(minValue, (int)block[i * 4 + channel]);
+        maxValue = std::max(maxValue, (int)block[i * 4 + channel]);
+    }
+    unsigned char thresholds[7];
+    unsigned char indices[16] = {};
+    if(!writeChannelEndpoints(minValue, maxValue, thresholds, output))
+    {
+        for(int i = 0; i < 16; i++)
+        {
+            int position = 0;
+            for(int k = 0; k < 7; k++)
+                position += block[i * 4 + channel] >= thresholds[k] ? 1 : 0;
+            indices[i] = (unsigned char)positionToIndex(position);
+        }
+    }
+    writeChannelIndices(indices, output);
+}
+
+#ifdef OPENGLTUTORIAL_BLOCK_SSE
+// 16个字节的最小值与最大值,每次与右移一半的自身比较
+static void reduceMinMax(__m128i minimum, __m128i maximum, int &minValue, int &maxValue)
+{
+    minimum = _mm_min_epu8(minimum, _mm_srli_si128(minimum, 8));
+    maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 8));
+    minimum = _mm_min_epu8(minimum, _mm_srli_si128(minimum, 4));
+    maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 4));
+    minimum = _mm_min_epu8(minimum, _mm_srli_si128(minimum, 2));
+    maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 2));
+    minimum = _mm_min_epu8(minimum, _mm_srli_si128(minimum, 1));
+    maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 1));
+    minValue = _mm_cvtsi128_si32(minimum) & 0xFF;
+    maxValue = _mm_cvtsi128_si32(maximum) & 0xFF;
+}
+
+// 4个像素与一个调色板颜色的RGB绝对差之和,像素与颜色的alpha已清零
+static __m128i colorDistance(__m128i pixels, __m128i color)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i difference = _mm_or_si128(_mm_subs_epu8(pixels, color), _mm_subs_epu8(color, pixels));
+    // 先两两相加为每个像素的r+g与b+a,再相加为每个像素一个32位整数
+    __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(difference, zero), ones);
+    __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(difference, zero), ones);
+    return _mm_madd_epi16(_mm_packs_epi32(low, high), ones);
+}
+
+// SSE版本,编码颜色块
+static void encodeColorSSE(const unsigned char *block, unsigned char *output)
+{
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    __m128i pixels[4];
+    for(int i = 0; i < 4; i++)
+        pixels[i] = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16)), rgbMask);
+
+    __m128i minimum = _mm_min_epu8(_mm_min_epu8(pixels[0], pixels[1]), _mm_min_epu8(pixels[2], pixels[3]));
+    __m128i maximum = _mm_max_epu8(_mm_max_epu8(pixels[0], pixels[1]), _mm_max_epu8(pixels[2], pixels[3]));
+    minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+    maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+    minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+    maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+    int minPacked = _mm_cvtsi128_si32(minimum);
+    int maxPacked = _mm_cvtsi128_si32(maximum);
+    unsigned char minColor[4];
+    unsigned char maxColor[4];
+    std::memcpy(minColor, &minPacked, 4);
+    std::memcpy(maxColor, &maxPacked, 4);
+
+    unsigned char palette[16];
+    uint32_t bits = 0;
+    if(!writeColorEndpoints(minColor, maxColor, palette, output))
+    {
+        __m128i colors[4];
+        for(int p = 0; p < 4; p++)
+        {
+            int packed;
+            std::memcpy(&packed, palette + p * 4, 4);
+            colors[p] = _mm_set1_epi32(packed);
+        }
+        for(int i = 0; i < 4; i++)
+        {
+            // 与标量版本相同,只有严格更近时才替换
+            __m128i bestDistance = colorDistance(pixels[i], colors[0]);
+            __m128i bestIndex = _mm_setzero_si128();
+            for(int p = 1; p < 4; p++)
+            {
+                __m128i distance = colorDistance(pixels[i], colors[p]);
+                __m128i closer = _mm_cmplt_epi32(distance, bestDistance);
+                bestDistance = _mm_or_si128(_mm_andnot_si128(closer, bestDistance), _mm_and_si128(closer, distance));
+                bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex), _mm_and_si128(closer, _mm_set1_epi32(p)));
+            }
+            uint32_t indices[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(indices), bestIndex);
+            for(int j = 0; j < 4; j++)
+                bits |= indices[j] << (2 * (i * 4 + j));
+        }
+    }
+    for(int i = 0; i < 4; i++)
+        output[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// SSE版本,编码块中第channel个通道,16个像素的值在一个寄存器中
+static void encodeChannelSSE(const unsigned char *block, int channel, unsigned char *output)
+{
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    __m128i values[4];
+    for(int i = 0; i < 4; i++)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16));
+        values[i] = _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(channel * 8)), byteMask);
+    }
+    __m128i value = _mm_packus_epi16(_mm_packs_epi32(values[0], values[1]), _mm_packs_epi32(values[2], values[3]));
+
+    int minValue;
+    int maxValue;
+    reduceMinMax(value, value, minValue, maxValue);
+    unsigned char thresholds[7];
+    unsigned char indices[16] = {};
+    if(!writeChannelEndpoints(minValue, maxValue, thresholds, output))
+    {
+        // 位置为不小于阈值的数量,比较结果为-1,相减即计数
+        __m128i position = _mm_setzero_si128();
+        for(int k = 0; k < 7; k++)
+        {
+            __m128i threshold = _mm_set1_epi8((char)thresholds[k]);
+            position = _mm_sub_epi8(position, _mm_cmpeq_epi8(_mm_max_epu8(value, threshold), value));
+        }
+        // 与positionToIndex相同,(8-位置)&7后交换0与1
+        __m128i index = _mm_and_si128(_mm_sub_epi8(_mm_set1_epi8(8), position), _mm_set1_epi8(7));
+        __m128i swap = _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(2), index), _mm_set1_epi8(1));
+        index = _mm_xor_si128(index, swap);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(indices), index);
+    }
+    writeChannelIndices(indices, output);
+}
+#endif
+
+// 编码一个块
+static void encodeBlock(BlockCompressor::Format format, BlockCompressor::InstructionSet set, const unsigned char *block, unsigned char *output)
+{
+#ifdef OPENGLTUTORIAL_BLOCK_SSE
+    if(BlockCompressor::SSE == set)
+    {
+        switch(format)
+        {
+        case BlockCompressor::BC1:
+            encodeColorSSE(block, output);
+            break;
+        case BlockCompressor::BC3:
+            encodeChannelSSE(block, 3, output);
+            encodeColorSSE(block, output + 8);
+            break;
+        default:
+            encodeChannelSSE(block, 0, output);
+            encodeChannelSSE(block, 1, output + 8);
+            break;
+        }
+        return;
+    }
+#endif
+    switch(format)
+    {
+    case BlockCompressor::BC1:
+        encodeColorScalar(block, output);
+        break;
+    case BlockCompressor::BC3:
+        encodeChannelScalar(block, 3, output);
+        encodeColorScalar(block, output + 8);
+        break;
+    default:
+        encodeChannelScalar(block, 0, output);
+        encodeChannelScalar(block, 1, output + 8);
+        break;
+    }
+}
+
+// 构造函数,默认使用编译支持的最快指令集
+BlockCompressor::BlockCompressor(ThreadPool *threadPool) : threadPool(threadPool), instructionSet(getBestInstructionSet())
+{
+}
+
+// 编译支持的最快指令集
+BlockCompressor::InstructionSet BlockCompressor::getBestInstructionSet()
+{
+    return isSupported(SSE) ? SSE : Scalar;
+}
+
+// 指令集名称
+const char *BlockCompressor::getInstructionSetName(InstructionSet instructionSet)
+{
+    return SSE == instructionSet ? "SSE" : "scalar";
+}
+
+// 是否编译了指令集
+bool BlockCompressor::isSupported(InstructionSet instructionSet)
+{
+    switch(instructionSet)
+    {
+#ifdef OPENGLTUTORIAL_BLOCK_SSE
+    case SSE:
+        return true;
+#endif
+    case Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 格式名称
+const char *BlockCompressor::getFormatName(Format format)
+{
+    switch(format)
+    {
+    case BC1:
+        return "BC1";
+    case BC3:
+        return "BC3";
+    default:
+        return "BC5";
+    }
+}
+
+// 每个块的字节数
+size_t BlockCompressor::getBlockSize(Format format)
+{
+    return BC1 == format ? 8 : 16;
+}
+
+// width x height的图像压缩后的字节数,不足一块的边缘按一块计算
+size_t BlockCompressor::getCompressedSize(Format format, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * getBlockSize(format);
+}
+
+// 设置使用的指令集,不支持时保持不变
+void BlockCompressor::setInstructionSet(InstructionSet set)
+{
+    if(isSupported(set))
+        instructionSet = set;
+}
+
+// 编码一张RGBA8图像,output至少能容纳getCompressedSize字节,超出图像的块重复边缘像素
+void BlockCompressor::compress(Format format, const unsigned char *pixels, int width, int height, unsigned char *output) const
+{
+    const int blocksX = (width + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+    const size_t blockSize = getBlockSize(format);
+    const InstructionSet set = instructionSet;
+    auto compressRows = [&](size_t begin, size_t end, size_t)
+    {
+        unsigned char block[64];
+        for(size_t blockY = begin; blockY < end; blockY++)
+        {
+            unsigned char *rowOutput = output + blockY * blocksX * blockSize;
+            for(int blockX = 0; blockX < blocksX; blockX++)
+            {
+                loadBlock(pixels, width, height, blockX, (int)blockY, block);
+                encodeBlock(format, set, block, rowOutput + blockX * blockSize);
+            }
+        }
+    };
+    if(threadPool)
+        threadPool->parallelFor((size_t)blocksY, MinChunkRows, compressRows);
+    else if(blocksY > 0)
+        compressRows(0, (size_t)blocksY, 0);
+}
@@ -0,0 +1,187 @@
+#include "ClusteredLighting.h"
+#include "GLStateCache.h"
+#include "PointLightList.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// 并行计算光源范围时每块的最少光源数量
+static const size_t RangeChunkSize = 1024;
+
+// 在线程池中并行处理,没有线程池时在调用线程处理
+template <typename Function>
+void ClusteredLighting::parallelFor(size_t count, size_t minChunkSize, const Function &function)
+{
+    if(threadPool)
+        threadPool->parallelFor(count, minChunkSize, function);
+    else if(count > 0)
+        function(0, count, 0);
+}
+
+// 球在屏幕一个方向上覆盖的块范围,center为该方向的观察空间坐标,depth为到相机平面的距离
+// 切线 x = t * depth 的斜率t满足 (center - t * depth)^2 = radius^2 * (1 + t^2),球跨过相机平面时覆盖整个方向
+static bool computeTileRange(float center, float depth, float radius, float tanHalf, int tiles, int16_t &minTile, int16_t &maxTile)
+{
+    float minNdc = -FLT_MAX;
+    float maxNdc = FLT_MAX;
+    float denominator = depth * depth - radius * radius;
+    if(depth > radius)
+    {
+        float root = radius * std::sqrt(center * center + denominator);
+        minNdc = (center * depth - root) / denominator / tanHalf;
+        maxNdc = (center * depth + root) / denominator / tanHalf;
+    }
+    if(maxNdc < -1.0f || minNdc > 1.0f)
+    {
+        return false;
+    }
+    float scale = 0.5f * tiles;
+    minTile = (int16_t)std::max(std::floor((std::max(minNdc, -1.0f) + 1.0f) * scale), 0.0f);
+    maxTile = (int16_t)std::min(std::floor((std::min(maxNdc, 1.0f) + 1.0f) * scale), (float)(tiles - 1));
+    return true;
+}
+
+// 构造函数,创建纹理缓冲,threadPool为空时在调用线程分配
+ClusteredLighting::ClusteredLighting(ThreadPool *threadPool)
+    : threadPool(threadPool), sliceCounts(Slices), sliceIndices(Slices), sliceOffsets(Slices), clusters(ClusterCount),
+      clusterUniformBuffer(UniformBlockBinding::Cluster, sizeof(ClusterData)), clusterData()
+{
+    glGenBuffers(TextureCount, buffers);
+    glGenTextures(TextureCount, textures);
+    // 簇为起点与数量两个无符号整数,光源下标为一个无符号整数,光源参数按PointLightData的std140布局每个vec4一个纹素
+    const GLenum formats[TextureCount] = {GL_RG32UI, GL_R32UI, GL_RGBA32F};
+    for(int i = 0; i < TextureCount; i++)
+    {
+        GLStateCache::bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+        GLStateCache::bindTexture(0, GL_TEXTURE_BUFFER, textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+}
+
+// 上传光源参数,光源改变时调用
+void ClusteredLighting::setLights(const PointLightList &lights)
+{
+    GLStateCache::bindBuffer(GL_TEXTURE_BUFFER, buffers[2]);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)std::max(lights.size(), (size_t)1) * sizeof(PointLightData), lights.getLights(), GL_STATIC_DRAW);
+}
+
+// 把光源分配到簇,只在CPU上计算,fovY为弧度
+// 先并行计算每个光源覆盖的簇范围,再按切片并行统计并填写各簇的光源下标,最后按切片顺序拼接
+// 光源在每个簇中的顺序与列表中的顺序相同,结果与线程数量无关
+void ClusteredLighting::assign(const PointLightList &lights, const glm::mat4 &view, float fovY, float aspect, float nearPlane, float farPlane)
+{
+    const size_t lightCount = lights.size();
+    const glm::vec4 *bounds = lights.getBounds();
+    float tanHalfY = std::tan(0.5f * fovY);
+    float tanHalfX = tanHalfY * aspect;
+    float sliceScale = Slices / std::log(farPlane / nearPlane);
+    float sliceBias = -std::log(nearPlane) * sliceScale;
+    clusterData.gridSize = glm::ivec4(TilesX, TilesY, Slices, (int)lightCount);
+    clusterData.scale.z = sliceScale;
+    clusterData.scale.w = sliceBias;
+
+    ranges.resize(lightCount);
+    parallelFor(lightCount, RangeChunkSize, [&](size_t begin, size_t end, size_t)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            ClusterRange &range = ranges[i];
+            range.minZ = 1;
+            range.maxZ = 0;
+            glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(bounds[i]), 1.0f));
+            float radius = bounds[i].w;
+            float depth = -center.z;
+            if(depth + radius < nearPlane || depth - radius > farPlane)
+                continue;
+            if(!computeTileRange(center.x, depth, radius, tanHalfX, TilesX, range.minX, range.maxX) ||
+               !computeTileRange(center.y, depth, radius, tanHalfY, TilesY, range.minY, range.maxY))
+                continue;
+            float nearDepth = std::max(depth - radius, nearPlane);
+            float farDepth = std::min(depth + radius, farPlane);
+            range.minZ = (int16_t)std::max(std::floor(std::log(nearDepth) * sliceScale + sliceBias), 0.0f);
+            range.maxZ = (int16_t)std::min(std::floor(std::log(farDepth) * sliceScale + sliceBias), (float)(Slices - 1));
+        }
+    });
+
+    // 每个切片先统计各簇的光源数量,得到簇在切片内的起点,再把计数改为写入位置填写下标
+    const int sliceClusters = TilesX * TilesY;
+    parallelFor(Slices, 1, [&](size_t begin, size_t end, size_t)
+    {
+        for(size_t slice = begin; slice < end; slice++)
+        {
+            std::vector<uint32_t> &counts = sliceCounts[slice];
+            counts.assign(sliceClusters, 0);
+            for(const ClusterRange &range : ranges)
+            {
+                if((int)slice < range.minZ || (int)slice > range.maxZ)
+                    continue;
+                for(int y = range.minY; y <= range.maxY; y++)
+                    for(int x = range.minX; x <= range.maxX; x++)
+                        counts[y * TilesX + x]++;
+            }
+            glm::uvec2 *sliceRanges = clusters.data() + slice * sliceClusters;
+            uint32_t total = 0;
+            for(int cluster = 0; cluster < sliceClusters; cluster++)
+            {
+                sliceRanges[cluster] = glm::uvec2(total, counts[cluster]);
+                counts[cluster] = total;
+                total += sliceRanges[cluster].y;
+            }
+            std::vector<uint32_t> &indices = sliceIndices[slice];
+            indices.resize(total);
+            for(size_t i = 0; i < ranges.size(); i++)
+            {
+                const ClusterRange &range = ranges[i];
+                if((int)slice < range.minZ || (int)slice > range.maxZ)
+                    continue;
+                for(int y = range.minY; y <= range.maxY; y++)
+                    for(int x = range.minX; x <= range.maxX; x++)
+                        indices[counts[y * TilesX + x]++] = (uint32_t)i;
+            }
+        }
+    });
+
+    // 切片按顺序拼接,簇的起点加上切片的起点
+    size_t total = 0;
+    for(int slice = 0; slice < Slices; slice++)
+    {
+        sliceOffsets[slice] = (uint32_t)total;
+        total += sliceIndices[slice].size();
+    }
+    lightIndices.resize(total);
+    parallelFor(Slices, 1, [&](size_t begin, size_t end, size_t)
+    {
+        for(size_t slice = begin; slice < end; slice++)
+        {
+            uint32_t base = sliceOffsets[slice];
+            glm::uvec2 *sliceRanges = clusters.data() + slice * sliceClusters;
+            for(int cluster = 0; cluster < sliceClusters; cluster++)
+                sliceRanges[cluster].x += base;
+            std::copy(sliceIndices[slice].begin(), sliceIndices[slice].end(), lightIndices.begin() + base);
+        }
+    });
+}
+
+// 上传分配结果与分簇参数,framebufferWidth与framebufferHeight用于把像素映射到块
+// 每帧重新分配数据存储,驱动可以在GPU仍读取上一帧列表时换用新的存储
+void ClusteredLighting::upload(int framebufferWidth, int framebufferHeight)
+{
+    clusterData.scale.x = (float)TilesX / (float)framebufferWidth;
+    clusterData.scale.y = (float)TilesY / (float)framebufferHeight;
+    clusterUniformBuffer.update(clusterData);
+    GLStateCache::bindBuffer(GL_TEXTURE_BUFFER, buffers[0]);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)clusters.size() * sizeof(glm::uvec2), clusters.data(), GL_STREAM_DRAW);
+    // 纹理缓冲不能为空,没有任何下标时保留一个元素
+    GLStateCache::bindBuffer(GL_TEXTURE_BUFFER, buffers[1]);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)std::max(lightIndices.size(), (size_t)1) * sizeof(uint32_t),
+                 lightIndices.empty() ? nullptr : lightIndices.data(), GL_STREAM_DRAW);
+}
+
+// 把三个纹理缓冲绑定到firstUnit开始的纹理单元
+void ClusteredLighting::bind(GLuint firstUnit) const
+{
+    for(int i = 0; i < TextureCount; i++)
+        GLStateCache::bindTexture(firstUnit + i, GL_TEXTURE_BUFFER, textures[i]);
+}
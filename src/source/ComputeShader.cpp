@@ -0,0 +1,64 @@
+#include "ComputeShader.h"
+#include "GLExtension.h"
+#include "GLStateCache.h"
+#include "ShaderSource.h"
+#include <iostream>
+
+// 构造函数,读取并编译计算着色器,defines为注入的宏
+ComputeShader::ComputeShader(const std::string &path, const std::vector<std::string> &defines)
+    : id(0), path(path), bIsValid(false)
+{
+    ShaderSource source(path, defines);
+    if(!source.isValid())
+    {
+        std::cout << source.getError() << std::endl;
+        return;
+    }
+
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, source.getSegmentCount(), source.getSegments(), source.getLengths());
+    glCompileShader(shader);
+    id = glCreateProgram();
+    glAttachShader(id, shader);
+    glLinkProgram(id);
+
+    // 链接失败时再查询编译日志
+    GLint bIsLinked = GL_FALSE;
+    glGetProgramiv(id, GL_LINK_STATUS, &bIsLinked);
+    if(!bIsLinked)
+    {
+        char infoLog[512];
+        GLint bIsCompiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &bIsCompiled);
+        if(!bIsCompiled)
+        {
+            glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+            std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED" << infoLog << std::endl;
+            std::cout << "## " << path << " ##" << std::endl;
+        }
+        glGetProgramInfoLog(id, sizeof(infoLog), nullptr, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED" << infoLog << std::endl;
+    }
+    glDetachShader(id, shader);
+    glDeleteShader(shader);
+    bIsValid = bIsLinked != GL_FALSE;
+}
+
+// 使用程序
+void ComputeShader::use() const
+{
+    GLStateCache::useProgram(id);
+}
+
+// 查询Uniform位置,不存在时为-1
+GLint ComputeShader::uniformLocation(const std::string &name) const
+{
+    return glGetUniformLocation(id, name.c_str());
+}
+
+// 使用程序并按工作组数量分派
+void ComputeShader::dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ) const
+{
+    use();
+    glDispatchCompute(groupsX, groupsY, groupsZ);
+}
@@ -0,0 +1,272 @@
+#include "DeferredRenderer.h"
+#include "GLStateCache.h"
+#include "MeshBuilder.h"
+#include "PointLightList.h"
+#include "ShadowMaps.h"
+#include "UniformBlocks.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// 光源体积的经线与纬线分段数
+static const int VolumeSegments = 16;
+static const int VolumeRings = 8;
+
+// 构建外接单位球的经纬球,三角形从外部看为逆时针
+// 面的中心离球心最近,按两个方向的分段角放大顶点,保证整个单位球都在体积内
+static MeshData buildVolume()
+{
+    const float pi = 3.14159265358979f;
+    float scale = 1.0f / (std::cos(pi / VolumeSegments) * std::cos(pi / (2.0f * VolumeRings)));
+    auto vertex = [&](int ring, int segment)
+    {
+        if(0 == ring)
+            return glm::vec3(0.0f, scale, 0.0f);
+        if(VolumeRings == ring)
+            return glm::vec3(0.0f, -scale, 0.0f);
+        float theta = pi * ring / VolumeRings;
+        float phi = 2.0f * pi * segment / VolumeSegments;
+        return scale * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+    };
+    std::vector<float> vertices;
+    auto push = [&](const glm::vec3 &position)
+    {
+        vertices.push_back(position.x);
+        vertices.push_back(position.y);
+        vertices.push_back(position.z);
+    };
+    for(int ring = 0; ring < VolumeRings; ring++)
+    {
+        for(int segment = 0; segment < VolumeSegments; segment++)
+        {
+            glm::vec3 a = vertex(ring, segment);
+            glm::vec3 b = vertex(ring + 1, segment);
+            glm::vec3 c = vertex(ring + 1, segment + 1);
+            glm::vec3 d = vertex(ring, segment + 1);
+            // 两极的一行只有一个三角形
+            if(ring != VolumeRings - 1)
+            {
+                push(a);
+                push(c);
+                push(b);
+            }
+            if(ring != 0)
+            {
+                push(a);
+                push(d);
+                push(c);
+            }
+        }
+    }
+    return MeshBuilder::build("light volume", vertices.data(), vertices.size() / 3, 3);
+}
+
+// 构造函数,创建width x height的几何缓冲与光源体积
+DeferredRenderer::DeferredRenderer(GLsizei width, GLsizei height)
+    : framebuffer(0), depthTexture(0), width(width), height(height), volumeMesh(buildVolume(), {{0, 3, 0}}),
+      volumeVertexArray(0), lightBuffer(0), boundsBuffer(0), lightCount(0), emptyVertexArray(0),
+      lightingShaders("Deferred/Lighting.vs.glsl", "Deferred/Lighting.fs.glsl"), shadowTextureUnit(0)
+{
+    for(GLuint &texture : textures)
+        texture = 0;
+    glGenFramebuffers(1, &framebuffer);
+    createAttachments();
+
+    // 光源体积VAO,每实例前进一次读取影响范围与光源参数
+    // PointLightData按std140布局,衰减的三个系数连续存放,可以作为一个vec3读取
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    lightBuffer = buffers[0];
+    boundsBuffer = buffers[1];
+    volumeVertexArray = volumeMesh.createVertexArray();
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, boundsBuffer);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)0);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, lightBuffer);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(PointLightData), (void *)offsetof(PointLightData, constant));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(PointLightData), (void *)offsetof(PointLightData, ambient));
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(PointLightData), (void *)offsetof(PointLightData, diffuse));
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(PointLightData), (void *)offsetof(PointLightData, specular));
+    for(GLuint location = 1; location <= 5; location++)
+    {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    // 核心模式下绘制需要绑定VAO,全屏三角形不读取任何属性
+    glGenVertexArrays(1, &emptyVertexArray);
+
+    for(int i = 0; i < 2; i++)
+    {
+        for(int j = 0; j < 2; j++)
+            programs[i][j].shader = nullptr;
+    }
+}
+
+// 把不带阴影的两个光照变体提交到着色器库,与其他启动时的程序一起编译
+void DeferredRenderer::prebuildShaders(ShaderLibrary &library)
+{
+    lightingShaders.prebuild({0, lightingShaders.keywordMask({"DIRECTION_LIGHT"})}, library);
+}
+
+// 获取光照程序,第一次使用时编译并设置纹理单元
+DeferredRenderer::LightingProgram &DeferredRenderer::getProgram(bool bIsDirectionLight, bool bHasShadows)
+{
+    LightingProgram &program = programs[bIsDirectionLight ? 1 : 0][bHasShadows ? 1 : 0];
+    if(program.shader)
+    {
+        return program;
+    }
+    std::vector<std::string> keywords;
+    if(bIsDirectionLight)
+        keywords.push_back("DIRECTION_LIGHT");
+    if(bHasShadows)
+        keywords.push_back("SHADOWS");
+    Shader *shader = lightingShaders.get(keywords);
+    shader->set(shader->uniform("gDepth"), 0);
+    shader->set(shader->uniform("gNormal"), 1 + Normal);
+    shader->set(shader->uniform("gDiffuse"), 1 + Diffuse);
+    shader->set(shader->uniform("gSpecular"), 1 + Specular);
+    ShadowMaps::setSamplers(shader, shadowTextureUnit);
+    program.shader = shader;
+    program.inverseViewProjectionHandle = shader->uniform("inverseViewProjection");
+    return program;
+}
+
+// 设置热重载监视器
+void DeferredRenderer::setWatcher(ShaderWatcher *shaderWatcher)
+{
+    lightingShaders.setWatcher(shaderWatcher);
+}
+
+// 改变几何缓冲大小,大小未改变时不做任何事
+void DeferredRenderer::resize(GLsizei width, GLsizei height)
+{
+    if(width == this->width && height == this->height)
+    {
+        return;
+    }
+    this->width = width;
+    this->height = height;
+    createAttachments();
+}
+
+// 按当前大小创建附件纹理
+void DeferredRenderer::createAttachments()
+{
+    // 纹理大小不可变之前不能重新分配存储,删除后重新创建
+    for(GLuint &texture : textures)
+    {
+        if(texture)
+            GLStateCache::deleteTexture(texture);
+    }
+    if(depthTexture)
+        GLStateCache::deleteTexture(depthTexture);
+    glGenTextures(AttachmentCount, textures);
+    glGenTextures(1, &depthTexture);
+
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    const GLenum internalFormats[AttachmentCount] = {GL_RGBA16F, GL_RGBA8, GL_RGBA8, GL_RGBA16F};
+    for(int i = 0; i < AttachmentCount; i++)
+    {
+        GLStateCache::bindTexture(0, GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+        // 只用texelFetch读取,不需要过滤与Mipmap
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i], 0);
+    }
+    GLStateCache::bindTexture(0, GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::DEFERRED::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// 上传光源,光源改变时调用
+void DeferredRenderer::setLights(const PointLightList &lights)
+{
+    lightCount = (GLsizei)lights.size();
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, lightBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)lights.size() * sizeof(PointLightData), lights.getLights(), GL_STATIC_DRAW);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, boundsBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)lights.size() * sizeof(glm::vec4), lights.getBounds(), GL_STATIC_DRAW);
+}
+
+// 开始几何阶段,绑定几何缓冲并清除,之后用GBUFFER变体绘制不透明物体
+void DeferredRenderer::beginGeometryPass()
+{
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    const GLenum drawBuffers[AttachmentCount] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3};
+    glDrawBuffers(AttachmentCount, drawBuffers);
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+// 光照阶段,累积所有点光源,bUseDirectionLight为true时另外累积平行光
+void DeferredRenderer::drawLights(const glm::mat4 &viewProjection, bool bUseDirectionLight, bool bUseShadows)
+{
+    // 只写入光照缓冲,深度只读,片段着色器从纹理读取几何缓冲
+    glDrawBuffer(GL_COLOR_ATTACHMENT0 + Lighting);
+    GLStateCache::bindTexture(0, GL_TEXTURE_2D, depthTexture);
+    for(int i = 0; i < Lighting; i++)
+        GLStateCache::bindTexture(1 + i, GL_TEXTURE_2D, textures[i]);
+    GLStateCache::depthMask(GL_FALSE);
+    GLStateCache::setEnabled(GL_BLEND, true);
+    GLStateCache::blendFunc(GL_ONE, GL_ONE);
+    glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+
+    if(bUseDirectionLight)
+    {
+        GLStateCache::setEnabled(GL_DEPTH_TEST, false);
+        LightingProgram &program = getProgram(true, bUseShadows);
+        program.shader->set(program.inverseViewProjectionHandle, inverseViewProjection);
+        program.shader->use();
+        GLStateCache::bindVertexArray(emptyVertexArray);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    if(lightCount > 0)
+    {
+        // 只画体积的背面,背面在几何体之后(深度大于等于)才可能照亮该像素,相机在体积内时也成立
+        // 开启深度截取,超出远平面的背面不被裁掉
+        GLStateCache::setEnabled(GL_DEPTH_TEST, true);
+        GLStateCache::depthFunc(GL_GEQUAL);
+        GLStateCache::setEnabled(GL_CULL_FACE, true);
+        GLStateCache::cullFace(GL_FRONT);
+        GLStateCache::setEnabled(GL_DEPTH_CLAMP, true);
+        LightingProgram &program = getProgram(false, bUseShadows);
+        program.shader->set(program.inverseViewProjectionHandle, inverseViewProjection);
+        program.shader->use();
+        volumeMesh.drawInstanced(volumeVertexArray, lightCount);
+        GLStateCache::setEnabled(GL_DEPTH_CLAMP, false);
+        GLStateCache::cullFace(GL_BACK);
+        GLStateCache::setEnabled(GL_CULL_FACE, false);
+        GLStateCache::depthFunc(GL_LESS);
+    }
+
+    GLStateCache::setEnabled(GL_DEPTH_TEST, true);
+    GLStateCache::setEnabled(GL_BLEND, false);
+    GLStateCache::depthMask(GL_TRUE);
+}
+
+// 开始前向阶段,之后绘制的物体写入光照缓冲,与几何阶段的深度比较
+void DeferredRenderer::beginForwardPass()
+{
+    glDrawBuffer(GL_COLOR_ATTACHMENT0 + Lighting);
+}
+
+// 把光照缓冲复制到默认帧缓冲,并重新绑定默认帧缓冲
+void DeferredRenderer::present()
+{
+    GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0 + Lighting);
+    GLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,21 @@
+#include "EmbeddedShaders.h"
+#include <cstring>
+
+// 按路径查找,路径需要是规范化的相对路径,不存在时返回nullptr
+const EmbeddedShader *EmbeddedShaders::find(const std::string &path)
+{
+    size_t low = 0;
+    size_t high = count;
+    while(low < high)
+    {
+        size_t middle = (low + high) / 2;
+        int result = std::strcmp(entries[middle].path, path.c_str());
+        if(0 == result)
+            return &entries[middle];
+        if(result < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return nullptr;
+}
@@ -0,0 +1,361 @@
+#include "FrustumCuller.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OPENGLTUTORIAL_FRUSTUM_SSE 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define OPENGLTUTORIAL_FRUSTUM_AVX2 1
+#include <immintrin.h>
+#endif
+
+// 从裁剪矩阵乘视图矩阵中提取平面,glm按列存储,m[c][r]为第r行第c列
+Frustum Frustum::fromMatrix(const glm::mat4 &viewProjection)
+{
+    const glm::mat4 &m = viewProjection;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0;
+    frustum.planes[1] = row3 - row0;
+    frustum.planes[2] = row3 + row1;
+    frustum.planes[3] = row3 - row1;
+    frustum.planes[4] = row3 + row2;
+    frustum.planes[5] = row3 - row2;
+    // 法线归一化后平面方程的值才是距离,才能与半径比较
+    for(glm::vec4 &plane : frustum.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+// 设置包围球数量
+void SphereBounds::resize(size_t count)
+{
+    centerX.resize(count);
+    centerY.resize(count);
+    centerZ.resize(count);
+    radius.resize(count);
+}
+
+// 设置第index个包围球
+void SphereBounds::set(size_t index, const glm::vec3 &center, float sphereRadius)
+{
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    radius[index] = sphereRadius;
+}
+
+// 设置包围盒数量
+void BoxBounds::resize(size_t count)
+{
+    centerX.resize(count);
+    centerY.resize(count);
+    centerZ.resize(count);
+    extentX.resize(count);
+    extentY.resize(count);
+    extentZ.resize(count);
+}
+
+// 设置第index个包围盒
+void BoxBounds::set(size_t index, const glm::vec3 &minimum, const glm::vec3 &maximum)
+{
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    glm::vec3 extent = (maximum - minimum) * 0.5f;
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    extentX[index] = extent.x;
+    extentY[index] = extent.y;
+    extentZ[index] = extent.z;
+}
+
+// 剔除用的结构数组指针,包围球只使用a作为半径,包围盒的a、b、c为三个轴的半长
+struct CullInput
+{
+    const float *x;
+    const float *y;
+    const float *z;
+    const float *a;
+    const float *b;
+    const float *c;
+};
+
+// 标量版本,物体中心到平面的距离加上物体在平面法线上的投影半径小于0时在平面外
+template<bool bIsBox>
+static size_t cullScalar(const Frustum &frustum, const CullInput &input, size_t begin, size_t end, uint32_t *visible)
+{
+    size_t count = 0;
+    for(size_t i = begin; i < end; i++)
+    {
+        bool bIsInside = true;
+        for(const glm::vec4 &plane : frustum.planes)
+        {
+            float distance = plane.x * input.x[i] + plane.y * input.y[i] + plane.z * input.z[i] + plane.w;
+            float radius = bIsBox ? std::fabs(plane.x) * input.a[i] + std::fabs(plane.y) * input.b[i] + std::fabs(plane.z) * input.c[i]
+                                  : input.a[i];
+            if(distance + radius < 0.0f)
+            {
+                bIsInside = false;
+                break;
+            }
+        }
+        // 无分支写入,不可见时下一个物体覆盖
+        visible[count] = (uint32_t)i;
+        count += bIsInside ? 1 : 0;
+    }
+    return count;
+}
+
+#ifdef OPENGLTUTORIAL_FRUSTUM_SSE
+// SSE版本,一次测试4个物体,剩余不足4个的物体使用标量版本
+template<bool bIsBox>
+static size_t cullSSE(const Frustum &frustum, const CullInput &input, size_t begin, size_t end, uint32_t *visible)
+{
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    __m128 absX[6], absY[6], absZ[6];
+    for(int p = 0; p < 6; p++)
+    {
+        const glm::vec4 &plane = frustum.planes[p];
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        planeW[p] = _mm_set1_ps(plane.w);
+        absX[p] = _mm_set1_ps(std::fabs(plane.x));
+        absY[p] = _mm_set1_ps(std::fabs(plane.y));
+        absZ[p] = _mm_set1_ps(std::fabs(plane.z));
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    size_t count = 0;
+    size_t i = begin;
+    for(; i + 4 <= end; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(input.x + i);
+        __m128 y = _mm_loadu_ps(input.y + i);
+        __m128 z = _mm_loadu_ps(input.z + i);
+        __m128 a = _mm_loadu_ps(input.a + i);
+        __m128 b = bIsBox ? _mm_loadu_ps(input.b + i) : zero;
+        __m128 c = bIsBox ? _mm_loadu_ps(input.c + i) : zero;
+        __m128 outside = zero;
+        for(int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+            __m128 radius = bIsBox ? _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], a), _mm_mul_ps(absY[p], b)), _mm_mul_ps(absZ[p], c))
+                                   : a;
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+        int mask = ~_mm_movemask_ps(outside) & 0xF;
+        for(int k = 0; k < 4; k++)
+        {
+            visible[count] = (uint32_t)(i + k);
+            count += (mask >> k) & 1;
+        }
+    }
+    return count + cullScalar<bIsBox>(frustum, input, i, end, visible + count);
+}
+#endif
+
+#ifdef OPENGLTUTORIAL_FRUSTUM_AVX2
+// AVX2版本,一次测试8个物体,剩余不足8个的物体使用SSE版本
+template<bool bIsBox>
+static size_t cullAVX2(const Frustum &frustum, const CullInput &input, size_t begin, size_t end, uint32_t *visible)
+{
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+    __m256 absX[6], absY[6], absZ[6];
+    for(int p = 0; p < 6; p++)
+    {
+        const glm::vec4 &plane = frustum.planes[p];
+        planeX[p] = _mm256_set1_ps(plane.x);
+        planeY[p] = _mm256_set1_ps(plane.y);
+        planeZ[p] = _mm256_set1_ps(plane.z);
+        planeW[p] = _mm256_set1_ps(plane.w);
+        absX[p] = _mm256_set1_ps(std::fabs(plane.x));
+        absY[p] = _mm256_set1_ps(std::fabs(plane.y));
+        absZ[p] = _mm256_set1_ps(std::fabs(plane.z));
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+    size_t count = 0;
+    size_t i = begin;
+    for(; i + 8 <= end; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(input.x + i);
+        __m256 y = _mm256_loadu_ps(input.y + i);
+        __m256 z = _mm256_loadu_ps(input.z + i);
+        __m256 a = _mm256_loadu_ps(input.a + i);
+        __m256 b = bIsBox ? _mm256_loadu_ps(input.b + i) : zero;
+        __m256 c = bIsBox ? _mm256_loadu_ps(input.c + i) : zero;
+        __m256 outside = zero;
+        for(int p = 0; p < 6; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                                            _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+            __m256 radius = bIsBox ? _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], a), _mm256_mul_ps(absY[p], b)), _mm256_mul_ps(absZ[p], c))
+                                   : a;
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+        }
+        int mask = ~_mm256_movemask_ps(outside) & 0xFF;
+        for(int k = 0; k < 8; k++)
+        {
+            visible[count] = (uint32_t)(i + k);
+            count += (mask >> k) & 1;
+        }
+    }
+    return count + cullSSE<bIsBox>(frustum, input, i, end, visible + count);
+}
+#endif
+
+// 按指令集选择实现
+template<bool bIsBox>
+static size_t cullRange(const Frustum &frustum, const CullInput &input, size_t begin, size_t end, uint32_t *visible,
+                        FrustumCuller::InstructionSet set)
+{
+    switch(set)
+    {
+#ifdef OPENGLTUTORIAL_FRUSTUM_AVX2
+    case FrustumCuller::AVX2:
+        return cullAVX2<bIsBox>(frustum, input, begin, end, visible);
+#endif
+#ifdef OPENGLTUTORIAL_FRUSTUM_SSE
+    case FrustumCuller::SSE:
+        return cullSSE<bIsBox>(frustum, input, begin, end, visible);
+#endif
+    default:
+        return cullScalar<bIsBox>(frustum, input, begin, end, visible);
+    }
+}
+
+// 构造函数,默认使用编译支持的最快指令集
+FrustumCuller::FrustumCuller(ThreadPool *threadPool) : threadPool(threadPool), instructionSet(getBestInstructionSet())
+{
+}
+
+// 编译支持的最快指令集
+FrustumCuller::InstructionSet FrustumCuller::getBestInstructionSet()
+{
+    if(isSupported(AVX2))
+        return AVX2;
+    if(isSupported(SSE))
+        return SSE;
+    return Scalar;
+}
+
+// 指令集名称
+const char *FrustumCuller::getInstructionSetName(InstructionSet instructionSet)
+{
+    switch(instructionSet)
+    {
+    case AVX2:
+        return "AVX2";
+    case SSE:
+        return "SSE";
+    default:
+        return "scalar";
+    }
+}
+
+// 是否编译了指令集
+bool FrustumCuller::isSupported(InstructionSet instructionSet)
+{
+    switch(instructionSet)
+    {
+#ifdef OPENGLTUTORIAL_FRUSTUM_AVX2
+    case AVX2:
+        return true;
+#endif
+#ifdef OPENGLTUTORIAL_FRUSTUM_SSE
+    case SSE:
+        return true;
+#endif
+    case Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 设置使用的指令集,不支持时保持不变
+void FrustumCuller::setInstructionSet(InstructionSet set)
+{
+    if(isSupported(set))
+        instructionSet = set;
+}
+
+// 在线程池中剔除,每块的结果先写在块的起点,再依次向前移动,cullRange(begin, end, output)返回可见数量
+template<typename CullRange>
+size_t FrustumCuller::cullParallel(size_t count, std::vector<uint32_t> &visible, const CullRange &cullRange)
+{
+    visible.resize(count);
+    size_t chunks = threadPool ? threadPool->getChunkCount(count, MinChunkSize) : 1;
+    if(chunks <= 1)
+    {
+        size_t visibleCount = count ? cullRange(0, count, visible.data()) : 0;
+        visible.resize(visibleCount);
+        return visibleCount;
+    }
+
+    chunkCounts.resize(chunks);
+    uint32_t *output = visible.data();
+    threadPool->parallelFor(count, MinChunkSize, [&](size_t begin, size_t end, size_t chunk)
+    {
+        chunkCounts[chunk] = cullRange(begin, end, output + begin);
+    });
+
+    size_t visibleCount = 0;
+    for(size_t chunk = 0; chunk < chunks; chunk++)
+    {
+        size_t begin = count * chunk / chunks;
+        if(visibleCount != begin)
+            std::memmove(output + visibleCount, output + begin, chunkCounts[chunk] * sizeof(uint32_t));
+        visibleCount += chunkCounts[chunk];
+    }
+    visible.resize(visibleCount);
+    return visibleCount;
+}
+
+// 剔除包围球,visible为升序的可见下标,返回可见数量
+size_t FrustumCuller::cull(const Frustum &frustum, const SphereBounds &bounds, std::vector<uint32_t> &visible)
+{
+    InstructionSet set = instructionSet;
+    return cullParallel(bounds.size(), visible, [&](size_t begin, size_t end, uint32_t *output)
+    {
+        return cullSpheres(frustum, bounds, begin, end, output, set);
+    });
+}
+
+// 剔除包围盒,visible为升序的可见下标,返回可见数量
+size_t FrustumCuller::cull(const Frustum &frustum, const BoxBounds &bounds, std::vector<uint32_t> &visible)
+{
+    InstructionSet set = instructionSet;
+    return cullParallel(bounds.size(), visible, [&](size_t begin, size_t end, uint32_t *output)
+    {
+        return cullBoxes(frustum, bounds, begin, end, output, set);
+    });
+}
+
+// 剔除[begin, end)范围内的包围球,可见下标写入visible,visible至少能容纳end-begin个下标
+size_t FrustumCuller::cullSpheres(const Frustum &frustum, const SphereBounds &bounds, size_t begin, size_t end,
+                                  uint32_t *visible, InstructionSet set)
+{
+    CullInput input = {bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(), bounds.radius.data(), nullptr, nullptr};
+    return cullRange<false>(frustum, input, begin, end, visible, set);
+}
+
+// 剔除[begin, end)范围内的包围盒,可见下标写入visible,visible至少能容纳end-begin个下标
+size_t FrustumCuller::cullBoxes(const Frustum &frustum, const BoxBounds &bounds, size_t begin, size_t end,
+                                uint32_t *visible, InstructionSet set)
+{
+    CullInput input = {bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(),
+                       bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data()};
+    return cullRange<true>(frustum, input, begin, end, visible, set);
+}
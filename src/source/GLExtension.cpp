@@ -0,0 +1,109 @@
+#include "GLExtension.h"
+
+PFNGLGETPROGRAMBINARYEXTPROC glext_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYEXTPROC glext_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIEXTPROC glext_glProgramParameteri = nullptr;
+PFNGLMAXSHADERCOMPILERTHREADSEXTPROC glext_glMaxShaderCompilerThreadsKHR = nullptr;
+PFNGLDISPATCHCOMPUTEEXTPROC glext_glDispatchCompute = nullptr;
+PFNGLMEMORYBARRIEREXTPROC glext_glMemoryBarrier = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC glext_glMultiDrawElementsIndirect = nullptr;
+PFNGLCLEARBUFFERDATAEXTPROC glext_glClearBufferData = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTEXTPROC glext_glMultiDrawElementsIndirectCountARB = nullptr;
+PFNGLBUFFERSTORAGEEXTPROC glext_glBufferStorage = nullptr;
+
+bool GLExtension::bProgramBinary = false;
+bool GLExtension::bParallelShaderCompile = false;
+bool GLExtension::bMultiDrawIndirect = false;
+bool GLExtension::bIndirectParameters = false;
+bool GLExtension::bBufferStorage = false;
+bool GLExtension::bTextureCompressionS3TC = false;
+bool GLExtension::bIsLimitedTo33 = false;
+
+// 加载扩展函数,需要在gladLoadGLLoader之后调用
+void GLExtension::load(GLADloadproc loader)
+{
+    // 程序二进制
+    if(hasVersion(4, 1) || hasExtension("GL_ARB_get_program_binary"))
+    {
+        glext_glGetProgramBinary = (PFNGLGETPROGRAMBINARYEXTPROC)loader("glGetProgramBinary");
+        glext_glProgramBinary = (PFNGLPROGRAMBINARYEXTPROC)loader("glProgramBinary");
+        glext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIEXTPROC)loader("glProgramParameteri");
+
+        // 驱动可能声明支持但没有提供任何二进制格式,例如部分软件渲染器
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        bProgramBinary = glext_glGetProgramBinary && glext_glProgramBinary && glext_glProgramParameteri && formatCount > 0;
+    }
+
+    // 并行编译着色器,KHR与ARB两个版本的函数与枚举值相同
+    if(hasExtension("GL_KHR_parallel_shader_compile"))
+    {
+        glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)loader("glMaxShaderCompilerThreadsKHR");
+    }
+    else if(hasExtension("GL_ARB_parallel_shader_compile"))
+    {
+        glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)loader("glMaxShaderCompilerThreadsARB");
+    }
+    if(glext_glMaxShaderCompilerThreadsKHR)
+    {
+        // 0xFFFFFFFF表示由驱动决定线程数量
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        bParallelShaderCompile = true;
+    }
+
+    // 计算着色器剔除与多重间接绘制
+    if(hasVersion(4, 3) && hasExtension("GL_ARB_shader_storage_buffer_object") && hasExtension("GL_ARB_shading_language_420pack"))
+    {
+        glext_glDispatchCompute = (PFNGLDISPATCHCOMPUTEEXTPROC)loader("glDispatchCompute");
+        glext_glMemoryBarrier = (PFNGLMEMORYBARRIEREXTPROC)loader("glMemoryBarrier");
+        glext_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC)loader("glMultiDrawElementsIndirect");
+        glext_glClearBufferData = (PFNGLCLEARBUFFERDATAEXTPROC)loader("glClearBufferData");
+        bMultiDrawIndirect = glext_glDispatchCompute && glext_glMemoryBarrier && glext_glMultiDrawElementsIndirect && glext_glClearBufferData;
+    }
+    if(bMultiDrawIndirect && (hasVersion(4, 6) || hasExtension("GL_ARB_indirect_parameters")))
+    {
+        // 4.6核心函数与扩展函数参数相同
+        glext_glMultiDrawElementsIndirectCountARB = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTEXTPROC)loader(hasVersion(4, 6) ? "glMultiDrawElementsIndirectCount" : "glMultiDrawElementsIndirectCountARB");
+        bIndirectParameters = glext_glMultiDrawElementsIndirectCountARB != nullptr;
+    }
+
+    // 不可变存储与持久映射,限制为3.3时把它当作不支持,用于测试回退路径
+    if(hasVersion(4, 4) || (!bIsLimitedTo33 && hasExtension("GL_ARB_buffer_storage")))
+    {
+        glext_glBufferStorage = (PFNGLBUFFERSTORAGEEXTPROC)loader("glBufferStorage");
+        bBufferStorage = glext_glBufferStorage != nullptr;
+    }
+
+    // S3TC压缩贴图,只需要枚举值
+    bTextureCompressionS3TC = hasExtension("GL_EXT_texture_compression_s3tc");
+}
+
+// 判断当前上下文是否支持某个扩展
+bool GLExtension::hasExtension(const std::string &name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for(GLint i = 0; i < count; i++)
+    {
+        const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if(extension && name == extension)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 判断当前上下文版本是否不低于major.minor
+bool GLExtension::hasVersion(int major, int minor)
+{
+    if(bIsLimitedTo33 && (major > 3 || (major == 3 && minor > 3)))
+    {
+        return false;
+    }
+    GLint contextMajor = 0;
+    GLint contextMinor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+    glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+    return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
@@ -0,0 +1,387 @@
+#include "GLStateCache.h"
+
+#include <cstddef>
+
+// GL 3.3之后的缓冲目标,glad中没有定义
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_DISPATCH_INDIRECT_BUFFER
+#define GL_DISPATCH_INDIRECT_BUFFER 0x90EE
+#endif
+
+// 未知状态,下一次设置一定会调用GL
+static const GLuint UnknownState = 0xFFFFFFFFu;
+
+// 缓存的纹理单元数量,超出的单元不做缓存
+static const GLuint MaxTextureUnits = 32;
+// 缓存的纹理目标
+static const GLenum TextureTargets[] = {GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BUFFER, GL_TEXTURE_3D};
+static const int TextureTargetCount = sizeof(TextureTargets) / sizeof(TextureTargets[0]);
+
+// 缓存的缓冲目标,元素缓冲绑定属于VAO状态单独处理
+static const GLenum BufferTargets[] = {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_UNPACK_BUFFER,
+                                       GL_PIXEL_PACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_TEXTURE_BUFFER,
+                                       GL_DRAW_INDIRECT_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_DISPATCH_INDIRECT_BUFFER};
+static const int BufferTargetCount = sizeof(BufferTargets) / sizeof(BufferTargets[0]);
+
+// 缓存的索引绑定点数量
+static const GLuint MaxIndexedBindings = 16;
+// 有索引绑定点的缓冲目标
+static const GLenum IndexedBufferTargets[] = {GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER};
+static const int IndexedBufferTargetCount = sizeof(IndexedBufferTargets) / sizeof(IndexedBufferTargets[0]);
+
+// 缓存的开关功能
+static const GLenum Capabilities[] = {GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_FRAMEBUFFER_SRGB};
+static const int CapabilityCount = sizeof(Capabilities) / sizeof(Capabilities[0]);
+
+// 上下文状态,初始值为GL的默认状态
+static struct
+{
+    GLuint program;
+    GLuint vertexArray;
+    GLuint activeTexture;
+    GLuint textures[MaxTextureUnits][TextureTargetCount];
+    GLuint buffers[BufferTargetCount];
+    GLuint indexedBuffers[IndexedBufferTargetCount][MaxIndexedBindings];
+    GLuint drawFramebuffer;
+    GLuint readFramebuffer;
+    GLuint capabilities[CapabilityCount];
+    GLuint depthFunc;
+    GLuint depthMask;
+    GLuint polygonMode;
+    GLuint blendSource;
+    GLuint blendDestination;
+    GLuint cullFace;
+} state;
+
+// 当前帧与上一帧的统计
+static GLStateCounters currentCounters = {0, 0, 0, 0};
+static GLStateCounters frameCounters = {0, 0, 0, 0};
+
+// 按GL默认状态初始化缓存
+static bool initializeDefaultState()
+{
+    state.program = 0;
+    state.vertexArray = 0;
+    state.activeTexture = GL_TEXTURE0;
+    for(auto &unit : state.textures)
+        for(auto &texture : unit)
+            texture = 0;
+    for(auto &buffer : state.buffers)
+        buffer = 0;
+    for(auto &target : state.indexedBuffers)
+        for(auto &buffer : target)
+            buffer = 0;
+    state.drawFramebuffer = 0;
+    state.readFramebuffer = 0;
+    for(auto &capability : state.capabilities)
+        capability = GL_FALSE;
+    state.depthFunc = GL_LESS;
+    state.depthMask = GL_TRUE;
+    state.polygonMode = GL_FILL;
+    state.blendSource = GL_ONE;
+    state.blendDestination = GL_ZERO;
+    state.cullFace = GL_BACK;
+    return true;
+}
+
+// 静态初始化时设置为默认状态,不调用GL
+static const bool bIsDefaultStateReady = initializeDefaultState();
+
+// 比较并更新缓存的值,改变时返回true
+static bool changeState(GLuint &cached, GLuint value)
+{
+    if(cached == value)
+    {
+        currentCounters.elided++;
+        return false;
+    }
+    cached = value;
+    currentCounters.issued++;
+    return true;
+}
+
+// 查找表中的下标,不存在返回-1
+static int findIndex(const GLenum *table, int count, GLenum value)
+{
+    for(int i = 0; i < count; i++)
+    {
+        if(table[i] == value)
+            return i;
+    }
+    return -1;
+}
+
+// 使用着色器程序
+void GLStateCache::useProgram(GLuint program)
+{
+    if(changeState(state.program, program))
+        glUseProgram(program);
+}
+
+// 绑定顶点数组对象,元素缓冲绑定属于VAO状态,切换后重新记录
+void GLStateCache::bindVertexArray(GLuint vertexArray)
+{
+    if(changeState(state.vertexArray, vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+        state.buffers[findIndex(BufferTargets, BufferTargetCount, GL_ELEMENT_ARRAY_BUFFER)] = UnknownState;
+    }
+}
+
+// 激活纹理单元,unit为GL_TEXTURE0+n
+void GLStateCache::activeTexture(GLenum unit)
+{
+    if(changeState(state.activeTexture, unit))
+        glActiveTexture(unit);
+}
+
+// 绑定纹理到纹理单元,unit为单元序号
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    int targetIndex = findIndex(TextureTargets, TextureTargetCount, target);
+    if(unit >= MaxTextureUnits || targetIndex < 0)
+    {
+        activeTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        currentCounters.issued++;
+        return;
+    }
+    if(changeState(state.textures[unit][targetIndex], texture))
+    {
+        activeTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+    }
+}
+
+// 绑定缓冲对象
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    int targetIndex = findIndex(BufferTargets, BufferTargetCount, target);
+    if(targetIndex < 0)
+    {
+        glBindBuffer(target, buffer);
+        currentCounters.issued++;
+        return;
+    }
+    if(changeState(state.buffers[targetIndex], buffer))
+        glBindBuffer(target, buffer);
+}
+
+// 绑定缓冲对象到索引绑定点,同时会改变target的通用绑定
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    int targetIndex = findIndex(IndexedBufferTargets, IndexedBufferTargetCount, target);
+    if(targetIndex < 0 || index >= MaxIndexedBindings)
+    {
+        glBindBufferBase(target, index, buffer);
+        currentCounters.issued++;
+    }
+    else if(changeState(state.indexedBuffers[targetIndex][index], buffer))
+    {
+        glBindBufferBase(target, index, buffer);
+    }
+    else
+    {
+        return;
+    }
+    int genericIndex = findIndex(BufferTargets, BufferTargetCount, target);
+    if(genericIndex >= 0)
+        state.buffers[genericIndex] = buffer;
+}
+
+// 绑定缓冲对象的一段到索引绑定点
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    // 范围绑定不做比较,只保证之后的整体绑定一定会执行
+    glBindBufferRange(target, index, buffer, offset, size);
+    currentCounters.issued++;
+    int targetIndex = findIndex(IndexedBufferTargets, IndexedBufferTargetCount, target);
+    if(targetIndex >= 0 && index < MaxIndexedBindings)
+        state.indexedBuffers[targetIndex][index] = UnknownState;
+    int genericIndex = findIndex(BufferTargets, BufferTargetCount, target);
+    if(genericIndex >= 0)
+        state.buffers[genericIndex] = buffer;
+}
+
+// 绑定帧缓冲
+void GLStateCache::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    if(GL_FRAMEBUFFER == target)
+    {
+        bool bIsDrawChanged = changeState(state.drawFramebuffer, framebuffer);
+        bool bIsReadChanged = changeState(state.readFramebuffer, framebuffer);
+        if(bIsDrawChanged || bIsReadChanged)
+            glBindFramebuffer(target, framebuffer);
+    }
+    else if(GL_DRAW_FRAMEBUFFER == target)
+    {
+        if(changeState(state.drawFramebuffer, framebuffer))
+            glBindFramebuffer(target, framebuffer);
+    }
+    else if(changeState(state.readFramebuffer, framebuffer))
+    {
+        glBindFramebuffer(target, framebuffer);
+    }
+}
+
+// 开启或关闭功能,例如GL_DEPTH_TEST、GL_BLEND、GL_CULL_FACE
+void GLStateCache::setEnabled(GLenum capability, bool bIsEnabled)
+{
+    int index = findIndex(Capabilities, CapabilityCount, capability);
+    if(index >= 0 && !changeState(state.capabilities[index], bIsEnabled ? GL_TRUE : GL_FALSE))
+    {
+        return;
+    }
+    if(index < 0)
+        currentCounters.issued++;
+    if(bIsEnabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+// 设置深度比较函数
+void GLStateCache::depthFunc(GLenum func)
+{
+    if(changeState(state.depthFunc, func))
+        glDepthFunc(func);
+}
+
+// 设置深度写入
+void GLStateCache::depthMask(GLboolean bIsWritable)
+{
+    if(changeState(state.depthMask, bIsWritable))
+        glDepthMask(bIsWritable);
+}
+
+// 设置多边形模式,只支持GL_FRONT_AND_BACK
+void GLStateCache::polygonMode(GLenum mode)
+{
+    if(changeState(state.polygonMode, mode))
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+// 设置混合函数
+void GLStateCache::blendFunc(GLenum source, GLenum destination)
+{
+    bool bIsSourceChanged = changeState(state.blendSource, source);
+    bool bIsDestinationChanged = changeState(state.blendDestination, destination);
+    if(bIsSourceChanged || bIsDestinationChanged)
+        glBlendFunc(source, destination);
+}
+
+// 设置剔除面
+void GLStateCache::cullFace(GLenum face)
+{
+    if(changeState(state.cullFace, face))
+        glCullFace(face);
+}
+
+// 删除着色器程序,正在使用的程序在解除使用前不会真正删除,缓存保持不变
+void GLStateCache::deleteProgram(GLuint program)
+{
+    glDeleteProgram(program);
+}
+
+// 删除顶点数组对象,删除当前绑定的VAO时GL会绑定0
+void GLStateCache::deleteVertexArray(GLuint vertexArray)
+{
+    if(vertexArray != 0 && state.vertexArray == vertexArray)
+    {
+        state.vertexArray = 0;
+        state.buffers[findIndex(BufferTargets, BufferTargetCount, GL_ELEMENT_ARRAY_BUFFER)] = UnknownState;
+    }
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+// 删除缓冲对象,GL会把所有绑定了它的绑定点置为0
+void GLStateCache::deleteBuffer(GLuint buffer)
+{
+    if(buffer != 0)
+    {
+        for(auto &bound : state.buffers)
+            if(bound == buffer)
+                bound = 0;
+        for(auto &target : state.indexedBuffers)
+            for(auto &bound : target)
+                if(bound == buffer)
+                    bound = 0;
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+// 删除纹理,GL会把所有绑定了它的纹理单元置为0
+void GLStateCache::deleteTexture(GLuint texture)
+{
+    if(texture != 0)
+    {
+        for(auto &unit : state.textures)
+            for(auto &bound : unit)
+                if(bound == texture)
+                    bound = 0;
+    }
+    glDeleteTextures(1, &texture);
+}
+
+// 删除帧缓冲,删除当前绑定的帧缓冲时GL会绑定0
+void GLStateCache::deleteFramebuffer(GLuint framebuffer)
+{
+    if(framebuffer != 0)
+    {
+        if(state.drawFramebuffer == framebuffer)
+            state.drawFramebuffer = 0;
+        if(state.readFramebuffer == framebuffer)
+            state.readFramebuffer = 0;
+    }
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+// 获取当前使用的着色器程序
+GLuint GLStateCache::getProgram()
+{
+    return state.program;
+}
+
+// 把所有缓存状态置为未知,下一次调用一定会执行
+void GLStateCache::invalidate()
+{
+    GLuint *values = (GLuint *)&state;
+    for(size_t i = 0; i < sizeof(state) / sizeof(GLuint); i++)
+        values[i] = UnknownState;
+}
+
+// 记录一次Uniform上传,bIsIssued为false表示值未改变而跳过
+void GLStateCache::countUniformUpload(bool bIsIssued)
+{
+    if(bIsIssued)
+        currentCounters.uniformsIssued++;
+    else
+        currentCounters.uniformsSkipped++;
+}
+
+// 开始新的一帧,保存上一帧的统计并清零
+void GLStateCache::beginFrame()
+{
+    frameCounters = currentCounters;
+    currentCounters.issued = 0;
+    currentCounters.elided = 0;
+    currentCounters.uniformsIssued = 0;
+    currentCounters.uniformsSkipped = 0;
+}
+
+// 获取上一帧的统计
+GLStateCounters GLStateCache::getFrameCounters()
+{
+    return frameCounters;
+}
+
+// 获取当前帧到目前为止的统计
+GLStateCounters GLStateCache::getCurrentCounters()
+{
+    return currentCounters;
+}
@@ -0,0 +1,160 @@
+#include "IndirectRenderer.h"
+#include "FrustumCuller.h"
+#include "GLExtension.h"
+#include "GLStateCache.h"
+#include <numeric>
+
+// 计算着色器工作组大小,与FrustumCull.cs.glsl中的local_size_x一致
+static const GLuint CullGroupSize = 64;
+
+// 构造函数,编译剔除着色器并创建缓冲
+IndirectRenderer::IndirectRenderer()
+    : cullShader("Culling/FrustumCull.cs.glsl"), objectBuffer(0), meshBuffer(0), commandBuffer(0), drawCountBuffer(0),
+      commandOffsetBuffer(0), objectIndexBuffer(0), objectCount(0), objectIndexCapacity(0)
+{
+    frustumPlanesLocation = cullShader.uniformLocation("frustumPlanes");
+    objectCountLocation = cullShader.uniformLocation("objectCount");
+    GLuint buffers[6];
+    glGenBuffers(6, buffers);
+    objectBuffer = buffers[0];
+    meshBuffer = buffers[1];
+    commandBuffer = buffers[2];
+    drawCountBuffer = buffers[3];
+    commandOffsetBuffer = buffers[4];
+    objectIndexBuffer = buffers[5];
+}
+
+// 上传网格范围,物体通过meshIndex引用
+void IndirectRenderer::setMeshes(const IndirectMeshRange *meshes, GLuint meshCount)
+{
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, meshBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)meshCount * sizeof(IndirectMeshRange), meshes, GL_STATIC_DRAW);
+}
+
+// 上传物体数据,materialIndex需小于materialCount,按材质划分命令区域
+void IndirectRenderer::setObjects(const IndirectObjectData *objects, GLuint count, GLuint materialCount)
+{
+    objectCount = count;
+
+    // 每个材质的区域大小为该材质的物体数量,所有物体可见时也放得下
+    commandOffsets.assign(materialCount + 1, 0);
+    for(GLuint i = 0; i < count; i++)
+    {
+        commandOffsets[objects[i].materialIndex + 1]++;
+    }
+    std::partial_sum(commandOffsets.begin(), commandOffsets.end(), commandOffsets.begin());
+
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)count * sizeof(IndirectObjectData), objects, GL_STATIC_DRAW);
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, commandOffsetBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)materialCount * sizeof(GLuint), commandOffsets.data(), GL_STATIC_DRAW);
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, drawCountBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)materialCount * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+    GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)count * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+
+    // 物体下标只增长,缓冲对象不变,已设置的VAO继续有效
+    if(count > objectIndexCapacity)
+    {
+        std::vector<GLuint> indices(count);
+        std::iota(indices.begin(), indices.end(), 0u);
+        GLStateCache::bindBuffer(GL_ARRAY_BUFFER, objectIndexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)count * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        objectIndexCapacity = count;
+    }
+}
+
+// 更新从first开始的count个物体,材质下标不能改变
+void IndirectRenderer::updateObjects(GLuint first, const IndirectObjectData *objects, GLuint count)
+{
+    if(0 == count || first + count > objectCount)
+    {
+        return;
+    }
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)first * sizeof(IndirectObjectData), (GLsizeiptr)count * sizeof(IndirectObjectData), objects);
+}
+
+// 在当前绑定的VAO中设置物体下标属性,着色器中为uint
+void IndirectRenderer::attach(GLuint location) const
+{
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, objectIndexBuffer);
+    glVertexAttribIPointer(location, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void *)0);
+    glEnableVertexAttribArray(location);
+    // 每个实例前进一次,起点为命令的baseInstance
+    glVertexAttribDivisor(location, 1);
+}
+
+// 在GPU上剔除并生成本帧的绘制命令
+void IndirectRenderer::cull(const Frustum &frustum)
+{
+    if(0 == objectCount)
+    {
+        return;
+    }
+
+    // 在GPU上清零绘制数量,glBufferSubData会等待仍在读取上一帧数量的绘制
+    // 不能从缓冲读取数量时清零命令,区域中未写入的命令数量为0,不绘制任何东西
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, drawCountBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    if(!GLExtension::bIndirectParameters)
+    {
+        GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glClearBufferData(GL_DRAW_INDIRECT_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+
+    GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, objectBuffer);
+    GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, meshBuffer);
+    GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+    GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, drawCountBuffer);
+    GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, commandOffsetBuffer);
+    cullShader.use();
+    glUniform4fv(frustumPlanesLocation, 6, &frustum.planes[0].x);
+    glUniform1ui(objectCountLocation, objectCount);
+    cullShader.dispatch((objectCount + CullGroupSize - 1) / CullGroupSize);
+
+    // 绘制命令与绘制数量由计算着色器写入,间接读取前需要屏障
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+// 绘制一个材质的可见物体,vertexArray为包含物体下标属性的VAO
+void IndirectRenderer::draw(GLuint vertexArray, GLenum indexType, GLuint material) const
+{
+    GLsizei capacity = (GLsizei)(commandOffsets[material + 1] - commandOffsets[material]);
+    if(0 == capacity)
+    {
+        return;
+    }
+
+    // 顶点着色器从绑定点0读取物体数据
+    GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, objectBuffer);
+    GLStateCache::bindVertexArray(vertexArray);
+    GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    const void *commands = (const void *)((size_t)commandOffsets[material] * sizeof(DrawElementsIndirectCommand));
+    if(GLExtension::bIndirectParameters)
+    {
+        // 绘制数量从缓冲读取,只处理可见的命令
+        GLStateCache::bindBuffer(GL_PARAMETER_BUFFER_ARB, drawCountBuffer);
+        glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, indexType, commands, (GLintptr)material * sizeof(GLuint), capacity, 0);
+    }
+    else
+    {
+        // 处理整个区域,未写入的命令已清零
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, commands, capacity, 0);
+    }
+}
+
+// 读回一个材质的可见物体数量,会等待GPU完成剔除,只用于统计
+GLuint IndirectRenderer::readDrawCount(GLuint material) const
+{
+    GLuint count = 0;
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, drawCountBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)material * sizeof(GLuint), sizeof(GLuint), &count);
+    return count;
+}
+
+// 当前上下文是否支持GPU驱动的绘制
+bool IndirectRenderer::isSupported()
+{
+    return GLExtension::bMultiDrawIndirect;
+}
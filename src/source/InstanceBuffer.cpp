@@ -0,0 +1,70 @@
+#include "InstanceBuffer.h"
+#include "GLStateCache.h"
+#include "RingBuffer.h"
+#include <cstring>
+
+// 构造函数,实例数据从ring中分配
+InstanceBuffer::InstanceBuffer(RingBuffer &ring) : ring(ring), vertexArray(0), location(0), offset(0), count(0)
+{
+}
+
+// 为本帧分配instanceCount个实例变换,返回写入地址,写完后调用unmap,空间不足时返回nullptr且实例数量为0
+InstanceTransform *InstanceBuffer::map(GLsizei instanceCount)
+{
+    RingAllocation allocation = ring.allocate((GLsizeiptr)instanceCount * sizeof(InstanceTransform), sizeof(glm::vec4));
+    count = allocation.data ? instanceCount : 0;
+    offset = allocation.offset;
+    return static_cast<InstanceTransform *>(allocation.data);
+}
+
+// 结束写入,上传数据并把VAO中的属性指向本帧的数据
+void InstanceBuffer::unmap()
+{
+    if(0 == count)
+    {
+        return;
+    }
+    ring.flush();
+    GLStateCache::bindVertexArray(vertexArray);
+    setPointers();
+}
+
+// 上传实例变换,等同于map后拷贝再unmap
+void InstanceBuffer::update(const InstanceTransform *instances, GLsizei instanceCount)
+{
+    InstanceTransform *target = map(instanceCount);
+    if(target)
+    {
+        std::memcpy(target, instances, (size_t)instanceCount * sizeof(InstanceTransform));
+    }
+    unmap();
+}
+
+// 在vertexArray中设置实例属性,占用location开始的AttributeCount个位置
+// 依次为模型-视图-裁剪矩阵(4个)、模型矩阵(4个)与法线矩阵(3个)
+void InstanceBuffer::attach(GLuint vertexArray, GLuint location)
+{
+    this->vertexArray = vertexArray;
+    this->location = location;
+    GLStateCache::bindVertexArray(vertexArray);
+    setPointers();
+    for(GLuint attribute = 0; attribute < AttributeCount; attribute++)
+    {
+        glEnableVertexAttribArray(location + attribute);
+        // 每个实例前进一次
+        glVertexAttribDivisor(location + attribute, 1);
+    }
+}
+
+// 在当前绑定的VAO中把属性指向offset处的数据
+void InstanceBuffer::setPointers() const
+{
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, ring.getId());
+    // 除法线矩阵只读取三个分量外,每个属性为一个vec4
+    for(GLuint attribute = 0; attribute < AttributeCount; attribute++)
+    {
+        GLint components = attribute < 8 ? 4 : 3;
+        glVertexAttribPointer(location + attribute, components, GL_FLOAT, GL_FALSE, sizeof(InstanceTransform),
+                              (void *)(offset + attribute * sizeof(glm::vec4)));
+    }
+}
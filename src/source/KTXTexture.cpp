@@ -0,0 +1,195 @@
+#include "KTXTexture.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// KTX2文件头,各字段小端存放
+struct KTXHeader
+{
+    unsigned char identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    // 数据格式描述符与键值数据的位置
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    // 超级压缩全局数据的位置
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+static_assert(sizeof(KTXHeader) == 80, "KTX2 header must be 80 bytes");
+
+// 一级Mipmap在文件中的位置
+struct KTXLevelIndex
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+static_assert(sizeof(KTXLevelIndex) == 24, "KTX2 level index must be 24 bytes");
+
+static const unsigned char KTXIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// 各格式对应的VkFormat与数据格式描述符的颜色模型,依次为BC1、BC3、BC5
+// 颜色贴图使用_SRGB_BLOCK格式,BC5没有sRGB格式,保持UNORM
+static const uint32_t VkFormats[] = {131, 137, 141};
+static const uint32_t SRGBVkFormats[] = {132, 138, 141};
+static const uint32_t ColorModels[] = {128, 130, 132};
+
+// 生成只有基本描述块的数据格式描述符,BT.709原色,颜色贴图使用sRGB传输函数,其余为线性
+// BC1只有颜色一个样本,BC3为透明度与颜色,BC5为红与绿两个通道,每个样本占64位
+static std::vector<uint32_t> makeDataFormatDescriptor(BlockCompressor::Format format, bool bIsSRGB)
+{
+    uint32_t transferFunction = bIsSRGB && BlockCompressor::BC5 != format ? 2 : 1;
+    std::vector<uint32_t> words;
+    uint32_t channels[2] = {0, 0};
+    int sampleCount = 1;
+    if(BlockCompressor::BC3 == format)
+    {
+        channels[0] = 15;
+        sampleCount = 2;
+    }
+    else if(BlockCompressor::BC5 == format)
+    {
+        channels[1] = 1;
+        sampleCount = 2;
+    }
+    uint32_t blockSize = 24 + 16 * sampleCount;
+    words.push_back(4 + blockSize);
+    words.push_back(0);
+    words.push_back(2 | (blockSize << 16));
+    words.push_back(ColorModels[format] | (1 << 8) | (transferFunction << 16));
+    words.push_back(3 | (3 << 8));
+    words.push_back((uint32_t)BlockCompressor::getBlockSize(format));
+    words.push_back(0);
+    for(int i = 0; i < sampleCount; i++)
+    {
+        words.push_back((uint32_t)(64 * i) | (63 << 16) | (channels[i] << 24));
+        words.push_back(0);
+        words.push_back(0);
+        words.push_back(0xFFFFFFFF);
+    }
+    return words;
+}
+
+// 构造函数,映射并检查文件,无效时isValid返回false
+KTXTexture::KTXTexture(const std::string &path) : file(path), format(BlockCompressor::BC1), bIsValid(false)
+{
+    if(!file.isOpen() || file.getSize() < sizeof(KTXHeader))
+    {
+        return;
+    }
+    KTXHeader header;
+    std::memcpy(&header, file.getData(), sizeof(header));
+    if(0 != std::memcmp(header.identifier, KTXIdentifier, sizeof(KTXIdentifier)) || 1 != header.typeSize
+       || 0 != header.pixelDepth || 0 != header.layerCount || 1 != header.faceCount || 0 != header.supercompressionScheme
+       || 0 == header.pixelWidth || 0 == header.pixelHeight || 0 == header.levelCount || header.levelCount > 32)
+    {
+        return;
+    }
+    // sRGB格式与对应的UNORM格式使用相同的压缩格式,上传时的内部格式不变
+    const uint32_t *found = std::find(VkFormats, VkFormats + 3, header.vkFormat);
+    if(VkFormats + 3 != found)
+    {
+        format = (BlockCompressor::Format)(found - VkFormats);
+    }
+    else
+    {
+        found = std::find(SRGBVkFormats, SRGBVkFormats + 3, header.vkFormat);
+        if(SRGBVkFormats + 3 == found)
+        {
+            return;
+        }
+        format = (BlockCompressor::Format)(found - SRGBVkFormats);
+    }
+    if(sizeof(KTXHeader) + header.levelCount * sizeof(KTXLevelIndex) > file.getSize())
+    {
+        return;
+    }
+
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(file.getData());
+    int width = (int)header.pixelWidth;
+    int height = (int)header.pixelHeight;
+    for(uint32_t i = 0; i < header.levelCount; i++)
+    {
+        KTXLevelIndex index;
+        std::memcpy(&index, data + sizeof(KTXHeader) + i * sizeof(KTXLevelIndex), sizeof(index));
+        size_t size = BlockCompressor::getCompressedSize(format, width, height);
+        if(index.byteLength != size || index.byteOffset > file.getSize() || index.byteLength > file.getSize() - index.byteOffset)
+        {
+            levels.clear();
+            return;
+        }
+        levels.push_back({data + index.byteOffset, size, width, height});
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    bIsValid = true;
+}
+
+// 写入文件,levels为从第0级开始的压缩数据,各级尺寸由width与height逐级减半得到
+// 先写临时文件再改名,避免中途退出留下不完整的文件
+bool KTXTexture::write(const std::string &path, BlockCompressor::Format format, bool bIsSRGB, int width, int height,
+                       const std::vector<std::vector<unsigned char>> &levels)
+{
+    std::vector<uint32_t> descriptor = makeDataFormatDescriptor(format, bIsSRGB);
+    KTXHeader header = {};
+    std::memcpy(header.identifier, KTXIdentifier, sizeof(KTXIdentifier));
+    header.vkFormat = bIsSRGB ? SRGBVkFormats[format] : VkFormats[format];
+    header.typeSize = 1;
+    header.pixelWidth = (uint32_t)width;
+    header.pixelHeight = (uint32_t)height;
+    header.faceCount = 1;
+    header.levelCount = (uint32_t)levels.size();
+    header.dfdByteOffset = (uint32_t)(sizeof(KTXHeader) + levels.size() * sizeof(KTXLevelIndex));
+    header.dfdByteLength = (uint32_t)(descriptor.size() * sizeof(uint32_t));
+
+    // 各级数据按块大小对齐,从最小的一级开始存放
+    const uint64_t alignment = BlockCompressor::getBlockSize(format);
+    std::vector<KTXLevelIndex> indices(levels.size());
+    uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+    for(size_t i = levels.size(); i-- > 0;)
+    {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        indices[i].byteOffset = offset;
+        indices[i].byteLength = levels[i].size();
+        indices[i].uncompressedByteLength = levels[i].size();
+        offset += levels[i].size();
+    }
+
+    std::string tmpPath = path + ".tmp";
+    std::ofstream ofile(tmpPath, std::ios::binary | std::ios::trunc);
+    if(!ofile.is_open())
+    {
+        return false;
+    }
+    ofile.write((const char *)&header, sizeof(header));
+    ofile.write((const char *)indices.data(), indices.size() * sizeof(KTXLevelIndex));
+    ofile.write((const char *)descriptor.data(), descriptor.size() * sizeof(uint32_t));
+    uint64_t written = header.dfdByteOffset + header.dfdByteLength;
+    const char padding[16] = {};
+    for(size_t i = levels.size(); i-- > 0;)
+    {
+        ofile.write(padding, (std::streamsize)(indices[i].byteOffset - written));
+        ofile.write((const char *)levels[i].data(), levels[i].size());
+        written = indices[i].byteOffset + levels[i].size();
+    }
+    ofile.close();
+    if(!ofile)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    std::remove(path.c_str());
+    return 0 == std::rename(tmpPath.c_str(), path.c_str());
+}
@@ -0,0 +1,160 @@
+#include "MappedFile.h"
+#include <fstream>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 空文件无法映射,使用一个静态的空字符串代替
+static const char EmptyFileData[1] = {0};
+
+// 构造函数,映射失败时isOpen返回false
+MappedFile::MappedFile(const std::string &path, bool bIsCopy) : data(nullptr), size(0)
+{
+#ifdef _WIN32
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    fileDescriptor = -1;
+#endif
+
+    // 复制模式,一次读入整个文件
+    if(bIsCopy)
+    {
+        std::ifstream ifile(path, std::ios::binary | std::ios::ate);
+        if(!ifile.is_open())
+        {
+            return;
+        }
+        copy.resize((size_t)ifile.tellg());
+        ifile.seekg(0);
+        if(!copy.empty() && !ifile.read(copy.data(), copy.size()))
+        {
+            copy.clear();
+            return;
+        }
+        size = copy.size();
+        data = copy.empty() ? EmptyFileData : copy.data();
+        return;
+    }
+
+#ifdef _WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(INVALID_HANDLE_VALUE == fileHandle)
+    {
+        fileHandle = nullptr;
+        return;
+    }
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        close();
+        return;
+    }
+    size = (size_t)fileSize.QuadPart;
+    if(0 == size)
+    {
+        data = EmptyFileData;
+        return;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mappingHandle)
+    {
+        close();
+        return;
+    }
+    data = (const char *)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if(!data)
+    {
+        close();
+    }
+#else
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    if(fileDescriptor < 0)
+    {
+        return;
+    }
+    struct stat fileStat;
+    if(fstat(fileDescriptor, &fileStat) != 0)
+    {
+        close();
+        return;
+    }
+    size = (size_t)fileStat.st_size;
+    if(0 == size)
+    {
+        data = EmptyFileData;
+        return;
+    }
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if(MAP_FAILED == mapped)
+    {
+        close();
+        return;
+    }
+    data = (const char *)mapped;
+#endif
+}
+
+// 析构函数,解除映射
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+// 是否映射成功,空文件也视为成功
+bool MappedFile::isOpen() const
+{
+    return data != nullptr;
+}
+
+// 关闭映射
+void MappedFile::close()
+{
+    if(!copy.empty())
+    {
+        copy.clear();
+        data = nullptr;
+        size = 0;
+        return;
+    }
+#ifdef _WIN32
+    if(data && data != EmptyFileData)
+    {
+        UnmapViewOfFile(data);
+    }
+    if(mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if(fileHandle)
+    {
+        CloseHandle(fileHandle);
+        fileHandle = nullptr;
+    }
+#else
+    if(data && data != EmptyFileData)
+    {
+        munmap((void *)data, size);
+    }
+    if(fileDescriptor >= 0)
+    {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+#endif
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,60 @@
+#include "Mesh.h"
+#include "GLStateCache.h"
+
+// 构造函数,上传MeshBuilder构建的网格并创建默认VAO
+Mesh::Mesh(const MeshData &data, const std::vector<VertexAttribute> &attributes)
+    : vertexBuffer(0), elementBuffer(0), vertexArray(0), indexCount((GLsizei)data.indices.size()),
+      indexType(GL_UNSIGNED_INT), attributes(attributes), vertexSize((GLsizei)(data.stride * sizeof(float))),
+      statistics(data.after)
+{
+    glGenBuffers(1, &vertexBuffer);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(float), data.vertices.data(), GL_STATIC_DRAW);
+
+    // 元素缓冲绑定属于VAO状态,先绑定默认VAO再创建
+    vertexArray = createVertexArray();
+    glGenBuffers(1, &elementBuffer);
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+    if(data.vertices.size() / data.stride <= 0xFFFF)
+    {
+        std::vector<GLushort> shortIndices(data.indices.begin(), data.indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), shortIndices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(uint32_t), data.indices.data(), GL_STATIC_DRAW);
+    }
+}
+
+// 创建新的VAO并设置网格的顶点属性与元素缓冲,返回时VAO保持绑定,便于追加实例属性
+GLuint Mesh::createVertexArray() const
+{
+    GLuint id;
+    glGenVertexArrays(1, &id);
+    GLStateCache::bindVertexArray(id);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    for(const VertexAttribute &attribute : attributes)
+    {
+        glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, vertexSize, (void *)(attribute.offset * sizeof(float)));
+        glEnableVertexAttribArray(attribute.location);
+    }
+    // 构造时默认VAO先于元素缓冲创建,此时elementBuffer为0
+    if(elementBuffer)
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+    return id;
+}
+
+// 使用默认VAO绘制
+void Mesh::draw() const
+{
+    GLStateCache::bindVertexArray(vertexArray);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, nullptr);
+}
+
+// 使用指定VAO实例化绘制
+void Mesh::drawInstanced(GLuint instancedVertexArray, GLsizei instanceCount) const
+{
+    GLStateCache::bindVertexArray(instancedVertexArray);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, nullptr, instanceCount);
+}
@@ -0,0 +1,335 @@
+#include "MeshBuilder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Forsyth算法模拟的LRU缓存大小
+static const size_t ForsythCacheSize = 32;
+// 缓存位置得分的衰减指数
+static const float CacheDecayPower = 1.5f;
+// 最近一个三角形的三个顶点的固定得分,避免总是选择刚用过的边
+static const float LastTriangleScore = 0.75f;
+// 剩余三角形越少得分越高,尽早完成孤立的顶点
+static const float ValenceBoostScale = 2.0f;
+static const float ValenceBoostPower = 0.5f;
+
+// 顶点得分,由缓存位置与剩余未输出三角形数量决定
+static float vertexScore(int cachePosition, uint32_t remainingValence)
+{
+    if(0 == remainingValence)
+    {
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if(cachePosition >= 0)
+    {
+        if(cachePosition < 3)
+        {
+            score = LastTriangleScore;
+        }
+        else
+        {
+            float scale = 1.0f / (float)(ForsythCacheSize - 3);
+            score = std::pow(1.0f - (float)(cachePosition - 3) * scale, CacheDecayPower);
+        }
+    }
+    score += ValenceBoostScale * std::pow((float)remainingValence, -ValenceBoostPower);
+    return score;
+}
+
+// FNV-1a哈希顶点数据
+static uint64_t hashVertex(const float *vertex, size_t stride)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(vertex);
+    uint64_t result = 14695981039346656037ULL;
+    for(size_t i = 0; i < stride * sizeof(float); i++)
+    {
+        result ^= bytes[i];
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
+
+// 构建网格:合并相同顶点、优化三角形顺序、按首次使用重排顶点,输出优化前后的统计
+MeshData MeshBuilder::build(const std::string &name, const float *vertices, size_t vertexCount, size_t stride)
+{
+    MeshData mesh;
+    mesh.stride = stride;
+
+    // 原始数据按无索引绘制,等同于索引0到n-1
+    std::vector<uint32_t> sequential(vertexCount);
+    for(size_t i = 0; i < vertexCount; i++)
+    {
+        sequential[i] = (uint32_t)i;
+    }
+    mesh.before = analyze(sequential, vertexCount, stride);
+
+    weldVertices(vertices, vertexCount, stride, mesh.vertices, mesh.indices);
+    optimizeVertexCache(mesh.indices, mesh.vertices.size() / stride);
+    optimizeVertexFetch(mesh.vertices, mesh.indices, stride);
+    mesh.after = analyze(mesh.indices, mesh.vertices.size() / stride, stride);
+
+    std::cout << "## Mesh " << name << " ## vertices " << mesh.before.vertexCount << " -> " << mesh.after.vertexCount
+              << ", ACMR " << mesh.before.acmr << " -> " << mesh.after.acmr
+              << ", ATVR " << mesh.before.atvr << " -> " << mesh.after.atvr
+              << ", fetched bytes " << mesh.before.fetchedBytes << " -> " << mesh.after.fetchedBytes
+              << ", overfetch " << mesh.before.overfetch << " -> " << mesh.after.overfetch << std::endl;
+    return mesh;
+}
+
+// 合并按位相同的顶点,生成索引
+void MeshBuilder::weldVertices(const float *vertices, size_t vertexCount, size_t stride,
+                               std::vector<float> &outVertices, std::vector<uint32_t> &outIndices)
+{
+    outVertices.clear();
+    outIndices.clear();
+    outVertices.reserve(vertexCount * stride);
+    outIndices.reserve(vertexCount);
+
+    // 开放寻址哈希表,保存合并后的顶点下标,容量为2的幂且至少是顶点数的两倍
+    size_t tableSize = 1;
+    while(tableSize < vertexCount * 2)
+    {
+        tableSize <<= 1;
+    }
+    const uint32_t EmptySlot = 0xFFFFFFFFu;
+    std::vector<uint32_t> table(tableSize, EmptySlot);
+
+    for(size_t i = 0; i < vertexCount; i++)
+    {
+        const float *vertex = vertices + i * stride;
+        size_t slot = (size_t)hashVertex(vertex, stride) & (tableSize - 1);
+        while(true)
+        {
+            uint32_t index = table[slot];
+            if(EmptySlot == index)
+            {
+                index = (uint32_t)(outVertices.size() / stride);
+                outVertices.insert(outVertices.end(), vertex, vertex + stride);
+                table[slot] = index;
+                outIndices.push_back(index);
+                break;
+            }
+            if(0 == std::memcmp(&outVertices[index * stride], vertex, stride * sizeof(float)))
+            {
+                outIndices.push_back(index);
+                break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+    }
+}
+
+// 按Tom Forsyth的线性算法重排三角形,提高顶点后变换缓存命中率
+// 每次从缓存中的顶点相邻的三角形里选得分最高的输出,没有候选时按原顺序取下一个未输出的三角形
+void MeshBuilder::optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if(0 == triangleCount)
+    {
+        return;
+    }
+
+    // 每个顶点相邻的三角形列表,已输出的三角形交换到列表末尾并缩短长度
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for(uint32_t index : indices)
+    {
+        valence[index]++;
+    }
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for(size_t i = 0; i < vertexCount; i++)
+    {
+        offsets[i + 1] = offsets[i] + valence[i];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for(size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        for(size_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            adjacency[offsets[vertex] + remaining[vertex]++] = (uint32_t)triangle;
+        }
+    }
+
+    // 初始得分
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for(size_t i = 0; i < vertexCount; i++)
+    {
+        vertexScores[i] = vertexScore(-1, remaining[i]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> bIsEmitted(triangleCount, false);
+    int best = 0;
+    for(size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+        if(triangleScores[triangle] > triangleScores[best])
+            best = (int)triangle;
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    cache.reserve(ForsythCacheSize + 3);
+    nextCache.reserve(ForsythCacheSize + 3);
+    size_t scanCursor = 0;
+    while(output.size() < indices.size())
+    {
+        if(best < 0)
+        {
+            while(bIsEmitted[scanCursor])
+                scanCursor++;
+            best = (int)scanCursor;
+        }
+
+        // 输出三角形,并从三个顶点的相邻列表中移除
+        const uint32_t *triangleIndices = &indices[best * 3];
+        bIsEmitted[best] = true;
+        for(size_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = triangleIndices[corner];
+            output.push_back(vertex);
+            uint32_t *list = &adjacency[offsets[vertex]];
+            for(uint32_t i = 0; i < remaining[vertex]; i++)
+            {
+                if(list[i] == (uint32_t)best)
+                {
+                    list[i] = list[remaining[vertex] - 1];
+                    remaining[vertex]--;
+                    break;
+                }
+            }
+        }
+
+        // 三角形的顶点移到缓存最前面,其余顶点依次后移,超出缓存的顶点失去位置
+        nextCache.clear();
+        for(size_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = triangleIndices[corner];
+            if(std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+                nextCache.push_back(vertex);
+        }
+        for(uint32_t vertex : cache)
+        {
+            if(std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+                nextCache.push_back(vertex);
+        }
+        for(size_t i = 0; i < nextCache.size(); i++)
+        {
+            cachePositions[nextCache[i]] = i < ForsythCacheSize ? (int)i : -1;
+        }
+
+        // 更新缓存中顶点的得分,相邻三角形的得分按差值更新
+        for(uint32_t vertex : nextCache)
+        {
+            float score = vertexScore(cachePositions[vertex], remaining[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            const uint32_t *list = &adjacency[offsets[vertex]];
+            for(uint32_t i = 0; i < remaining[vertex]; i++)
+            {
+                triangleScores[list[i]] += delta;
+            }
+        }
+
+        // 下一个三角形从缓存中顶点的相邻三角形里选
+        best = -1;
+        float bestScore = -1.0f;
+        if(nextCache.size() > ForsythCacheSize)
+        {
+            nextCache.resize(ForsythCacheSize);
+        }
+        for(uint32_t vertex : nextCache)
+        {
+            const uint32_t *list = &adjacency[offsets[vertex]];
+            for(uint32_t i = 0; i < remaining[vertex]; i++)
+            {
+                if(triangleScores[list[i]] > bestScore)
+                {
+                    bestScore = triangleScores[list[i]];
+                    best = (int)list[i];
+                }
+            }
+        }
+        cache.swap(nextCache);
+    }
+    indices.swap(output);
+}
+
+// 按索引中首次出现的顺序重排顶点,提高顶点读取的局部性,未被引用的顶点被丢弃
+void MeshBuilder::optimizeVertexFetch(std::vector<float> &vertices, std::vector<uint32_t> &indices, size_t stride)
+{
+    const uint32_t Unassigned = 0xFFFFFFFFu;
+    std::vector<uint32_t> remap(vertices.size() / stride, Unassigned);
+    std::vector<float> reordered;
+    reordered.reserve(vertices.size());
+    for(uint32_t &index : indices)
+    {
+        if(Unassigned == remap[index])
+        {
+            remap[index] = (uint32_t)(reordered.size() / stride);
+            reordered.insert(reordered.end(), vertices.begin() + index * stride, vertices.begin() + (index + 1) * stride);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+// 模拟顶点后变换缓存与顶点读取缓存,统计索引网格
+MeshStatistics MeshBuilder::analyze(const std::vector<uint32_t> &indices, size_t vertexCount, size_t stride)
+{
+    MeshStatistics statistics;
+    statistics.vertexCount = vertexCount;
+    statistics.indexCount = indices.size();
+
+    // FIFO顶点后变换缓存,时间戳相差不超过缓存大小时命中
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = (uint32_t)TransformCacheSize + 1;
+    size_t transformed = 0;
+
+    // LRU顶点读取缓存,保存缓存行编号,最近使用的在最前面
+    std::vector<size_t> lines;
+    lines.reserve(FetchCacheLines + 1);
+    size_t fetched = 0;
+    const size_t vertexSize = stride * sizeof(float);
+
+    for(uint32_t index : indices)
+    {
+        if(time - timestamps[index] > TransformCacheSize)
+        {
+            timestamps[index] = time++;
+            transformed++;
+
+            // 只有变换的顶点才需要读取
+            size_t firstLine = index * vertexSize / FetchLineSize;
+            size_t lastLine = ((index + 1) * vertexSize - 1) / FetchLineSize;
+            for(size_t line = firstLine; line <= lastLine; line++)
+            {
+                auto it = std::find(lines.begin(), lines.end(), line);
+                if(it != lines.end())
+                {
+                    lines.erase(it);
+                }
+                else
+                {
+                    fetched += FetchLineSize;
+                    if(lines.size() == FetchCacheLines)
+                        lines.pop_back();
+                }
+                lines.insert(lines.begin(), line);
+            }
+        }
+    }
+
+    size_t triangleCount = indices.size() / 3;
+    statistics.transformedVertices = transformed;
+    statistics.acmr = triangleCount ? (float)transformed / (float)triangleCount : 0.0f;
+    statistics.atvr = vertexCount ? (float)transformed / (float)vertexCount : 0.0f;
+    statistics.fetchedBytes = fetched;
+    statistics.overfetch = vertexCount ? (float)fetched / (float)(vertexCount * vertexSize) : 0.0f;
+    return statistics;
+}
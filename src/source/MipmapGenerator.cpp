@@ -0,0 +1,226 @@
+#include "MipmapGenerator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OPENGLTUTORIAL_MIPMAP_SSE 1
+#include <emmintrin.h>
+#endif
+
+// 并行缩小时每块的最少行数
+static const size_t MinChunkRows = 16;
+
+// sRGB与16位线性值的转换表,首次使用时生成
+struct SRGBTables
+{
+    // 8位sRGB值对应的16位线性值
+    uint16_t toLinear[256];
+    // 16位线性值对应的最近的8位sRGB值
+    unsigned char fromLinear[65536];
+
+    SRGBTables()
+    {
+        for(int i = 0; i < 256; i++)
+            toLinear[i] = (uint16_t)std::lround(toLinearValue(i / 255.0) * 65535.0);
+        // 线性值不小于sRGB值k + 0.5对应的线性值时,最近的sRGB值大于k
+        int value = 0;
+        for(int k = 0; k < 255; k++)
+        {
+            double threshold = toLinearValue((k + 0.5) / 255.0) * 65535.0;
+            for(; value < 65536 && value < threshold; value++)
+                fromLinear[value] = (unsigned char)k;
+        }
+        for(; value < 65536; value++)
+            fromLinear[value] = 255;
+    }
+
+    static double toLinearValue(double value)
+    {
+        return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+    }
+};
+
+static const SRGBTables &getSRGBTables()
+{
+    static const SRGBTables tables;
+    return tables;
+}
+
+// sRGB图像一个输出像素的RGB通道,四个源像素转换到线性值后平均
+static void averageSRGB(const unsigned char *p00, const unsigned char *p01, const unsigned char *p10, const unsigned char *p11,
+                        const SRGBTables &tables, unsigned char *output)
+{
+    for(int c = 0; c < 3; c++)
+    {
+        int sum = tables.toLinear[p00[c]] + tables.toLinear[p01[c]] + tables.toLinear[p10[c]] + tables.toLinear[p11[c]];
+        output[c] = tables.fromLinear[(sum + 2) >> 2];
+    }
+}
+
+// 一个输出像素,sRGB图像的RGB通道在线性空间平均,其余通道按8位整数平均
+static void averagePixel(const unsigned char *p00, const unsigned char *p01, const unsigned char *p10, const unsigned char *p11,
+                         bool bIsSRGB, const SRGBTables &tables, unsigned char *output)
+{
+    int first = 0;
+    if(bIsSRGB)
+    {
+        averageSRGB(p00, p01, p10, p11, tables, output);
+        first = 3;
+    }
+    for(int c = first; c < 4; c++)
+        output[c] = (unsigned char)((p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2);
+}
+
+#ifdef OPENGLTUTORIAL_MIPMAP_SSE
+// 按8位整数平均一行中不需要重复边缘像素的部分,每次读取两行各8个源像素输出4个像素,返回处理的输出像素数量
+static int downsampleRowSSE(const unsigned char *row0, const unsigned char *row1, int width, unsigned char *output)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for(; 2 * x + 8 <= width; x += 4)
+    {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8 + 16));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8 + 16));
+        // 上下两行相加,每个寄存器为一个输出像素左右两列的和
+        __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+        // 左右两列相加后四舍五入除以4
+        __m128i sum01 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+        __m128i sum23 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+        sum01 = _mm_srli_epi16(_mm_add_epi16(sum01, two), 2);
+        sum23 = _mm_srli_epi16(_mm_add_epi16(sum23, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + x * 4), _mm_packus_epi16(sum01, sum23));
+    }
+    return x;
+}
+#endif
+
+// 构造函数,默认使用编译支持的最快指令集
+MipmapGenerator::MipmapGenerator(ThreadPool *threadPool) : threadPool(threadPool), instructionSet(getBestInstructionSet())
+{
+}
+
+// 编译支持的最快指令集
+MipmapGenerator::InstructionSet MipmapGenerator::getBestInstructionSet()
+{
+    return isSupported(SSE) ? SSE : Scalar;
+}
+
+// 指令集名称
+const char *MipmapGenerator::getInstructionSetName(InstructionSet instructionSet)
+{
+    return SSE == instructionSet ? "SSE" : "scalar";
+}
+
+// 是否编译了指令集
+bool MipmapGenerator::isSupported(InstructionSet instructionSet)
+{
+    switch(instructionSet)
+    {
+#ifdef OPENGLTUTORIAL_MIPMAP_SSE
+    case SSE:
+        return true;
+#endif
+    case Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// width x height的图像缩小到1x1的级数,包括第0级
+int MipmapGenerator::getLevelCount(int width, int height)
+{
+    int count = 1;
+    while(width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        count++;
+    }
+    return count;
+}
+
+// 完整Mipmap链的RGBA8字节数
+size_t MipmapGenerator::getChainSize(int width, int height)
+{
+    size_t size = (size_t)width * height * 4;
+    while(width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        size += (size_t)width * height * 4;
+    }
+    return size;
+}
+
+// 设置使用的指令集,不支持时保持不变
+void MipmapGenerator::setInstructionSet(InstructionSet set)
+{
+    if(isSupported(set))
+        instructionSet = set;
+}
+
+// 把一级RGBA8图像缩小一半写入target,target的边长为max(width / 2, 1) x max(height / 2, 1)
+void MipmapGenerator::downsample(const unsigned char *source, int width, int height, bool bIsSRGB, unsigned char *target) const
+{
+    const int targetWidth = std::max(width / 2, 1);
+    const int targetHeight = std::max(height / 2, 1);
+    const SRGBTables &tables = getSRGBTables();
+    auto downsampleRows = [&](size_t begin, size_t end, size_t)
+    {
+        for(size_t y = begin; y < end; y++)
+        {
+            const unsigned char *row0 = source + (size_t)std::min((int)y * 2, height - 1) * width * 4;
+            const unsigned char *row1 = source + (size_t)std::min((int)y * 2 + 1, height - 1) * width * 4;
+            unsigned char *output = target + y * targetWidth * 4;
+            int x = 0;
+#ifdef OPENGLTUTORIAL_MIPMAP_SSE
+            if(SSE == instructionSet)
+            {
+                x = downsampleRowSSE(row0, row1, width, output);
+                // SSE按8位整数平均了所有通道,sRGB图像的RGB通道再查表重新计算
+                if(bIsSRGB)
+                {
+                    for(int i = 0; i < x; i++)
+                        averageSRGB(row0 + i * 8, row0 + i * 8 + 4, row1 + i * 8, row1 + i * 8 + 4, tables, output + i * 4);
+                }
+            }
+#endif
+            for(; x < targetWidth; x++)
+            {
+                int x0 = std::min(x * 2, width - 1) * 4;
+                int x1 = std::min(x * 2 + 1, width - 1) * 4;
+                averagePixel(row0 + x0, row0 + x1, row1 + x0, row1 + x1, bIsSRGB, tables, output + x * 4);
+            }
+        }
+    };
+    if(threadPool)
+        threadPool->parallelFor((size_t)targetHeight, MinChunkRows, downsampleRows);
+    else
+        downsampleRows(0, (size_t)targetHeight, 0);
+}
+
+// 生成完整的Mipmap链,chain至少能容纳getChainSize字节,各级从第0级开始依次紧密存放
+// 每一级依赖上一级,级与级之间串行,一级之内按行分块并行
+void MipmapGenerator::generate(const unsigned char *pixels, int width, int height, bool bIsSRGB, unsigned char *chain) const
+{
+    std::memcpy(chain, pixels, (size_t)width * height * 4);
+    unsigned char *level = chain;
+    while(width > 1 || height > 1)
+    {
+        unsigned char *nextLevel = level + (size_t)width * height * 4;
+        downsample(level, width, height, bIsSRGB, nextLevel);
+        level = nextLevel;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+}
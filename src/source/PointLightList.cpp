@@ -0,0 +1,44 @@
+#include "PointLightList.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// 视为无影响的光照强度
+const float PointLightList::CutoffIntensity = 5.0f / 256.0f;
+
+// 设置光源数量
+void PointLightList::resize(size_t count)
+{
+    lights.resize(count);
+    bounds.resize(count);
+}
+
+// 设置第index个光源,同时计算影响范围
+void PointLightList::set(size_t index, const PointLightData &light)
+{
+    lights[index] = light;
+    bounds[index] = glm::vec4(light.position, computeRadius(light));
+}
+
+// 由衰减计算影响半径,即最亮分量衰减到CutoffIntensity的距离
+// 材质颜色不超过1,三个分量之和是光源能贡献的最大值,解 constant + linear * d + quadratic * d^2 = 最大值 / CutoffIntensity
+float PointLightList::computeRadius(const PointLightData &light)
+{
+    glm::vec3 sum = light.ambient + light.diffuse + light.specular;
+    float intensity = std::max(std::max(sum.x, sum.y), sum.z);
+    float target = intensity / CutoffIntensity - light.constant;
+    if(target <= 0.0f)
+    {
+        return 0.0f;
+    }
+    if(light.quadratic > 0.0f)
+    {
+        return (-light.linear + std::sqrt(light.linear * light.linear + 4.0f * light.quadratic * target)) / (2.0f * light.quadratic);
+    }
+    if(light.linear > 0.0f)
+    {
+        return target / light.linear;
+    }
+    // 不衰减的光源影响整个场景
+    return FLT_MAX;
+}
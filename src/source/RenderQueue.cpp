@@ -0,0 +1,117 @@
+#include "RenderQueue.h"
+#include <cstring>
+
+// 构造函数,预留initialCapacity个绘制包
+RenderQueue::RenderQueue(size_t initialCapacity) : packets(initialCapacity), scratch(initialCapacity), count(0)
+{
+}
+
+// 扩大容量,排序用的临时缓冲同时扩大,排序时不再分配
+void RenderQueue::grow()
+{
+    size_t capacity = packets.empty() ? 1024 : packets.size() * 2;
+    packets.resize(capacity);
+    scratch.resize(capacity);
+}
+
+// 生成排序键,程序、材质与VAO超出位数时只保留低位,depth为0到1之间的归一化深度
+uint64_t RenderQueue::makeKey(Layer layer, uint32_t program, uint32_t material, uint32_t vertexArray, float depth)
+{
+    const uint64_t depthMax = (1ULL << DepthBits) - 1;
+    uint64_t quantizedDepth;
+    if(!(depth > 0.0f))
+        quantizedDepth = 0;
+    else if(depth >= 1.0f)
+        quantizedDepth = depthMax;
+    else
+        quantizedDepth = (uint64_t)(depth * (float)depthMax);
+
+    uint64_t state = ((uint64_t)(program & ((1u << ProgramBits) - 1)) << (MaterialBits + VertexArrayBits)) |
+                     ((uint64_t)(material & ((1u << MaterialBits) - 1)) << VertexArrayBits) |
+                     (uint64_t)(vertexArray & ((1u << VertexArrayBits) - 1));
+    uint64_t key = (uint64_t)(layer & ((1u << LayerBits) - 1)) << (64 - LayerBits);
+    if(Transparent == layer)
+    {
+        // 透明物体先按深度从远到近,再按状态
+        key |= (depthMax - quantizedDepth) << (ProgramBits + MaterialBits + VertexArrayBits);
+        key |= state;
+    }
+    else
+    {
+        key |= state << DepthBits;
+        key |= quantizedDepth;
+    }
+    return key;
+}
+
+// 从键中取出材质
+uint32_t RenderQueue::getMaterial(uint64_t key)
+{
+    Layer layer = (Layer)(key >> (64 - LayerBits));
+    int shift = VertexArrayBits + (Transparent == layer ? 0 : DepthBits);
+    return (uint32_t)(key >> shift) & ((1u << MaterialBits) - 1);
+}
+
+// 追加另一个队列的全部绘制包,用于合并各线程并行填充的命令列表
+void RenderQueue::append(const RenderQueue &other)
+{
+    if(0 == other.count)
+        return;
+    while(count + other.count > packets.size())
+        grow();
+    std::memcpy(packets.data() + count, other.packets.data(), other.count * sizeof(RenderPacket));
+    count += other.count;
+}
+
+// 按键从小到大排序,键相同的绘制包保持加入顺序
+// 每次处理8位的LSD基数排序,一次遍历统计所有字节的直方图,所有键都相同的字节跳过
+void RenderQueue::sort()
+{
+    if(count < 2)
+        return;
+
+    const int RadixPasses = 8;
+    size_t histograms[RadixPasses][256];
+    std::memset(histograms, 0, sizeof(histograms));
+    for(size_t i = 0; i < count; i++)
+    {
+        uint64_t key = packets[i].key;
+        for(int pass = 0; pass < RadixPasses; pass++)
+        {
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    RenderPacket *source = packets.data();
+    RenderPacket *destination = scratch.data();
+    int passCount = 0;
+    for(int pass = 0; pass < RadixPasses; pass++)
+    {
+        size_t *histogram = histograms[pass];
+        int shift = pass * 8;
+        // 所有键在这个字节上相同,不需要移动
+        if(count == histogram[(source[0].key >> shift) & 0xFF])
+            continue;
+
+        // 直方图转为每个桶的起始位置
+        size_t offset = 0;
+        for(int digit = 0; digit < 256; digit++)
+        {
+            size_t bucketSize = histogram[digit];
+            histogram[digit] = offset;
+            offset += bucketSize;
+        }
+        for(size_t i = 0; i < count; i++)
+        {
+            destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+        }
+        RenderPacket *temp = source;
+        source = destination;
+        destination = temp;
+        passCount++;
+    }
+
+    // 结果在临时缓冲中时交换两个缓冲,不复制数据
+    if(passCount & 1)
+        packets.swap(scratch);
+}
@@ -0,0 +1,149 @@
+#include "RingBuffer.h"
+#include "GLExtension.h"
+#include "GLStateCache.h"
+#include <algorithm>
+
+// 帧区域大小的对齐,满足uniform缓冲偏移对齐的常见要求
+static const GLsizeiptr RegionAlignment = 256;
+
+// 构造函数,regionSize为每帧可以分配的字节数
+RingBuffer::RingBuffer(GLsizeiptr regionSize, GLuint regionCount)
+    : id(0), regionSize((regionSize + RegionAlignment - 1) & ~(RegionAlignment - 1)), regionCount(regionCount), region(0),
+      head(0), flushed(0), mapped(nullptr), fences(regionCount, nullptr), bIsPersistent(GLExtension::bBufferStorage),
+      stallCount(0)
+{
+    create();
+}
+
+// 创建缓冲,持久映射时映射整个缓冲
+void RingBuffer::create()
+{
+    glGenBuffers(1, &id);
+    // 使用拷贝目标创建,不影响顶点缓冲等绑定
+    GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, id);
+    if(bIsPersistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, regionSize * regionCount, nullptr, flags);
+        mapped = static_cast<unsigned char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize * regionCount, flags));
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+        staging.resize((size_t)regionSize);
+    }
+    region = 0;
+    head = 0;
+    flushed = 0;
+}
+
+// 保证每帧至少可以分配size字节,不够时等待GPU空闲后重新创建缓冲,只能在两帧之间调用
+void RingBuffer::reserve(GLsizeiptr size)
+{
+    if(size <= regionSize)
+    {
+        return;
+    }
+    for(GLuint i = 0; i < regionCount; i++)
+    {
+        waitRegion(i);
+    }
+    // 删除缓冲时同时解除映射
+    GLStateCache::deleteBuffer(id);
+    mapped = nullptr;
+    regionSize = (std::max(size, regionSize * 2) + RegionAlignment - 1) & ~(RegionAlignment - 1);
+    create();
+}
+
+// 开始一帧,切换到下一个帧区域,区域仍在被GPU读取时等待
+void RingBuffer::beginFrame()
+{
+    head = 0;
+    flushed = 0;
+    if(bIsPersistent)
+    {
+        region = (region + 1) % regionCount;
+        waitRegion(region);
+    }
+    else
+    {
+        // 孤立旧存储,仍在读取它的绘制不受影响,驱动分配新存储而不等待
+        GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, id);
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+// 在当前帧区域中分配,alignment需为2的幂
+RingAllocation RingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+    RingAllocation allocation = {nullptr, 0, 0};
+    GLsizeiptr offset = (head + alignment - 1) & ~(alignment - 1);
+    if(size <= 0 || offset + size > regionSize)
+    {
+        return allocation;
+    }
+    head = offset + size;
+    if(bIsPersistent)
+    {
+        allocation.offset = (GLintptr)region * regionSize + offset;
+        allocation.data = mapped + allocation.offset;
+    }
+    else
+    {
+        allocation.offset = offset;
+        allocation.data = staging.data() + offset;
+    }
+    allocation.size = size;
+    return allocation;
+}
+
+// 在绘制使用分配的数据之前调用,回退路径上传新写入的部分,持久映射时不做任何事
+void RingBuffer::flush()
+{
+    if(bIsPersistent || head == flushed)
+    {
+        return;
+    }
+    GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, id);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, flushed, head - flushed, staging.data() + flushed);
+    flushed = head;
+}
+
+// 结束一帧,为当前帧区域插入栅栏
+void RingBuffer::endFrame()
+{
+    if(bIsPersistent)
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    else
+    {
+        flush();
+    }
+}
+
+// 等待一个帧区域的栅栏并删除
+void RingBuffer::waitRegion(GLuint index)
+{
+    GLsync fence = fences[index];
+    if(!fence)
+    {
+        return;
+    }
+    // 先不等待地查询,已经完成时不计为阻塞
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if(GL_TIMEOUT_EXPIRED == status)
+    {
+        stallCount++;
+        // 第一次等待时提交命令,保证栅栏最终会被触发
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        do
+        {
+            status = glClientWaitSync(fence, flags, 1000000);
+            flags = 0;
+        }
+        while(GL_TIMEOUT_EXPIRED == status);
+    }
+    glDeleteSync(fence);
+    fences[index] = nullptr;
+}
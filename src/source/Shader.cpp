@@ -1,100 +1,243 @@
 #include "Shader.h"
+#include "GLExtension.h"
+#include "GLStateCache.h"
+#include "ShaderCache.h"
+#include "ShaderSource.h"
+#include "UniformBuffer.h"
+#include <algorithm>
 
 // 着色器构造方法
-Shader::Shader(const std::string &vertexShaderSource, const std::string &fragmentShaderSource)
-{
-    // 顶点着色器
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    std::string tmpStr = readShaderFile(vertexShaderSource);
-    tmpStr.erase(0, 20);
-    const char *vertexShaderCode = tmpStr.c_str();
-    std::cout << "## " << vertexShaderSource << " ##" << std::endl;
-    std::cout << vertexShaderCode << std::endl;
-    glShaderSource(vertexShader, 1, &vertexShaderCode, nullptr);
-    glCompileShader(vertexShader);
-    checkShader(vertexShader, ShaderType::VertexShader);
+Shader::Shader(const std::string &vertexShaderSource, const std::string &fragmentShaderSource, ShaderBuildMode mode)
+    : Shader(vertexShaderSource, fragmentShaderSource, std::vector<std::string>(), mode)
+{
+}
+
+// 着色器变体构造方法,defines中的每个宏以"#define 宏 1"注入两个阶段的源码
+Shader::Shader(const std::string &vertexShaderSource, const std::string &fragmentShaderSource,
+               const std::vector<std::string> &defines, ShaderBuildMode mode)
+    : id(0), vertexPath(vertexShaderSource), fragmentPath(fragmentShaderSource), defines(defines), bIsBuilding(false)
+{
+    // 记录构建耗时,用于对比冷启动与缓存命中
+    buildStartTime = std::chrono::steady_clock::now();
+
+    // 映射顶点着色器与片段着色器源码并展开#include
+    ShaderSource vertexSource(vertexShaderSource, defines);
+    ShaderSource fragmentSource(fragmentShaderSource, defines);
+
+    // 记录依赖的文件及包含关系
+    recordDependencies(vertexSource, fragmentSource);
+
+    // 提交编译与链接,glShaderSource已复制源码,之后可以释放映射
+    beginBuild(vertexSource, fragmentSource, pendingBuild);
+    id = pendingBuild.program;
+    bIsBuilding = true;
+
+    // 立即模式等待构建完成,延迟模式由ShaderLibrary统一等待
+    if(ShaderBuildMode::Immediate == mode)
+    {
+        finishBuild();
+    }
+}
+
+// 获取用于输出的名字,变体附带注入的宏
+std::string Shader::getName() const
+{
+    std::string name = vertexPath + " + " + fragmentPath;
+    if(!defines.empty())
+    {
+        name.append(" [");
+        for(size_t i = 0; i < defines.size(); i++)
+        {
+            if(i > 0)
+                name.push_back(' ');
+            name.append(defines[i]);
+        }
+        name.push_back(']');
+    }
+    return name;
+}
+
+// 延迟构建是否已经完成,完成后调用finishBuild不会阻塞
+bool Shader::isBuildComplete() const
+{
+    return !bIsBuilding || isBuildComplete(pendingBuild);
+}
+
+// 等待延迟构建完成,失败时仍保留程序对象,与直接调用GL的行为一致
+void Shader::finishBuild()
+{
+    if(!bIsBuilding)
+    {
+        return;
+    }
+    bIsBuilding = false;
+    endBuild(pendingBuild);
+
+    // 反射Uniform,生成Uniform表,绑定共享uniform块
+    reflectUniforms();
+    bindUniformBlocks();
+
+    // 输出构建耗时
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStartTime).count();
+    std::cout << "## " << getName() << " ## "
+              << (pendingBuild.bIsFromCache ? "loaded from cache" : "compiled from source") << " in " << elapsed << " ms" << std::endl;
+}
+
+// 使用新的源码重建程序,新程序链接成功后才替换旧程序,失败时继续使用旧程序
+bool Shader::reload(const ShaderSource &vertexSource, const ShaderSource &fragmentSource)
+{
+    // 依赖关系总是更新,保证修复被包含的文件后能再次触发重建
+    recordDependencies(vertexSource, fragmentSource);
+
+    ShaderBuild build;
+    beginBuild(vertexSource, fragmentSource, build);
+    if(!endBuild(build))
+    {
+        GLStateCache::deleteProgram(build.program);
+        std::cout << "## " << getName() << " ## reload failed, keep the old program" << std::endl;
+        return false;
+    }
+
+    // 替换程序,正在使用旧程序时同时切换到新程序
+    GLuint oldProgram = id;
+    id = build.program;
+    if(GLStateCache::getProgram() == oldProgram)
+    {
+        GLStateCache::useProgram(id);
+    }
+    GLStateCache::deleteProgram(oldProgram);
+    reflectUniforms();
+    bindUniformBlocks();
+
+    std::cout << "## " << getName() << " ## reloaded" << std::endl;
+    return true;
+}
+
+// 提交编译与链接,不查询任何状态,驱动可以在后台线程完成编译
+void Shader::beginBuild(const ShaderSource &vertexSource, const ShaderSource &fragmentSource, ShaderBuild &build)
+{
+    if(!vertexSource.isValid())
+        std::cout << vertexSource.getError() << std::endl;
+    if(!fragmentSource.isValid())
+        std::cout << fragmentSource.getError() << std::endl;
+
+    build.vertexShader = 0;
+    build.fragmentShader = 0;
+
+    // 优先从程序二进制缓存加载
+    build.program = glCreateProgram();
+    build.cacheKey = ShaderCache::makeKey(vertexSource, fragmentSource);
+    build.bIsFromCache = ShaderCache::load(build.program, build.cacheKey);
+    if(build.bIsFromCache)
+    {
+        return;
+    }
+
+    // 缓存被拒绝的程序对象处于链接失败状态,重新创建
+    GLStateCache::deleteProgram(build.program);
+    build.program = glCreateProgram();
+
+    // 顶点着色器,源码片段直接指向映射内存
+    build.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(build.vertexShader, vertexSource.getSegmentCount(), vertexSource.getSegments(), vertexSource.getLengths());
+    glCompileShader(build.vertexShader);
 
     // 片段着色器
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    const char *fragmentShaderCode = readShaderFile(fragmentShaderSource).c_str();
-    std::cout << "## " << fragmentShaderSource << " ##" << std::endl;
-    std::cout << fragmentShaderCode << std::endl;
-    glShaderSource(fragmentShader, 1, &fragmentShaderCode, nullptr);
-    glCompileShader(fragmentShader);
-    checkShader(fragmentShader, ShaderType::FragmentShader);
-
-    // 着色器程序
-    id = glCreateProgram();
-    glAttachShader(id, vertexShader);
-    glAttachShader(id, fragmentShader);
-    glLinkProgram(id);
-    checkShader(id, ShaderType::ShaderProgram);
+    build.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(build.fragmentShader, fragmentSource.getSegmentCount(), fragmentSource.getSegments(), fragmentSource.getLengths());
+    glCompileShader(build.fragmentShader);
+
+    // 链接着色器程序,编译状态留到链接失败时再查询
+    glAttachShader(build.program, build.vertexShader);
+    glAttachShader(build.program, build.fragmentShader);
+    ShaderCache::prepareProgram(build.program);
+    glLinkProgram(build.program);
+}
+
+// 构建是否已经完成,不支持并行编译扩展时总是返回true
+bool Shader::isBuildComplete(const ShaderBuild &build) const
+{
+    if(!GLExtension::bParallelShaderCompile || build.bIsFromCache)
+    {
+        return true;
+    }
+    GLint bIsComplete = GL_TRUE;
+    glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &bIsComplete);
+    return bIsComplete != GL_FALSE;
+}
+
+// 等待构建完成并检查结果,链接成功返回true
+bool Shader::endBuild(ShaderBuild &build)
+{
+    if(build.bIsFromCache)
+    {
+        return true;
+    }
+
+    // 链接失败时再查询编译日志
+    GLint bIsLinked = GL_FALSE;
+    glGetProgramiv(build.program, GL_LINK_STATUS, &bIsLinked);
+    if(bIsLinked)
+    {
+        // 链接成功后写入缓存
+        ShaderCache::store(build.program, build.cacheKey);
+    }
+    else
+    {
+        if(!checkShader(build.vertexShader, ShaderType::VertexShader))
+            std::cout << "## " << vertexPath << " ##" << std::endl;
+        if(!checkShader(build.fragmentShader, ShaderType::FragmentShader))
+            std::cout << "## " << fragmentPath << " ##" << std::endl;
+        checkShader(build.program, ShaderType::ShaderProgram);
+    }
 
     // 删除顶点着色器
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    glDetachShader(build.program, build.vertexShader);
+    glDetachShader(build.program, build.fragmentShader);
+    glDeleteShader(build.vertexShader);
+    glDeleteShader(build.fragmentShader);
+    build.vertexShader = 0;
+    build.fragmentShader = 0;
+
+    return bIsLinked != GL_FALSE;
 }
 
 // 着色器使用方法
 void Shader::use()
 {
-    glUseProgram(id);
+    GLStateCache::useProgram(id);
 }
 
-// 读取着色器文件
-std::string Shader::readShaderFile(const std::string &path)
+// 判断是否依赖某个文件
+bool Shader::dependsOn(const std::string &path) const
 {
-    // 打开shader文件
-    std::ifstream ifile(path, std::ios::binary);
-    // 返回结果
-    std::string tmp("         \n\0");
-    std::string result;
-    result.append(tmp);
-    result.append("#version 330 core\n");
-    // 判断释放打开成功
-    if(!ifile.is_open())
-    {
-        result = "Read File Fail...";
-        return result;
-    }
-    // 判断是否读取第一行
-    bool bIsFirstLine = true;
-    // 循环读取
-    while(ifile)
+    std::string normalized = ShaderSource::normalizePath(path);
+    return std::find(dependencies.begin(), dependencies.end(), normalized) != dependencies.end();
+}
+
+// 记录源码依赖的文件及包含关系
+void Shader::recordDependencies(const ShaderSource &vertexSource, const ShaderSource &fragmentSource)
+{
+    dependencies.clear();
+    includeGraph.clear();
+    const ShaderSource *sources[] = {&vertexSource, &fragmentSource};
+    for(const ShaderSource *source : sources)
     {
-        // 创建一行
-        std::string line;
-        // 读取一行
-        std::getline(ifile, line);
-        // 判断是否是第一行,舍弃第一行
-        if(bIsFirstLine)
+        const std::vector<std::string> &files = source->getFiles();
+        for(const std::string &file : files)
         {
-            bIsFirstLine = false;
-            continue;
+            if(std::find(dependencies.begin(), dependencies.end(), file) == dependencies.end())
+                dependencies.push_back(file);
         }
-        // 判断是否空行
-        if(0 == line.size())
+        for(const auto &include : source->getIncludes())
         {
-            continue;
+            includeGraph.push_back(std::make_pair(files[include.first], files[include.second]));
         }
-        // 判断是否注释
-        if(std::string::npos != line.find("//"))
-        {
-            continue;
-        }
-        // 注意:不要忘记加上换行
-        result.append(line + "\n");
     }
-    result.append("\0");
-    std::cout << result << std::endl;
-
-    ifile.close();
-
-    return result;
 }
 
 // 着色器检查
-void Shader::checkShader(GLuint id, ShaderType type)
+bool Shader::checkShader(GLuint id, ShaderType type)
 {
     int success;
     char infoLog[512];
@@ -126,32 +269,308 @@ void Shader::checkShader(GLuint id, ShaderType type)
             }
             break;
         default:
+            success = GL_FALSE;
+            break;
+    }
+    return success != GL_FALSE;
+}
+
+// 反射所有活动的Uniform,生成Uniform表
+void Shader::reflectUniforms()
+{
+    // 重建程序后已有的句柄继续有效:已有名字保持下标,消失的Uniform位置置为-1,新名字追加到末尾
+    // 新程序中的Uniform都是默认值,先按表项保存旧的影子副本,之后恢复到新程序
+    std::vector<UniformEntry> previousEntries(uniformEntries);
+    std::vector<UniformShadow> previousShadows(uniformEntries.size());
+    for(size_t i = 0; i < uniformEntries.size(); i++)
+    {
+        UniformEntry &entry = uniformEntries[i];
+        previousShadows[i].bIsValid = false;
+        if(entry.shadowIndex >= 0)
+            previousShadows[i] = uniformShadows[entry.shadowIndex];
+        entry.location = -1;
+        entry.shadowIndex = -1;
+    }
+
+    // 获取活动Uniform数量及名字最大长度
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    // 临时表项,新名字按名字排序后追加
+    std::vector<std::pair<std::string, UniformEntry>> reflected;
+    std::vector<char> nameBuffer(maxLength > 0 ? maxLength : 1);
+    for(GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(id, (GLuint)i, maxLength, &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+
+        // Uniform块中的变量没有位置,跳过
+        GLint location = glGetUniformLocation(id, name.c_str());
+        if(location < 0)
+        {
+            continue;
+        }
+        reflected.push_back(std::make_pair(name, UniformEntry{location, type, size, -1}));
+
+        // 数组名字形如"arr[0]",同时登记"arr"以及其余元素"arr[n]"
+        const std::string suffix("[0]");
+        if(name.size() > suffix.size() && 0 == name.compare(name.size() - suffix.size(), suffix.size(), suffix))
+        {
+            std::string baseName = name.substr(0, name.size() - suffix.size());
+            reflected.push_back(std::make_pair(baseName, UniformEntry{location, type, size, -1}));
+            for(GLint element = 1; element < size; element++)
+            {
+                std::string elementName = baseName + "[" + std::to_string(element) + "]";
+                GLint elementLocation = glGetUniformLocation(id, elementName.c_str());
+                reflected.push_back(std::make_pair(elementName, UniformEntry{elementLocation, type, size - element, -1}));
+            }
+        }
+    }
+    std::sort(reflected.begin(), reflected.end(),
+              [](const std::pair<std::string, UniformEntry> &a, const std::pair<std::string, UniformEntry> &b)
+              {
+                  return a.first < b.first;
+              });
+
+    // 合并到Uniform表
+    for(const auto &item : reflected)
+    {
+        int index = findUniform(item.first);
+        if(index >= 0)
+        {
+            uniformEntries[index] = item.second;
+        }
+        else
+        {
+            uniformNames.push_back(item.first);
+            uniformEntries.push_back(item.second);
+        }
+    }
+
+    // 重建名字索引,获取句柄时二分查找
+    uniformOrder.resize(uniformNames.size());
+    for(size_t i = 0; i < uniformOrder.size(); i++)
+    {
+        uniformOrder[i] = (int)i;
+    }
+    std::sort(uniformOrder.begin(), uniformOrder.end(),
+              [this](int a, int b)
+              {
+                  return uniformNames[a] < uniformNames[b];
+              });
+
+    // 分配影子副本,"arr"与"arr[0]"位置相同,必须共用一个副本,否则交替设置时会错误地跳过上传
+    uniformShadows.clear();
+    std::vector<GLint> shadowLocations;
+    for(UniformEntry &entry : uniformEntries)
+    {
+        if(entry.location < 0)
+        {
+            continue;
+        }
+        auto it = std::find(shadowLocations.begin(), shadowLocations.end(), entry.location);
+        entry.shadowIndex = (int)(it - shadowLocations.begin());
+        if(it == shadowLocations.end())
+        {
+            shadowLocations.push_back(entry.location);
+            UniformShadow shadow;
+            shadow.bIsValid = false;
+            uniformShadows.push_back(shadow);
+        }
+    }
+
+    // 把类型未改变的旧值恢复到新程序,例如纹理单元,保证热重载后画面不变
+    GLuint previousProgram = GLStateCache::getProgram();
+    bool bIsRestoring = false;
+    for(size_t i = 0; i < previousEntries.size(); i++)
+    {
+        const UniformEntry &entry = uniformEntries[i];
+        if(!previousShadows[i].bIsValid || entry.location < 0 || entry.type != previousEntries[i].type)
+        {
+            continue;
+        }
+        UniformShadow &shadow = uniformShadows[entry.shadowIndex];
+        if(shadow.bIsValid)
+        {
+            continue;
+        }
+        shadow = previousShadows[i];
+        if(!bIsRestoring)
+        {
+            GLStateCache::useProgram(id);
+            bIsRestoring = true;
+        }
+        uploadShadow(entry.location, entry.type, shadow);
+        GLStateCache::countUniformUpload(true);
+    }
+    if(bIsRestoring)
+    {
+        GLStateCache::useProgram(previousProgram);
+    }
+}
+
+// 按GL类型上传影子副本中的值
+void Shader::uploadShadow(GLint location, GLenum type, const UniformShadow &shadow)
+{
+    const GLfloat *floats = reinterpret_cast<const GLfloat *>(shadow.data);
+    switch(type)
+    {
+        case GL_FLOAT:
+            glUniform1fv(location, 1, floats);
+            break;
+        case GL_FLOAT_VEC2:
+            glUniform2fv(location, 1, floats);
+            break;
+        case GL_FLOAT_VEC3:
+            glUniform3fv(location, 1, floats);
+            break;
+        case GL_FLOAT_VEC4:
+            glUniform4fv(location, 1, floats);
+            break;
+        case GL_FLOAT_MAT3:
+            glUniformMatrix3fv(location, 1, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT4:
+            glUniformMatrix4fv(location, 1, GL_FALSE, floats);
+            break;
+        case GL_UNSIGNED_INT:
+            glUniform1uiv(location, 1, reinterpret_cast<const GLuint *>(shadow.data));
+            break;
+        default:
+            // 其余可以设置的类型都通过UniformTraits<int>上传
+            glUniform1iv(location, 1, reinterpret_cast<const GLint *>(shadow.data));
             break;
     }
 }
 
+// int可以设置int、bool及采样器
+bool UniformTraits<int>::accepts(GLenum type)
+{
+    switch(type)
+    {
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_SHADOW:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_1D_ARRAY:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_1D_ARRAY_SHADOW:
+        case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_2D_MULTISAMPLE:
+        case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_SAMPLER_CUBE_SHADOW:
+        case GL_SAMPLER_BUFFER:
+        case GL_SAMPLER_2D_RECT:
+        case GL_SAMPLER_2D_RECT_SHADOW:
+        case GL_INT_SAMPLER_1D:
+        case GL_INT_SAMPLER_2D:
+        case GL_INT_SAMPLER_3D:
+        case GL_INT_SAMPLER_CUBE:
+        case GL_INT_SAMPLER_1D_ARRAY:
+        case GL_INT_SAMPLER_2D_ARRAY:
+        case GL_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_INT_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D_RECT:
+        case GL_UNSIGNED_INT_SAMPLER_1D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_3D:
+        case GL_UNSIGNED_INT_SAMPLER_CUBE:
+        case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+        case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// 将共享uniform块绑定到固定的绑定点,并检查块大小是否与C++端结构一致
+void Shader::bindUniformBlocks()
+{
+    GLint count = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for(GLint i = 0; i < count; i++)
+    {
+        char name[128];
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(id, (GLuint)i, sizeof(name), &length, name);
+
+        GLuint binding = 0;
+        GLsizeiptr size = 0;
+        if(!UniformBuffer::findBlock(std::string(name, length), binding, size))
+        {
+            continue;
+        }
+        GLint dataSize = 0;
+        glGetActiveUniformBlockiv(id, (GLuint)i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+        if(dataSize != size)
+        {
+            std::cout << "ERROR::SHADER::UNIFORM_BLOCK::SIZE_MISMATCH " << name << " GLSL = " << dataSize << ", C++ = " << size << std::endl;
+        }
+        glUniformBlockBinding(id, (GLuint)i, binding);
+    }
+}
+
+// 根据名字查找Uniform表下标,不存在时返回-1
+int Shader::findUniform(const std::string &name) const
+{
+    auto it = std::lower_bound(uniformOrder.begin(), uniformOrder.end(), name,
+                               [this](int index, const std::string &value)
+                               {
+                                   return uniformNames[index] < value;
+                               });
+    if(it == uniformOrder.end() || uniformNames[*it] != name)
+    {
+        return -1;
+    }
+    return *it;
+}
+
+// 获取Uniform句柄,不存在时返回无效句柄
+UniformHandle Shader::uniform(const std::string &name) const
+{
+    return UniformHandle(findUniform(name));
+}
+
 // 设置Uniform变量整数类型
 void Shader::setUniform1i(const std::string &name, int value)
 {
-    glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+    setUniform1i(uniform(name), value);
 }
 
 // 设置Uniform变量浮点数类型
-void Shader::setUniform1f(const std::string &name, int value)
+void Shader::setUniform1f(const std::string &name, float value)
 {
-    glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+    setUniform1f(uniform(name), value);
 }
 
 // 设置Uniform变量vec3类型
 void Shader::setUniform3fv(const std::string &name, glm::vec3 value)
 {
-    glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+    setUniform3fv(uniform(name), value);
+}
+
+// 设置Uniform变量3x3矩阵类型
+void Shader::setUniformMatrix3fv(const std::string &name, glm::mat3 value)
+{
+    setUniformMatrix3fv(uniform(name), value);
 }
 
 // 设置Uniform变量齐次矩阵类型
 void Shader::setUniformMatrix4fv(const std::string &name, glm::mat4 value)
 {
-    glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    setUniformMatrix4fv(uniform(name), value);
 }
-
-
@@ -0,0 +1,198 @@
+#include "ShaderCache.h"
+#include "GLExtension.h"
+#include "ShaderSource.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// 缓存文件头,用于校验文件是否有效
+struct ShaderCacheHeader
+{
+    // 文件标识"GLPB"
+    uint32_t magic;
+    // 程序二进制格式
+    uint32_t format;
+    // 程序二进制长度
+    uint32_t length;
+    // 缓存键,防止哈希文件名被误用
+    uint64_t key;
+};
+
+static const uint32_t ShaderCacheMagic = 0x42504C47;
+
+// 缓存目录
+std::string ShaderCache::cacheDirectory = "shader_cache/";
+
+// 设置缓存目录
+void ShaderCache::setCacheDirectory(const std::string &directory)
+{
+    cacheDirectory = directory;
+    if(!cacheDirectory.empty() && cacheDirectory.back() != '/' && cacheDirectory.back() != '\\')
+    {
+        cacheDirectory.push_back('/');
+    }
+}
+
+// 缓存是否可用,需要驱动支持程序二进制
+bool ShaderCache::isEnabled()
+{
+    return GLExtension::bProgramBinary && !cacheDirectory.empty();
+}
+
+// 计算缓存键,由预处理后的源码、渲染器名字及版本号组成
+uint64_t ShaderCache::makeKey(const ShaderSource &vertexSource, const ShaderSource &fragmentSource)
+{
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    const char *version = (const char *)glGetString(GL_VERSION);
+    std::string rendererString(renderer ? renderer : "");
+    std::string versionString(version ? version : "");
+
+    uint64_t key = vertexSource.hash(hash(nullptr, 0));
+    key = fragmentSource.hash(key);
+    key = hash(rendererString.data(), rendererString.size(), key);
+    key = hash(versionString.data(), versionString.size(), key);
+    return key;
+}
+
+// FNV-1a 64位哈希,seed用于串联多段数据
+uint64_t ShaderCache::hash(const void *data, size_t length, uint64_t seed)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t result = seed;
+    for(size_t i = 0; i < length; i++)
+    {
+        result ^= bytes[i];
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
+
+// 在链接前调用,提示驱动保留程序二进制
+void ShaderCache::prepareProgram(GLuint program)
+{
+    if(isEnabled())
+    {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+// 从缓存加载程序二进制,驱动拒绝时返回false
+bool ShaderCache::load(GLuint program, uint64_t key)
+{
+    if(!isEnabled())
+    {
+        return false;
+    }
+
+    // 打开缓存文件,不存在即为冷启动
+    std::string path = cachePath(key);
+    std::ifstream ifile(path, std::ios::binary);
+    if(!ifile.is_open())
+    {
+        return false;
+    }
+
+    // 校验文件头
+    ShaderCacheHeader header;
+    if(!ifile.read((char *)&header, sizeof(header)) || header.magic != ShaderCacheMagic || header.key != key || 0 == header.length)
+    {
+        ifile.close();
+        std::remove(path.c_str());
+        return false;
+    }
+
+    // 读取程序二进制
+    std::vector<char> binary(header.length);
+    if(!ifile.read(binary.data(), binary.size()))
+    {
+        ifile.close();
+        std::remove(path.c_str());
+        return false;
+    }
+    ifile.close();
+
+    // 驱动更新或格式不匹配时会链接失败,删除失效的缓存
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if(!success)
+    {
+        std::cout << "Shader Cache Rejected, Path = " << path << std::endl;
+        std::remove(path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 将链接成功的程序二进制写入缓存
+void ShaderCache::store(GLuint program, uint64_t key)
+{
+    if(!isEnabled())
+    {
+        return;
+    }
+
+    // 获取程序二进制
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0)
+    {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = GL_NONE;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if(written <= 0)
+    {
+        return;
+    }
+
+    // 先写临时文件再改名,避免中途退出留下不完整的缓存
+    createDirectories(cacheDirectory);
+    std::string path = cachePath(key);
+    std::string tmpPath = path + ".tmp";
+    std::ofstream ofile(tmpPath, std::ios::binary | std::ios::trunc);
+    if(!ofile.is_open())
+    {
+        std::cout << "Shader Cache Write Fail, Path = " << path << std::endl;
+        return;
+    }
+    ShaderCacheHeader header = {ShaderCacheMagic, (uint32_t)format, (uint32_t)written, key};
+    ofile.write((const char *)&header, sizeof(header));
+    ofile.write(binary.data(), written);
+    ofile.close();
+    std::remove(path.c_str());
+    std::rename(tmpPath.c_str(), path.c_str());
+}
+
+// 缓存文件路径
+std::string ShaderCache::cachePath(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return cacheDirectory + name;
+}
+
+// 逐级创建目录
+void ShaderCache::createDirectories(const std::string &directory)
+{
+    for(size_t i = 1; i <= directory.size(); i++)
+    {
+        if(i == directory.size() || directory[i] == '/' || directory[i] == '\\')
+        {
+            std::string parent = directory.substr(0, i);
+#ifdef _WIN32
+            _mkdir(parent.c_str());
+#else
+            mkdir(parent.c_str(), 0755);
+#endif
+        }
+    }
+}
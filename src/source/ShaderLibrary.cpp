@@ -0,0 +1,52 @@
+#include "ShaderLibrary.h"
+#include <chrono>
+#include <thread>
+
+// 添加着色器程序,立即提交编译与链接,返回的指针在着色器库销毁前有效
+Shader *ShaderLibrary::add(const std::string &vertexShaderSource, const std::string &fragmentShaderSource)
+{
+    shaders.push_back(std::unique_ptr<Shader>(new Shader(vertexShaderSource, fragmentShaderSource, ShaderBuildMode::Deferred)));
+    submitted.push_back(shaders.back().get());
+    return shaders.back().get();
+}
+
+// 提交由别处持有的延迟构建程序,与添加的程序在同一次build中等待,程序需在build前保持有效
+void ShaderLibrary::submit(Shader *shader)
+{
+    submitted.push_back(shader);
+}
+
+// 等待所有已提交的程序构建完成,之后可以继续提交并再次构建
+void ShaderLibrary::build()
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    // 轮询完成状态,先完成的先查询日志并反射Uniform,未完成的继续留在驱动线程中编译
+    std::vector<Shader *> pending;
+    for(Shader *shader : submitted)
+    {
+        if(shader->bIsBuilding)
+            pending.push_back(shader);
+    }
+    submitted.clear();
+    size_t pendingCount = pending.size();
+    while(!pending.empty())
+    {
+        size_t remain = 0;
+        for(Shader *shader : pending)
+        {
+            if(shader->isBuildComplete())
+                shader->finishBuild();
+            else
+                pending[remain++] = shader;
+        }
+        if(remain == pending.size())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        pending.resize(remain);
+    }
+
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "## ShaderLibrary ## " << pendingCount << " programs built in " << elapsed << " ms" << std::endl;
+}
@@ -0,0 +1,110 @@
+#include "ShaderPermutation.h"
+#include "ShaderLibrary.h"
+#include "ShaderSource.h"
+#include "ShaderWatcher.h"
+#include <algorithm>
+
+// 构造函数,只读取源码中声明的关键字,不编译任何变体
+ShaderPermutation::ShaderPermutation(const std::string &vertexShaderSource, const std::string &fragmentShaderSource)
+    : vertexPath(vertexShaderSource), fragmentPath(fragmentShaderSource), watcher(nullptr)
+{
+    // 关键字可以声明在任一阶段或被包含的文件中,两个阶段共用同一组宏
+    ShaderSource vertexSource(vertexShaderSource);
+    ShaderSource fragmentSource(fragmentShaderSource);
+    const ShaderSource *sources[] = {&vertexSource, &fragmentSource};
+    for(const ShaderSource *source : sources)
+    {
+        if(!source->isValid())
+        {
+            std::cout << "ERROR::SHADER::PERMUTATION " << source->getError() << std::endl;
+            continue;
+        }
+        for(const std::string &keyword : source->getKeywords())
+        {
+            if(std::find(keywords.begin(), keywords.end(), keyword) != keywords.end())
+                continue;
+            if(keywords.size() == MaxKeywords)
+            {
+                std::cout << "ERROR::SHADER::PERMUTATION too many keywords, ignore " << keyword << std::endl;
+                continue;
+            }
+            keywords.push_back(keyword);
+        }
+    }
+}
+
+// 设置热重载监视器,已构建的变体立即加入监视
+void ShaderPermutation::setWatcher(ShaderWatcher *shaderWatcher)
+{
+    watcher = shaderWatcher;
+    if(watcher)
+    {
+        for(const auto &variant : variants)
+        {
+            watcher->watch(variant.second.get());
+        }
+    }
+}
+
+// 将关键字名字转换为掩码,未声明的关键字被忽略,保证同一组合只有一个变体
+uint32_t ShaderPermutation::keywordMask(const std::vector<std::string> &names) const
+{
+    uint32_t mask = 0;
+    for(const std::string &name : names)
+    {
+        auto it = std::find(keywords.begin(), keywords.end(), name);
+        if(it == keywords.end())
+        {
+            std::cout << "## " << vertexPath << " + " << fragmentPath << " ## unknown keyword " << name << std::endl;
+            continue;
+        }
+        mask |= 1u << (it - keywords.begin());
+    }
+    return mask;
+}
+
+// 以延迟模式提交一组变体的编译与链接,已存在的变体被跳过,使用前需调用library.build()等待完成
+void ShaderPermutation::prebuild(const std::vector<uint32_t> &masks, ShaderLibrary &library)
+{
+    for(uint32_t mask : masks)
+    {
+        if(variants.find(mask) == variants.end())
+            library.submit(createVariant(mask, ShaderBuildMode::Deferred));
+    }
+}
+
+// 获取变体,第一次请求时编译,返回的指针在排列销毁前有效
+Shader *ShaderPermutation::get(uint32_t mask)
+{
+    auto it = variants.find(mask);
+    if(it != variants.end())
+    {
+        return it->second.get();
+    }
+    return createVariant(mask, ShaderBuildMode::Immediate);
+}
+
+// 按关键字掩码生成注入的宏,按声明顺序排列
+std::vector<std::string> ShaderPermutation::makeDefines(uint32_t mask) const
+{
+    // 宏按声明顺序注入,同一组合总是得到相同的源码与缓存键
+    std::vector<std::string> defines;
+    for(size_t i = 0; i < keywords.size(); i++)
+    {
+        if(mask & (1u << i))
+            defines.push_back(keywords[i]);
+    }
+    return defines;
+}
+
+// 创建变体并加入监视
+Shader *ShaderPermutation::createVariant(uint32_t mask, ShaderBuildMode mode)
+{
+    Shader *shader = new Shader(vertexPath, fragmentPath, makeDefines(mask), mode);
+    variants[mask] = std::unique_ptr<Shader>(shader);
+    if(watcher)
+    {
+        watcher->watch(shader);
+    }
+    return shader;
+}
@@ -0,0 +1,318 @@
+#include "ShaderSource.h"
+#include "ShaderCache.h"
+#include "EmbeddedShaders.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// #include最大嵌套深度
+static const int MaxIncludeDepth = 32;
+
+// 从磁盘加载着色器的目录,为空时使用嵌入的源码
+std::string ShaderSource::overrideDirectory;
+
+// 构造函数,加载path并展开其中的#include
+ShaderSource::ShaderSource(const std::string &path, bool bIsCopy) : version(0), bIsCopy(bIsCopy), bIsValid(false)
+{
+    bIsValid = expand(resolvePath(path), -1, 0);
+}
+
+// 构造函数,额外在#version之后为defines中的每个宏注入"#define 宏 1"
+ShaderSource::ShaderSource(const std::string &path, const std::vector<std::string> &defines, bool bIsCopy)
+    : defines(defines), version(0), bIsCopy(bIsCopy), bIsValid(false)
+{
+    bIsValid = expand(resolvePath(path), -1, 0);
+}
+
+// 设置从磁盘加载着色器的目录,为空时使用嵌入的源码
+void ShaderSource::setOverrideDirectory(const std::string &directory)
+{
+    overrideDirectory = directory;
+}
+
+// 获取从磁盘加载着色器的目录
+const std::string &ShaderSource::getOverrideDirectory()
+{
+    return overrideDirectory;
+}
+
+// 将相对于shader目录的路径转换为实际加载的路径
+std::string ShaderSource::resolvePath(const std::string &path)
+{
+    return overrideDirectory.empty() ? path : overrideDirectory + "/" + path;
+}
+
+// 对展开后的源码做哈希,用于缓存键
+// 展开结果由各文件内容及生成的#line与#define指令唯一决定,因此只混合文件哈希与指令,不再逐字节哈希源码
+uint64_t ShaderSource::hash(uint64_t seed) const
+{
+    uint64_t result = seed;
+    for(uint64_t fileHash : fileHashes)
+    {
+        result = ShaderCache::hash(&fileHash, sizeof(fileHash), result);
+    }
+    for(const std::string &text : generatedText)
+    {
+        result = ShaderCache::hash(text.data(), text.size(), result);
+    }
+    // 混入片段数量,避免不同的拆分得到相同的哈希
+    uint64_t count = segments.size();
+    return ShaderCache::hash(&count, sizeof(count), result);
+}
+
+// 规范化路径,统一分隔符并消除"."与".."
+std::string ShaderSource::normalizePath(const std::string &path)
+{
+    std::vector<std::string> parts;
+    bool bIsAbsolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+    std::string part;
+    for(size_t i = 0; i <= path.size(); i++)
+    {
+        if(i == path.size() || path[i] == '/' || path[i] == '\\')
+        {
+            if(part == "..")
+            {
+                // 只有前面是普通目录时才能抵消,否则保留相对路径开头的".."
+                if(!parts.empty() && parts.back() != "..")
+                    parts.pop_back();
+                else if(!bIsAbsolute)
+                    parts.push_back(part);
+            }
+            else if(!part.empty() && part != ".")
+            {
+                parts.push_back(part);
+            }
+            part.clear();
+        }
+        else
+        {
+            part.push_back(path[i]);
+        }
+    }
+
+    std::string result(bIsAbsolute ? "/" : "");
+    for(size_t i = 0; i < parts.size(); i++)
+    {
+        if(i > 0)
+            result.push_back('/');
+        result.append(parts[i]);
+    }
+    return result;
+}
+
+// 展开一个文件,返回false表示出错
+bool ShaderSource::expand(const std::string &path, int parent, int depth)
+{
+    std::string normalized = normalizePath(path);
+
+    // 同一文件只展开一次,重复包含及循环包含只记录依赖关系
+    for(size_t i = 0; i < files.size(); i++)
+    {
+        if(files[i] == normalized)
+        {
+            if(parent >= 0)
+                includes.push_back(std::make_pair(parent, (int)i));
+            return true;
+        }
+    }
+    if(depth > MaxIncludeDepth)
+    {
+        error = "Shader Include Too Deep, Path = " + normalized;
+        return false;
+    }
+
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    if(overrideDirectory.empty())
+    {
+        // 使用嵌入可执行文件的源码,不访问文件系统,哈希在构建时已经算好
+        const EmbeddedShader *embedded = EmbeddedShaders::find(normalized);
+        if(!embedded)
+        {
+            error = "Embedded Shader Not Found, Path = " + normalized;
+            return false;
+        }
+        begin = embedded->data;
+        end = begin + embedded->length;
+        fileHashes.push_back(embedded->hash);
+    }
+    else
+    {
+        // 映射文件
+        std::unique_ptr<MappedFile> file(new MappedFile(normalized, bIsCopy));
+        if(!file->isOpen())
+        {
+            error = "Read File Fail, Path = " + normalized;
+            return false;
+        }
+        begin = file->getData();
+        end = begin + file->getSize();
+        fileHashes.push_back(ShaderCache::hash(begin, file->getSize()));
+        mappedFiles.push_back(std::move(file));
+    }
+    int index = (int)files.size();
+    files.push_back(normalized);
+    if(parent >= 0)
+    {
+        includes.push_back(std::make_pair(parent, index));
+        addLineDirective(1, index);
+    }
+
+    // 被包含文件相对于当前文件所在目录查找
+    std::string directory;
+    size_t slash = normalized.find_last_of('/');
+    if(slash != std::string::npos)
+    {
+        directory = normalized.substr(0, slash + 1);
+    }
+
+    // 逐行扫描#include指令,其余内容直接作为片段引用映射内存
+    const char *segmentStart = begin;
+    const char *lineStart = begin;
+    int line = 1;
+    bool bHasVersion = false;
+    while(lineStart < end)
+    {
+        const char *lineEnd = (const char *)std::memchr(lineStart, '\n', end - lineStart);
+        if(!lineEnd)
+            lineEnd = end;
+        const char *next = lineEnd < end ? lineEnd + 1 : end;
+
+        // 解析#version、#pragma keywords以及形如 #include "name" 或 #include <name> 的行
+        const char *cursor = lineStart;
+        while(cursor < lineEnd && (*cursor == ' ' || *cursor == '\t'))
+            cursor++;
+        if(cursor < lineEnd && *cursor == '#')
+        {
+            cursor++;
+            while(cursor < lineEnd && (*cursor == ' ' || *cursor == '\t'))
+                cursor++;
+            const size_t keywordLength = 7;
+            if(parent < 0 && !bHasVersion && (size_t)(lineEnd - cursor) >= keywordLength && 0 == std::strncmp(cursor, "version", keywordLength))
+            {
+                // 宏注入到入口文件的#version之后,#version之前只能有注释与空白
+                bHasVersion = true;
+                // 映射的内存不以'\0'结尾,在行内解析版本号
+                const char *number = cursor + keywordLength;
+                while(number < lineEnd && (*number == ' ' || *number == '\t'))
+                    number++;
+                for(version = 0; number < lineEnd && *number >= '0' && *number <= '9'; number++)
+                    version = version * 10 + (*number - '0');
+                if(!defines.empty())
+                {
+                    addSegment(segmentStart, next - segmentStart);
+                    addDefines();
+                    addLineDirective(line + 1, index);
+                    segmentStart = next;
+                }
+            }
+            else if((size_t)(lineEnd - cursor) > 6 && 0 == std::strncmp(cursor, "pragma", 6))
+            {
+                parseKeywords(cursor + 6, lineEnd);
+            }
+            else if((size_t)(lineEnd - cursor) > keywordLength && 0 == std::strncmp(cursor, "include", keywordLength))
+            {
+                cursor += keywordLength;
+                while(cursor < lineEnd && (*cursor == ' ' || *cursor == '\t'))
+                    cursor++;
+                char closeChar = 0;
+                if(cursor < lineEnd && *cursor == '"')
+                    closeChar = '"';
+                else if(cursor < lineEnd && *cursor == '<')
+                    closeChar = '>';
+                const char *nameEnd = closeChar ? (const char *)std::memchr(cursor + 1, closeChar, lineEnd - cursor - 1) : nullptr;
+                if(!nameEnd)
+                {
+                    error = "Shader Include Syntax Error, Path = " + normalized + ":" + std::to_string(line);
+                    return false;
+                }
+
+                // 当前片段到#include行之前结束,展开被包含文件后从下一行继续
+                addSegment(segmentStart, lineStart - segmentStart);
+                if(!expand(directory + std::string(cursor + 1, nameEnd), index, depth + 1))
+                {
+                    return false;
+                }
+                addLineDirective(line + 1, index);
+                segmentStart = next;
+            }
+        }
+
+        lineStart = next;
+        line++;
+    }
+    addSegment(segmentStart, end - segmentStart);
+
+    // 入口文件没有#version时宏放在最前面
+    if(parent < 0 && !bHasVersion && !defines.empty())
+    {
+        size_t count = segments.size();
+        addDefines();
+        addLineDirective(1, index);
+        std::rotate(segments.begin(), segments.begin() + count, segments.end());
+        std::rotate(lengths.begin(), lengths.begin() + count, lengths.end());
+    }
+    return true;
+}
+
+// 添加源码片段
+void ShaderSource::addSegment(const char *data, size_t length)
+{
+    if(length > 0)
+    {
+        segments.push_back(data);
+        lengths.push_back((GLint)length);
+    }
+}
+
+// 添加#line指令,恢复编译错误中的行号与文件编号
+void ShaderSource::addLineDirective(int line, int fileIndex)
+{
+    // GLSL 4.30之前"#line n"之后的一行行号为n+1,4.30起为n;开头的换行保证指令位于行首
+    int offset = version < 430 ? 1 : 0;
+    char directive[48];
+    std::snprintf(directive, sizeof(directive), "\n#line %d %d\n", line - offset, fileIndex);
+    generatedText.push_back(directive);
+    addSegment(generatedText.back().data(), generatedText.back().size());
+}
+
+// 添加注入的#define指令
+void ShaderSource::addDefines()
+{
+    std::string text;
+    for(const std::string &define : defines)
+    {
+        text.append("\n#define ").append(define).append(" 1");
+    }
+    generatedText.push_back(text);
+    addSegment(generatedText.back().data(), generatedText.back().size());
+}
+
+// 解析"#pragma keywords"之后的关键字列表,其他#pragma交给驱动处理
+void ShaderSource::parseKeywords(const char *begin, const char *end)
+{
+    std::vector<std::string> words;
+    std::string word;
+    for(const char *cursor = begin; cursor <= end; cursor++)
+    {
+        if(cursor == end || *cursor == ' ' || *cursor == '\t' || *cursor == '\r')
+        {
+            if(!word.empty())
+                words.push_back(word);
+            word.clear();
+        }
+        else
+        {
+            word.push_back(*cursor);
+        }
+    }
+    if(words.empty() || words[0] != "keywords")
+    {
+        return;
+    }
+    for(size_t i = 1; i < words.size(); i++)
+    {
+        if(std::find(keywords.begin(), keywords.end(), words[i]) == keywords.end())
+            keywords.push_back(words[i]);
+    }
+}
@@ -0,0 +1,290 @@
+#include "ShaderWatcher.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// 文件修改后等待的安静时间,编辑器保存时通常会连续产生多次事件
+static const int DebounceMilliseconds = 100;
+
+// 构造函数
+ShaderWatcher::ShaderWatcher() : bIsRunning(false)
+{
+#ifdef __linux__
+    inotifyDescriptor = -1;
+#endif
+}
+
+// 析构函数,停止后台线程
+ShaderWatcher::~ShaderWatcher()
+{
+    stop();
+}
+
+// 监视着色器,着色器的生命周期需要长于监视器
+void ShaderWatcher::watch(Shader *shader)
+{
+    WatchEntry entry;
+    entry.shader = shader;
+    entry.vertexPath = shader->getVertexPath();
+    entry.fragmentPath = shader->getFragmentPath();
+    entry.defines = shader->getDefines();
+    entry.dependencies = shader->getDependencies();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_back(entry);
+}
+
+// 启动后台线程
+void ShaderWatcher::start()
+{
+    if(bIsRunning)
+    {
+        return;
+    }
+#ifdef __linux__
+    inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotifyDescriptor < 0)
+    {
+        std::cout << "Shader Watcher inotify Init Fail..." << std::endl;
+        return;
+    }
+#endif
+    bIsRunning = true;
+    thread = std::thread(&ShaderWatcher::run, this);
+}
+
+// 停止后台线程
+void ShaderWatcher::stop()
+{
+    bIsRunning = false;
+    if(thread.joinable())
+    {
+        thread.join();
+    }
+#ifdef __linux__
+    if(inotifyDescriptor >= 0)
+    {
+        close(inotifyDescriptor);
+        inotifyDescriptor = -1;
+        watchDirectories.clear();
+    }
+#endif
+}
+
+// 在帧开始时调用,替换已重建的程序,返回替换成功的数量
+int ShaderWatcher::update()
+{
+    std::vector<PendingReload> reloads;
+    {
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+        if(!lock.owns_lock() || pendingReloads.empty())
+        {
+            return 0;
+        }
+        reloads.swap(pendingReloads);
+    }
+
+    // 编译链接新程序,失败时Shader继续使用旧程序
+    int count = 0;
+    for(PendingReload &reload : reloads)
+    {
+        if(reload.shader->reload(*reload.vertexSource, *reload.fragmentSource))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// 后台线程函数
+void ShaderWatcher::run()
+{
+    std::set<std::string> changedFiles;
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+    while(bIsRunning)
+    {
+        // 为依赖文件所在的目录添加监视,编辑器保存时经常先写临时文件再改名,因此监视目录而不是文件
+        std::set<std::string> directories;
+        for(const std::string &file : collectDependencies())
+        {
+            size_t slash = file.find_last_of('/');
+            directories.insert(slash == std::string::npos ? std::string(".") : file.substr(0, slash));
+        }
+        for(const std::string &directory : directories)
+        {
+            bool bIsWatched = false;
+            for(const auto &item : watchDirectories)
+            {
+                if(item.second == directory)
+                {
+                    bIsWatched = true;
+                    break;
+                }
+            }
+            if(!bIsWatched)
+            {
+                int watchDescriptor = inotify_add_watch(inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                if(watchDescriptor >= 0)
+                    watchDirectories[watchDescriptor] = directory;
+            }
+        }
+
+        // 等待事件,超时用于检查停止标志及处理已安静的修改
+        struct pollfd descriptor = {inotifyDescriptor, POLLIN, 0};
+        int result = poll(&descriptor, 1, DebounceMilliseconds);
+        if(result > 0 && (descriptor.revents & POLLIN))
+        {
+            ssize_t length;
+            while((length = read(inotifyDescriptor, buffer, sizeof(buffer))) > 0)
+            {
+                for(char *cursor = buffer; cursor < buffer + length;)
+                {
+                    const struct inotify_event *event = (const struct inotify_event *)cursor;
+                    auto it = watchDirectories.find(event->wd);
+                    if(event->len > 0 && it != watchDirectories.end())
+                    {
+                        changedFiles.insert(ShaderSource::normalizePath(it->second + "/" + event->name));
+                    }
+                    cursor += sizeof(struct inotify_event) + event->len;
+                }
+            }
+        }
+        else if(0 == result && !changedFiles.empty())
+        {
+            reloadChanged(changedFiles);
+            changedFiles.clear();
+        }
+    }
+#else
+    while(bIsRunning)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(DebounceMilliseconds));
+
+        // 没有文件通知接口时比较文件的修改时间
+        bool bIsChanged = false;
+        for(const std::string &file : collectDependencies())
+        {
+            struct stat fileStat;
+            if(stat(file.c_str(), &fileStat) != 0)
+            {
+                continue;
+            }
+            auto it = modifyTimes.find(file);
+            if(it == modifyTimes.end())
+            {
+                modifyTimes[file] = fileStat.st_mtime;
+            }
+            else if(it->second != fileStat.st_mtime)
+            {
+                it->second = fileStat.st_mtime;
+                changedFiles.insert(file);
+                bIsChanged = true;
+            }
+        }
+
+        // 本轮没有新的修改时再处理,等同于inotify的安静时间
+        if(!bIsChanged && !changedFiles.empty())
+        {
+            reloadChanged(changedFiles);
+            changedFiles.clear();
+        }
+    }
+#endif
+}
+
+// 读取受修改文件影响的程序源码,提交给渲染线程
+void ShaderWatcher::reloadChanged(const std::set<std::string> &changedFiles)
+{
+    // 找出受影响的程序,只复制路径,不在持有锁时读取文件
+    std::vector<WatchEntry> affected;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const WatchEntry &entry : entries)
+        {
+            for(const std::string &file : entry.dependencies)
+            {
+                if(changedFiles.count(file))
+                {
+                    affected.push_back(entry);
+                    break;
+                }
+            }
+        }
+    }
+
+    for(const WatchEntry &entry : affected)
+    {
+        // 读入内存而不映射,编辑器可能随时再次写入文件
+        PendingReload reload;
+        reload.shader = entry.shader;
+        reload.vertexSource.reset(new ShaderSource(entry.vertexPath, entry.defines, true));
+        reload.fragmentSource.reset(new ShaderSource(entry.fragmentPath, entry.defines, true));
+
+        // 更新依赖文件,即使源码有误也要监视新包含的文件
+        std::vector<std::string> dependencies;
+        const ShaderSource *sources[] = {reload.vertexSource.get(), reload.fragmentSource.get()};
+        for(const ShaderSource *source : sources)
+        {
+            for(const std::string &file : source->getFiles())
+            {
+                if(std::find(dependencies.begin(), dependencies.end(), file) == dependencies.end())
+                    dependencies.push_back(file);
+            }
+        }
+
+        bool bIsValid = reload.vertexSource->isValid() && reload.fragmentSource->isValid();
+        if(!bIsValid)
+        {
+            std::cout << "## " << entry.vertexPath << " + " << entry.fragmentPath << " ## reload skipped: "
+                      << (reload.vertexSource->isValid() ? reload.fragmentSource->getError() : reload.vertexSource->getError()) << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for(WatchEntry &watched : entries)
+        {
+            if(watched.shader == entry.shader)
+            {
+                watched.dependencies = dependencies;
+            }
+        }
+        if(!bIsValid)
+        {
+            continue;
+        }
+        // 同一程序只保留最新的源码
+        bool bIsReplaced = false;
+        for(PendingReload &pending : pendingReloads)
+        {
+            if(pending.shader == reload.shader)
+            {
+                pending = std::move(reload);
+                bIsReplaced = true;
+                break;
+            }
+        }
+        if(!bIsReplaced)
+        {
+            pendingReloads.push_back(std::move(reload));
+        }
+    }
+}
+
+// 复制所有依赖文件
+std::set<std::string> ShaderWatcher::collectDependencies()
+{
+    std::set<std::string> files;
+    std::lock_guard<std::mutex> lock(mutex);
+    for(const WatchEntry &entry : entries)
+    {
+        files.insert(entry.dependencies.begin(), entry.dependencies.end());
+    }
+    return files;
+}
@@ -0,0 +1,481 @@
+#include "ShadowMaps.h"
+#include "GLStateCache.h"
+#include "Mesh.h"
+#include "PointLightList.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// 级联的缓存范围相对于相机切片包围球的放大倍数,相机在余量内移动时不重绘
+static const float CascadeMargin = 1.25f;
+// 级联按对数与均匀划分混合,越大越接近对数划分
+static const float CascadeSplitLambda = 0.75f;
+// 光源空间深度范围在场景包围盒外的余量
+static const float LightDepthMargin = 1.0f;
+// 立方体阴影的近平面
+static const float PointNearPlane = 0.05f;
+// 世界空间中的深度偏移
+static const float DepthBias = 0.02f;
+// 法线偏移的纹素数量
+static const float NormalOffsetTexels = 1.5f;
+
+// 设置深度纹理的比较采样,范围外视为不在阴影中
+static void setShadowParameters(GLenum target)
+{
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    GLenum wrap = GL_TEXTURE_CUBE_MAP == target ? GL_CLAMP_TO_EDGE : GL_CLAMP_TO_BORDER;
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(target, GL_TEXTURE_WRAP_R, wrap);
+    const GLfloat border[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, border);
+}
+
+// 构造函数,创建cascadeSize x cascadeSize的级联与cubeSize x cubeSize的立方体阴影,casterMesh为所有投射阴影物体共用的网格
+ShadowMaps::ShadowMaps(GLsizei cascadeSize, GLsizei cubeSize, const Mesh &casterMesh)
+    : cascadeSize(cascadeSize), cubeSize(cubeSize), framebuffer(0), instanceBuffer(0), instanceVertexArray(0), casterMesh(casterMesh),
+      depthShaders("Shadow/Depth.vs.glsl", "Shadow/Depth.fs.glsl"), cascadeShader(nullptr), pointShader(nullptr), lightDirection(0.0f), lightView(1.0f), lightNear(0.0f), lightFar(1.0f),
+      pointBounds(0.0f), statistics(), shadowUniformBuffer(UniformBlockBinding::Shadow, sizeof(ShadowData)), shadowData()
+{
+    for(Cascade &cascade : cascades)
+    {
+        cascade.state = {false, false};
+        cascade.center = glm::vec2(0.0f);
+        cascade.halfSize = 0.0f;
+        cascade.viewProjection = glm::mat4(1.0f);
+    }
+    pointState = {false, false};
+
+    // 级联的每一级为数组的一层,立方体阴影保存到光源的距离
+    glGenTextures(TextureCount, textures);
+    for(int i = 0; i < 2; i++)
+    {
+        GLStateCache::bindTexture(0, GL_TEXTURE_2D_ARRAY, textures[i]);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, cascadeSize, cascadeSize, CascadeCount, 0,
+                     GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        setShadowParameters(GL_TEXTURE_2D_ARRAY);
+    }
+    for(int i = 2; i < TextureCount; i++)
+    {
+        GLStateCache::bindTexture(0, GL_TEXTURE_CUBE_MAP, textures[i]);
+        for(GLenum face = 0; face < 6; face++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, cubeSize, cubeSize, 0,
+                         GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        setShadowParameters(GL_TEXTURE_CUBE_MAP);
+    }
+    // 立方体贴图在面的边缘跨面过滤
+    GLStateCache::setEnabled(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
+
+    // 只写深度,附件在绘制时切换到对应的层或面
+    glGenFramebuffers(1, &framebuffer);
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // 投射阴影物体的VAO,另外从实例缓冲读取模型矩阵
+    glGenBuffers(1, &instanceBuffer);
+    instanceVertexArray = casterMesh.createVertexArray();
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for(GLuint column = 0; column < 4; column++)
+    {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribDivisor(3 + column, 1);
+    }
+}
+
+// 把两个深度变体提交到着色器库,与其他启动时的程序一起编译
+void ShadowMaps::prebuildShaders(ShaderLibrary &library)
+{
+    depthShaders.prebuild({0, depthShaders.keywordMask({"POINT_LIGHT"})}, library);
+}
+
+// 设置热重载监视器
+void ShadowMaps::setWatcher(ShaderWatcher *shaderWatcher)
+{
+    depthShaders.setWatcher(shaderWatcher);
+}
+
+// 设置静态物体,spheres的xyz为球心,w为半径,所有静态层失效
+void ShadowMaps::setStaticCasters(const glm::mat4 *models, const glm::vec4 *spheres, size_t count)
+{
+    staticModels.assign(models, models + count);
+    staticSpheres.assign(spheres, spheres + count);
+    pointState.bIsStaticValid = false;
+    updateLightSpace();
+}
+
+// 设置动态物体,每帧调用,只有模型矩阵改变的物体使其前后范围内的动态层失效
+void ShadowMaps::setDynamicCasters(const glm::mat4 *models, const glm::vec4 *spheres, size_t count)
+{
+    if(count != dynamicModels.size())
+    {
+        dynamicModels.assign(models, models + count);
+        dynamicSpheres.assign(spheres, spheres + count);
+        changedSpheres.clear();
+        pointState.bIsDynamicValid = false;
+        updateLightSpace();
+        return;
+    }
+    for(size_t i = 0; i < count; i++)
+    {
+        if(0 == std::memcmp(&models[i], &dynamicModels[i], sizeof(glm::mat4)))
+            continue;
+        changedSpheres.push_back(dynamicSpheres[i]);
+        changedSpheres.push_back(spheres[i]);
+        dynamicModels[i] = models[i];
+        dynamicSpheres[i] = spheres[i];
+    }
+}
+
+// 设置平行光方向,改变时所有级联失效
+void ShadowMaps::setDirectionLight(const glm::vec3 &direction)
+{
+    glm::vec3 normalized = glm::normalize(direction);
+    if(normalized == lightDirection)
+    {
+        return;
+    }
+    lightDirection = normalized;
+    updateLightSpace();
+}
+
+// 设置点光源,位置或影响半径改变时立方体阴影失效
+void ShadowMaps::setPointLight(const PointLightData &light)
+{
+    glm::vec4 bounds(light.position, PointLightList::computeRadius(light));
+    if(bounds == pointBounds)
+    {
+        return;
+    }
+    pointBounds = bounds;
+    pointState = {false, false};
+}
+
+// 使所有阴影贴图失效,下一次更新时全部重绘
+void ShadowMaps::invalidate()
+{
+    for(Cascade &cascade : cascades)
+        cascade.state = {false, false};
+    pointState = {false, false};
+}
+
+// 由平行光方向与所有物体的包围盒计算光源空间,所有级联失效
+void ShadowMaps::updateLightSpace()
+{
+    // 范围清零,下一次更新时按新的光源空间重新调整
+    for(Cascade &cascade : cascades)
+    {
+        cascade.state = {false, false};
+        cascade.halfSize = 0.0f;
+    }
+    if(glm::vec3(0.0f) == lightDirection)
+    {
+        return;
+    }
+    glm::vec3 up = std::fabs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    lightView = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+
+    // 场景包围盒的八个角在光源空间中的深度范围,光源沿-z观察
+    // 级联只在深度范围内裁剪,绘制时开启深度截取,范围外的物体压到近平面上仍然投射阴影
+    glm::vec3 minimum(FLT_MAX);
+    glm::vec3 maximum(-FLT_MAX);
+    auto expand = [&](const std::vector<glm::vec4> &spheres)
+    {
+        for(const glm::vec4 &sphere : spheres)
+        {
+            minimum = glm::min(minimum, glm::vec3(sphere) - sphere.w);
+            maximum = glm::max(maximum, glm::vec3(sphere) + sphere.w);
+        }
+    };
+    expand(staticSpheres);
+    expand(dynamicSpheres);
+    if(minimum.x > maximum.x)
+    {
+        lightNear = 0.0f;
+        lightFar = 1.0f;
+        return;
+    }
+    float minZ = FLT_MAX;
+    float maxZ = -FLT_MAX;
+    for(int corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 point((corner & 1) ? maximum.x : minimum.x, (corner & 2) ? maximum.y : minimum.y, (corner & 4) ? maximum.z : minimum.z);
+        float z = (lightView * glm::vec4(point, 1.0f)).z;
+        minZ = std::min(minZ, z);
+        maxZ = std::max(maxZ, z);
+    }
+    lightNear = -maxZ - LightDepthMargin;
+    lightFar = -minZ + LightDepthMargin;
+}
+
+// 调整一级级联的范围,相机的切片离开缓存范围时重新居中,两层都失效
+void ShadowMaps::fitCascade(int index, const glm::mat4 &inverseView, float tanHalfX, float tanHalfY, float nearDepth, float farDepth)
+{
+    // 切片八个角的包围球,半径只与视角与深度有关,相机旋转时不变
+    glm::vec3 corners[8];
+    glm::vec3 center(0.0f);
+    for(int corner = 0; corner < 8; corner++)
+    {
+        float depth = (corner & 4) ? farDepth : nearDepth;
+        corners[corner] = glm::vec3((corner & 1 ? 1.0f : -1.0f) * depth * tanHalfX, (corner & 2 ? 1.0f : -1.0f) * depth * tanHalfY, -depth);
+        center += corners[corner] / 8.0f;
+    }
+    float radius = 0.0f;
+    for(const glm::vec3 &corner : corners)
+        radius = std::max(radius, glm::length(corner - center));
+    glm::vec2 lightCenter(lightView * inverseView * glm::vec4(center, 1.0f));
+
+    Cascade &cascade = cascades[index];
+    glm::vec2 offset = glm::abs(lightCenter - cascade.center);
+    bool bIsContained = radius <= cascade.halfSize && cascade.halfSize <= radius * CascadeMargin * 1.01f &&
+                        std::max(offset.x, offset.y) + radius <= cascade.halfSize;
+    if(bIsContained)
+    {
+        return;
+    }
+    // 中心对齐到纹素,重新居中前后同一物体落在相同的纹素上
+    cascade.halfSize = radius * CascadeMargin;
+    float texelSize = 2.0f * cascade.halfSize / (float)cascadeSize;
+    cascade.center = glm::floor(lightCenter / texelSize) * texelSize;
+    glm::mat4 projection = glm::ortho(cascade.center.x - cascade.halfSize, cascade.center.x + cascade.halfSize,
+                                      cascade.center.y - cascade.halfSize, cascade.center.y + cascade.halfSize, lightNear, lightFar);
+    cascade.viewProjection = projection * lightView;
+    cascade.state = {false, false};
+}
+
+// 按相机调整级联的范围,重绘失效且需要的阴影贴图并上传阴影参数,fovY为弧度
+// 返回是否绘制过,绘制过时视口与帧缓冲已改变,调用者需要恢复视口
+bool ShadowMaps::update(const glm::mat4 &view, float fovY, float aspect, float nearPlane, float shadowDistance,
+                        bool bUseDirectionLight, bool bUsePointLight)
+{
+    // 级联按对数与均匀划分的混合切分阴影距离
+    glm::mat4 inverseView = glm::inverse(view);
+    float tanHalfY = std::tan(0.5f * fovY);
+    float tanHalfX = tanHalfY * aspect;
+    float splitNear = nearPlane;
+    for(int i = 0; i < CascadeCount; i++)
+    {
+        float t = (float)(i + 1) / CascadeCount;
+        float logSplit = nearPlane * std::pow(shadowDistance / nearPlane, t);
+        float uniformSplit = nearPlane + (shadowDistance - nearPlane) * t;
+        float splitFar = CascadeSplitLambda * logSplit + (1.0f - CascadeSplitLambda) * uniformSplit;
+        fitCascade(i, inverseView, tanHalfX, tanHalfY, splitNear, splitFar);
+        shadowData.cascadeSplits[i] = splitFar;
+        splitNear = splitFar;
+    }
+
+    // 改变的动态物体使其改变前后所在范围的动态层失效
+    for(const glm::vec4 &sphere : changedSpheres)
+    {
+        for(Cascade &cascade : cascades)
+        {
+            if(cascade.state.bIsDynamicValid && intersectsCascade(cascade, sphere))
+                cascade.state.bIsDynamicValid = false;
+        }
+        if(pointState.bIsDynamicValid && intersectsPointLight(sphere))
+            pointState.bIsDynamicValid = false;
+    }
+    changedSpheres.clear();
+
+    // 只重绘本帧用到的失效层,其余的保持失效直到用到
+    bool bHasDrawn = false;
+    auto beginPass = [&]()
+    {
+        if(bHasDrawn)
+            return;
+        bHasDrawn = true;
+        resolveShaders();
+        GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        GLStateCache::depthMask(GL_TRUE);
+        GLStateCache::setEnabled(GL_DEPTH_CLAMP, true);
+    };
+    if(bUseDirectionLight)
+    {
+        for(int i = 0; i < CascadeCount; i++)
+        {
+            if(!cascades[i].state.bIsStaticValid)
+            {
+                beginPass();
+                drawCascade(i, false);
+            }
+            if(!cascades[i].state.bIsDynamicValid)
+            {
+                beginPass();
+                drawCascade(i, true);
+            }
+        }
+    }
+    if(bUsePointLight && pointBounds.w > 0.0f)
+    {
+        if(!pointState.bIsStaticValid)
+        {
+            beginPass();
+            drawPointLight(false);
+        }
+        if(!pointState.bIsDynamicValid)
+        {
+            beginPass();
+            drawPointLight(true);
+        }
+    }
+    if(bHasDrawn)
+    {
+        GLStateCache::setEnabled(GL_DEPTH_CLAMP, false);
+        GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // 纹理坐标与深度从-1到1映射到0到1
+    const glm::mat4 bias = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)), glm::vec3(0.5f));
+    for(int i = 0; i < CascadeCount; i++)
+    {
+        shadowData.cascadeMatrices[i] = bias * cascades[i].viewProjection;
+        shadowData.cascadeTexelSizes[i] = 2.0f * cascades[i].halfSize / (float)cascadeSize;
+    }
+    shadowData.pointShadowBounds = pointBounds;
+    // 深度偏移换算到各自的深度范围,立方体的法线偏移约为两个纹素
+    shadowData.shadowBias = glm::vec4(DepthBias / (lightFar - lightNear), pointBounds.w > 0.0f ? DepthBias / pointBounds.w : 0.0f,
+                                      NormalOffsetTexels, 4.0f / (float)cubeSize);
+    shadowUniformBuffer.update(shadowData);
+    return bHasDrawn;
+}
+
+// 收集与判断函数相交的物体,上传模型矩阵,返回数量
+template <typename Predicate>
+GLsizei ShadowMaps::uploadCasters(const std::vector<glm::mat4> &models, const std::vector<glm::vec4> &spheres, const Predicate &predicate)
+{
+    batch.clear();
+    for(size_t i = 0; i < models.size(); i++)
+    {
+        if(predicate(spheres[i]))
+            batch.push_back(models[i]);
+    }
+    if(!batch.empty())
+    {
+        GLStateCache::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)batch.size() * sizeof(glm::mat4), batch.data(), GL_STREAM_DRAW);
+    }
+    statistics.casterInstances += batch.size();
+    return (GLsizei)batch.size();
+}
+
+// 获取两个深度变体及其Uniform句柄,第一次绘制时调用,未预先构建的变体在此编译
+void ShadowMaps::resolveShaders()
+{
+    if(cascadeShader)
+        return;
+    cascadeShader = depthShaders.get(0);
+    pointShader = depthShaders.get({"POINT_LIGHT"});
+    cascadeViewProjectionHandle = cascadeShader->uniform("lightViewProjection");
+    pointViewProjectionHandle = pointShader->uniform("lightViewProjection");
+    pointPositionRadiusHandle = pointShader->uniform("lightPositionRadius");
+}
+
+// 重绘一级级联的一层
+void ShadowMaps::drawCascade(int index, bool bIsDynamic)
+{
+    Cascade &cascade = cascades[index];
+    auto predicate = [&](const glm::vec4 &sphere)
+    {
+        return intersectsCascade(cascade, sphere);
+    };
+    GLsizei count = bIsDynamic ? uploadCasters(dynamicModels, dynamicSpheres, predicate) : uploadCasters(staticModels, staticSpheres, predicate);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textures[bIsDynamic ? 1 : 0], 0, index);
+    glViewport(0, 0, cascadeSize, cascadeSize);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    if(count > 0)
+    {
+        cascadeShader->set(cascadeViewProjectionHandle, cascade.viewProjection);
+        cascadeShader->use();
+        casterMesh.drawInstanced(instanceVertexArray, count);
+    }
+    if(bIsDynamic)
+    {
+        cascade.state.bIsDynamicValid = true;
+        statistics.dynamicRedraws++;
+    }
+    else
+    {
+        cascade.state.bIsStaticValid = true;
+        statistics.staticRedraws++;
+    }
+}
+
+// 重绘立方体阴影的一层
+void ShadowMaps::drawPointLight(bool bIsDynamic)
+{
+    auto predicate = [&](const glm::vec4 &sphere)
+    {
+        return intersectsPointLight(sphere);
+    };
+    GLsizei count = bIsDynamic ? uploadCasters(dynamicModels, dynamicSpheres, predicate) : uploadCasters(staticModels, staticSpheres, predicate);
+
+    // 六个面的观察方向与上方向,与立方体贴图的面顺序一致
+    static const glm::vec3 directions[6] = {{1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f},
+                                            {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}};
+    static const glm::vec3 ups[6] = {{0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
+                                     {0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}};
+    glm::vec3 position(pointBounds);
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, PointNearPlane, pointBounds.w);
+    pointShader->set(pointPositionRadiusHandle, pointBounds);
+    glViewport(0, 0, cubeSize, cubeSize);
+    for(GLenum face = 0; face < 6; face++)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, textures[bIsDynamic ? 3 : 2], 0);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        if(count > 0)
+        {
+            pointShader->set(pointViewProjectionHandle, projection * glm::lookAt(position, position + directions[face], ups[face]));
+            pointShader->use();
+            casterMesh.drawInstanced(instanceVertexArray, count);
+        }
+    }
+    if(bIsDynamic)
+    {
+        pointState.bIsDynamicValid = true;
+        statistics.dynamicRedraws++;
+    }
+    else
+    {
+        pointState.bIsStaticValid = true;
+        statistics.staticRedraws++;
+    }
+}
+
+// 球是否与级联在光源空间的范围相交,深度方向不限
+bool ShadowMaps::intersectsCascade(const Cascade &cascade, const glm::vec4 &sphere) const
+{
+    glm::vec2 center(lightView * glm::vec4(glm::vec3(sphere), 1.0f));
+    glm::vec2 offset = glm::abs(center - cascade.center);
+    return std::max(offset.x, offset.y) <= cascade.halfSize + sphere.w;
+}
+
+// 球是否与点光源的影响范围相交
+bool ShadowMaps::intersectsPointLight(const glm::vec4 &sphere) const
+{
+    return glm::length(glm::vec3(sphere) - glm::vec3(pointBounds)) < pointBounds.w + sphere.w;
+}
+
+// 把四张阴影贴图绑定到firstUnit开始的纹理单元
+void ShadowMaps::bind(GLuint firstUnit) const
+{
+    GLStateCache::bindTexture(firstUnit, GL_TEXTURE_2D_ARRAY, textures[0]);
+    GLStateCache::bindTexture(firstUnit + 1, GL_TEXTURE_2D_ARRAY, textures[1]);
+    GLStateCache::bindTexture(firstUnit + 2, GL_TEXTURE_CUBE_MAP, textures[2]);
+    GLStateCache::bindTexture(firstUnit + 3, GL_TEXTURE_CUBE_MAP, textures[3]);
+}
+
+// 把着色器中Shadows.glsl的采样器设置为firstUnit开始的纹理单元
+void ShadowMaps::setSamplers(Shader *shader, GLuint firstUnit)
+{
+    shader->set(shader->uniform("cascadeStaticMap"), (int)firstUnit);
+    shader->set(shader->uniform("cascadeDynamicMap"), (int)firstUnit + 1);
+    shader->set(shader->uniform("pointStaticMap"), (int)firstUnit + 2);
+    shader->set(shader->uniform("pointDynamicMap"), (int)firstUnit + 3);
+}
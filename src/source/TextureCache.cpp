@@ -0,0 +1,139 @@
+#include "TextureCache.h"
+#include "MappedFile.h"
+#include "MipmapGenerator.h"
+#include "ShaderCache.h"
+#include "stb_image.h"
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+// 缓存文件头,用于校验文件是否有效
+struct TextureCacheHeader
+{
+    // 文件标识"TXMC"
+    uint32_t magic;
+    // 文件格式版本,缩小算法改变时加一
+    uint32_t version;
+    // 缓存键,源文件改变时不再匹配
+    uint64_t key;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    uint32_t reserved;
+};
+
+static const uint32_t TextureCacheMagic = 0x434D5854;
+static const uint32_t TextureCacheVersion = 1;
+
+// 是否读写缓存文件
+bool TextureCache::bIsEnabled = true;
+
+// 设置是否读写缓存文件,关闭时每次加载都解码并生成Mipmap链,只在没有加载进行时调用
+void TextureCache::setEnabled(bool bEnabled)
+{
+    bIsEnabled = bEnabled;
+}
+
+// 缓存文件路径,位于源图片旁边
+std::string TextureCache::cachePath(const std::string &path)
+{
+    return path + ".mips";
+}
+
+// 读取贴图,缓存有效时直接读取,否则解码源图片、生成Mipmap链并写入缓存,源图片无法读取时返回false
+// 关闭缓存时不读写缓存文件,bIsCached不为空时返回是否命中缓存,多个线程可以同时加载
+bool TextureCache::load(const std::string &path, bool bIsSRGB, const MipmapGenerator &generator, Image &image, bool *bIsCached)
+{
+    if(bIsCached)
+        *bIsCached = false;
+    // 源文件映射后既用于计算缓存键,也在缓存失效时直接从内存解码
+    MappedFile source(path);
+    if(!source.isOpen() || 0 == source.getSize())
+    {
+        return false;
+    }
+    const unsigned char flag = bIsSRGB ? 1 : 0;
+    uint64_t key = bIsEnabled ? ShaderCache::hash(source.getData(), source.getSize(), ShaderCache::hash(&flag, 1)) : 0;
+    std::string mipsPath = cachePath(path);
+    if(bIsEnabled && read(mipsPath, key, image))
+    {
+        if(bIsCached)
+            *bIsCached = true;
+        return true;
+    }
+
+    int channel;
+    unsigned char *data = stbi_load_from_memory(reinterpret_cast<const unsigned char *>(source.getData()), (int)source.getSize(),
+                                                &image.width, &image.height, &channel, 4);
+    if(!data)
+    {
+        return false;
+    }
+    image.levelCount = MipmapGenerator::getLevelCount(image.width, image.height);
+    image.pixels.resize(MipmapGenerator::getChainSize(image.width, image.height));
+    generator.generate(data, image.width, image.height, bIsSRGB, image.pixels.data());
+    stbi_image_free(data);
+    if(bIsEnabled)
+        write(mipsPath, key, image);
+    return true;
+}
+
+// 读取缓存文件,文件缺失、损坏或键不匹配时返回false
+bool TextureCache::read(const std::string &path, uint64_t key, Image &image)
+{
+    // 打开缓存文件,不存在即为首次加载
+    std::ifstream ifile(path, std::ios::binary);
+    if(!ifile.is_open())
+    {
+        return false;
+    }
+
+    // 校验文件头,源文件改变后旧的缓存会在写入新缓存时被替换
+    TextureCacheHeader header;
+    if(!ifile.read((char *)&header, sizeof(header)) || header.magic != TextureCacheMagic || header.version != TextureCacheVersion
+       || header.key != key || 0 == header.width || 0 == header.height || 0 == header.levelCount
+       || (int)header.levelCount != MipmapGenerator::getLevelCount((int)header.width, (int)header.height))
+    {
+        return false;
+    }
+
+    // 读取Mipmap链,文件被截断时视为缓存缺失
+    image.width = (int)header.width;
+    image.height = (int)header.height;
+    image.levelCount = (int)header.levelCount;
+    image.pixels.resize(MipmapGenerator::getChainSize(image.width, image.height));
+    if(!ifile.read((char *)image.pixels.data(), (std::streamsize)image.pixels.size()))
+    {
+        image.pixels.clear();
+        return false;
+    }
+    return true;
+}
+
+// 写入缓存文件
+// 先写临时文件再改名,避免中途退出留下不完整的缓存,临时文件名带线程标识,多个线程同时写同一缓存时互不干扰
+void TextureCache::write(const std::string &path, uint64_t key, const Image &image)
+{
+    std::string tmpPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    std::ofstream ofile(tmpPath, std::ios::binary | std::ios::trunc);
+    if(!ofile.is_open())
+    {
+        std::cout << "Texture Cache Write Fail, Path = " << path << std::endl;
+        return;
+    }
+    TextureCacheHeader header = {TextureCacheMagic, TextureCacheVersion, key, (uint32_t)image.width, (uint32_t)image.height,
+                                 (uint32_t)image.levelCount, 0};
+    ofile.write((const char *)&header, sizeof(header));
+    ofile.write((const char *)image.pixels.data(), (std::streamsize)image.pixels.size());
+    ofile.close();
+    if(!ofile)
+    {
+        std::remove(tmpPath.c_str());
+        std::cout << "Texture Cache Write Fail, Path = " << path << std::endl;
+        return;
+    }
+    std::remove(path.c_str());
+    std::rename(tmpPath.c_str(), path.c_str());
+}
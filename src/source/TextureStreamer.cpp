@@ -0,0 +1,226 @@
+#include "TextureStreamer.h"
+#include "GLExtension.h"
+#include "GLStateCache.h"
+#include "KTXTexture.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// 占位贴图的颜色
+static const unsigned char PlaceholderPixel[4] = {128, 128, 128, 255};
+
+// 把贴图绑定到0号单元并激活0号单元
+// 贴图已绑定在0号单元时绑定被省略,活动单元可能是其他单元,修改贴图前需要激活0号单元
+static void bindForUpload(GLuint texture)
+{
+    GLStateCache::bindTexture(0, GL_TEXTURE_2D, texture);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+}
+
+// 设置重复寻址与三线性过滤
+static void setSamplerParameters()
+{
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// 构造函数,decoderCount为解码线程数量,0表示使用硬件线程数量,uploadBudget为每帧最多上传的字节数
+TextureStreamer::TextureStreamer(size_t decoderCount, GLsizeiptr uploadBudget)
+    : bIsStopping(false), pendingCount(0), pixelRing(uploadBudget)
+{
+    if(0 == decoderCount)
+    {
+        decoderCount = std::thread::hardware_concurrency();
+        if(0 == decoderCount)
+            decoderCount = 1;
+    }
+    for(size_t i = 0; i < decoderCount; i++)
+    {
+        decoders.push_back(std::thread(&TextureStreamer::run, this));
+    }
+}
+
+// 析构函数,停止并等待解码线程
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bIsStopping = true;
+    }
+    requestCondition.notify_all();
+    for(std::thread &decoder : decoders)
+    {
+        decoder.join();
+    }
+}
+
+// 解码线程函数
+void TextureStreamer::run()
+{
+    for(;;)
+    {
+        DecodeRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            requestCondition.wait(lock, [this]() { return bIsStopping || !requests.empty(); });
+            if(bIsStopping)
+                return;
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+        DecodedImage image;
+        image.texture = request.texture;
+        image.path = std::move(request.path);
+        image.bIsLoaded = TextureCache::load(image.path, request.bIsSRGB, generator, image.image);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            decoded.push_back(std::move(image));
+        }
+        decodedCondition.notify_one();
+    }
+}
+
+// 创建贴图并提交解码,返回的贴图id立即可以绑定,上传完成前为1x1的灰色
+// 颜色贴图的bIsSRGB为true,RGB通道在线性空间缩小;高光遮罩、法线等数据贴图为false,直接按存储的值缩小
+GLuint TextureStreamer::load(const std::string &path, bool bIsSRGB)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    bindForUpload(texture);
+    // 只有一级的1x1贴图已经是完整的Mipmap链
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PlaceholderPixel);
+    setSamplerParameters();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back({texture, path, bIsSRGB});
+    }
+    requestCondition.notify_one();
+    pendingCount++;
+    return texture;
+}
+
+// 从像素缓冲的偏移或内存地址上传一张贴图的Mipmap链
+// 各级在pixels之后紧密存放,RGBA8的行字节数总是4的倍数,使用默认的对齐即可
+void TextureStreamer::upload(const DecodedImage &image, const unsigned char *pixels)
+{
+    bindForUpload(image.texture);
+    int width = image.image.width;
+    int height = image.image.height;
+    for(int level = 0; level < image.image.levelCount; level++)
+    {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        pixels += (size_t)width * height * 4;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+}
+
+// 从内存映射的KTX2文件上传块压缩贴图及其Mipmap链,文件无效或不支持其格式时返回0
+// 压缩数据不需要解码,直接从映射内存同步上传
+GLuint TextureStreamer::loadCompressed(const std::string &path)
+{
+    KTXTexture file(path);
+    if(!file.isValid())
+    {
+        return 0;
+    }
+    GLenum internalFormat = GL_COMPRESSED_RG_RGTC2;
+    if(BlockCompressor::BC5 != file.getFormat())
+    {
+        if(!GLExtension::bTextureCompressionS3TC)
+            return 0;
+        internalFormat = BlockCompressor::BC1 == file.getFormat() ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    bindForUpload(texture);
+    const std::vector<KTXTexture::Level> &levels = file.getLevels();
+    for(size_t i = 0; i < levels.size(); i++)
+    {
+        const KTXTexture::Level &level = levels[i];
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, internalFormat, level.width, level.height, 0, (GLsizei)level.size, level.data);
+    }
+    // 文件中的Mipmap链可能不完整,只使用已有的级别
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+    setSamplerParameters();
+    return texture;
+}
+
+// 在帧开始时调用,按预算上传解码完成的贴图,返回本帧上传的数量
+// 单张贴图超过预算时,本帧没有上传过其他贴图才直接从内存上传
+size_t TextureStreamer::update()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while(!decoded.empty())
+        {
+            uploads.push_back(std::move(decoded.front()));
+            decoded.pop_front();
+        }
+    }
+    if(uploads.empty())
+    {
+        return 0;
+    }
+
+    pixelRing.beginFrame();
+    size_t count = 0;
+    bool bHasUploaded = false;
+    while(!uploads.empty())
+    {
+        DecodedImage &image = uploads.front();
+        if(image.bIsLoaded)
+        {
+            const std::vector<unsigned char> &pixels = image.image.pixels;
+            GLsizeiptr size = (GLsizeiptr)pixels.size();
+            RingAllocation allocation = pixelRing.allocate(size, 4);
+            if(allocation.data)
+            {
+                // 绑定像素缓冲时glTexImage2D的数据指针为缓冲中的偏移,上传由驱动异步完成
+                std::memcpy(allocation.data, pixels.data(), (size_t)size);
+                pixelRing.flush();
+                GLStateCache::bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelRing.getId());
+                upload(image, reinterpret_cast<const unsigned char *>(allocation.offset));
+            }
+            else if(!bHasUploaded && size > pixelRing.getRegionSize())
+            {
+                GLStateCache::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                upload(image, pixels.data());
+            }
+            else
+            {
+                break;
+            }
+            bHasUploaded = true;
+        }
+        else
+        {
+            std::cout << "Texture Load Fail, Path = " << image.path << std::endl;
+        }
+        uploads.pop_front();
+        pendingCount--;
+        count++;
+    }
+    // 解除像素缓冲的绑定,其他glTexImage2D调用的数据指针仍是内存地址
+    GLStateCache::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    pixelRing.endFrame();
+    return count;
+}
+
+// 等待所有贴图解码并上传完成,每次按预算上传,像素缓冲仍被GPU读取时会等待
+void TextureStreamer::finish()
+{
+    while(pendingCount > 0)
+    {
+        if(uploads.empty())
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            decodedCondition.wait(lock, [this]() { return !decoded.empty(); });
+        }
+        update();
+    }
+}
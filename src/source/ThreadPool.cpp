@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+
+// 每个线程平均分到的块数量,块比线程多时先完成的线程可以继续领取,平衡负载
+static const size_t ChunksPerThread = 4;
+
+// 构造函数,threadCount为包括调用线程在内的线程数量,0表示使用硬件线程数量
+ThreadPool::ThreadPool(size_t threadCount)
+    : task(nullptr), taskCount(0), taskChunks(0), nextChunk(0), busyWorkers(0), generation(0), bIsStopping(false)
+{
+    if(0 == threadCount)
+    {
+        threadCount = std::thread::hardware_concurrency();
+        if(0 == threadCount)
+            threadCount = 1;
+    }
+    for(size_t i = 1; i < threadCount; i++)
+    {
+        workers.push_back(std::thread(&ThreadPool::run, this));
+    }
+}
+
+// 析构函数,停止并等待工作线程
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bIsStopping = true;
+    }
+    wakeCondition.notify_all();
+    for(std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// 获取count个元素、每块至少minChunkSize个元素时切分的块数量
+size_t ThreadPool::getChunkCount(size_t count, size_t minChunkSize) const
+{
+    if(0 == count)
+        return 0;
+    if(0 == minChunkSize)
+        minChunkSize = 1;
+    size_t maxChunks = (count + minChunkSize - 1) / minChunkSize;
+    size_t chunks = workers.empty() ? 1 : getThreadCount() * ChunksPerThread;
+    return chunks < maxChunks ? chunks : maxChunks;
+}
+
+// 把[0, count)切分为getChunkCount个连续块并行处理,块按序号从小到大对应范围
+void ThreadPool::parallelFor(size_t count, size_t minChunkSize, const ChunkFunction &function)
+{
+    size_t chunks = getChunkCount(count, minChunkSize);
+    if(chunks <= 1 || workers.empty())
+    {
+        for(size_t chunk = 0; chunk < chunks; chunk++)
+        {
+            function(count * chunk / chunks, count * (chunk + 1) / chunks, chunk);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &function;
+        taskCount = count;
+        taskChunks = chunks;
+        nextChunk = 0;
+        busyWorkers = workers.size();
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    runChunks();
+
+    // 等待所有工作线程报到并完成,之后function才可以销毁
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this]() { return 0 == busyWorkers; });
+    task = nullptr;
+}
+
+// 工作线程函数
+void ThreadPool::run()
+{
+    uint64_t seenGeneration = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&]() { return bIsStopping || generation != seenGeneration; });
+            if(bIsStopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if(0 == --busyWorkers)
+            doneCondition.notify_one();
+    }
+}
+
+// 领取并处理块,直到没有剩余的块
+void ThreadPool::runChunks()
+{
+    while(true)
+    {
+        size_t chunk = nextChunk.fetch_add(1);
+        if(chunk >= taskChunks)
+            return;
+        (*task)(taskCount * chunk / taskChunks, taskCount * (chunk + 1) / taskChunks, chunk);
+    }
+}
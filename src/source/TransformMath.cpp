@@ -0,0 +1,56 @@
+#include "TransformMath.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OPENGLTUTORIAL_TRANSFORM_SSE 1
+#include <emmintrin.h>
+#endif
+
+// 计算a * b,支持SSE时一次计算一列
+void TransformMath::multiply(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &result)
+{
+#ifdef OPENGLTUTORIAL_TRANSFORM_SSE
+    // 结果的第j列为a的四列按b第j列的分量加权求和
+    __m128 a0 = _mm_loadu_ps(&a[0][0]);
+    __m128 a1 = _mm_loadu_ps(&a[1][0]);
+    __m128 a2 = _mm_loadu_ps(&a[2][0]);
+    __m128 a3 = _mm_loadu_ps(&a[3][0]);
+    for(int column = 0; column < 4; column++)
+    {
+        const float *b0 = &b[column][0];
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b0[0])), _mm_mul_ps(a1, _mm_set1_ps(b0[1]))),
+                                _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b0[2])), _mm_mul_ps(a3, _mm_set1_ps(b0[3]))));
+        _mm_storeu_ps(&result[column][0], sum);
+    }
+#else
+    result = a * b;
+#endif
+}
+
+// 计算法线矩阵,左上3x3的逆转置用叉积求伴随矩阵得到,不求完整的4x4逆
+// 列为a、b、c的矩阵,其逆转置的列为(b×c, c×a, a×b) / det
+glm::mat3 TransformMath::normalMatrix(const glm::mat4 &model)
+{
+    glm::vec3 a(model[0]);
+    glm::vec3 b(model[1]);
+    glm::vec3 c(model[2]);
+    glm::vec3 bc = glm::cross(b, c);
+    float inverseDeterminant = 1.0f / glm::dot(a, bc);
+    return glm::mat3(bc * inverseDeterminant, glm::cross(c, a) * inverseDeterminant, glm::cross(a, b) * inverseDeterminant);
+}
+
+// 为indices中的count个物体计算实例变换,normalMatrices为预先计算的法线矩阵
+void TransformMath::computeInstances(const glm::mat4 &viewProjection, const glm::mat4 *models, const glm::mat3 *normalMatrices,
+                                     const uint32_t *indices, size_t count, InstanceTransform *instances)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        uint32_t index = indices[i];
+        InstanceTransform &instance = instances[i];
+        multiply(viewProjection, models[index], instance.mvp);
+        instance.model = models[index];
+        const glm::mat3 &normal = normalMatrices[index];
+        instance.normalMatrix[0] = glm::vec4(normal[0], 0.0f);
+        instance.normalMatrix[1] = glm::vec4(normal[1], 0.0f);
+        instance.normalMatrix[2] = glm::vec4(normal[2], 0.0f);
+    }
+}
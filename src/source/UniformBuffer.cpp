@@ -0,0 +1,77 @@
+#include "UniformBuffer.h"
+#include "UniformBlocks.h"
+#include "GLStateCache.h"
+#include <cstring>
+
+// 共享块的名字、绑定点及镜像结构大小
+static const struct
+{
+    const char *name;
+    GLuint binding;
+    GLsizeiptr size;
+} SharedUniformBlocks[] = {
+    {"FrameData", UniformBlockBinding::Frame, sizeof(FrameData)},
+    {"LightData", UniformBlockBinding::Light, sizeof(LightData)},
+    {"ClusterData", UniformBlockBinding::Cluster, sizeof(ClusterData)},
+    {"ShadowData", UniformBlockBinding::Shadow, sizeof(ShadowData)},
+};
+
+// 构造函数,创建缓冲并绑定到绑定点
+UniformBuffer::UniformBuffer(GLuint binding, GLsizeiptr size) : id(0), binding(binding), size(size), shadow((size_t)size, 0)
+{
+    // 用零初始化,保证影子副本与缓冲内容一致
+    glGenBuffers(1, &id);
+    GLStateCache::bindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferData(GL_UNIFORM_BUFFER, size, shadow.data(), GL_DYNAMIC_DRAW);
+    bind();
+}
+
+// 更新缓冲数据,只上传与上一次内容不同的字节范围,完全相同时不调用GL
+void UniformBuffer::update(const void *data, GLsizeiptr length, GLintptr offset)
+{
+    if(offset < 0 || length <= 0 || offset + length > size)
+    {
+        return;
+    }
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    unsigned char *target = shadow.data() + offset;
+
+    // 找出第一个与最后一个不同的字节
+    GLsizeiptr first = 0;
+    while(first < length && bytes[first] == target[first])
+        first++;
+    if(first == length)
+    {
+        GLStateCache::countUniformUpload(false);
+        return;
+    }
+    GLsizeiptr last = length - 1;
+    while(bytes[last] == target[last])
+        last--;
+
+    std::memcpy(target + first, bytes + first, (size_t)(last - first + 1));
+    GLStateCache::bindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset + first, last - first + 1, bytes + first);
+    GLStateCache::countUniformUpload(true);
+}
+
+// 重新绑定到绑定点
+void UniformBuffer::bind()
+{
+    GLStateCache::bindBufferBase(GL_UNIFORM_BUFFER, binding, id);
+}
+
+// 根据块名查找绑定点及C++端结构大小,不是共享块时返回false
+bool UniformBuffer::findBlock(const std::string &name, GLuint &binding, GLsizeiptr &size)
+{
+    for(const auto &block : SharedUniformBlocks)
+    {
+        if(name == block.name)
+        {
+            binding = block.binding;
+            size = block.size;
+            return true;
+        }
+    }
+    return false;
+}
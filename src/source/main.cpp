@@ -1,13 +1,45 @@
 #include <iostream>
+#include "BVH.h"
+#include "Benchmark.h"
 #include "Camera.h"
+#include "ClusteredLighting.h"
 #include "Shader.h"
+#include "DeferredRenderer.h"
+#include "FrustumCuller.h"
+#include "GLExtension.h"
+#include "IndirectRenderer.h"
+#include "InstanceBuffer.h"
+#include "Mesh.h"
+#include "MeshBuilder.h"
+#include "PointLightList.h"
+#include "RenderQueue.h"
+#include "RingBuffer.h"
+#include "GLStateCache.h"
+#include "ShaderLibrary.h"
+#include "ShaderPermutation.h"
+#include "ShaderSource.h"
+#include "ShaderWatcher.h"
+#include "ShadowMaps.h"
+#include "UniformBlocks.h"
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+#include "TransformMath.h"
+#include "UniformBuffer.h"
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "stb_image.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <random>
 #include <sstream>
+#include <vector>
 
 // 窗口标题
 const char *title = "PhongLight";
@@ -27,6 +59,27 @@ Camera camera;
 // 光物体位置
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
+// 是否使用自发光贴图
+bool bUseEmission = false;
+// 是否使用平行光
+bool bUseDirectionLight = false;
+// 是否使用实例化绘制箱子
+bool bUseInstancing = true;
+// 是否剔除视锥体外的箱子
+bool bUseCulling = true;
+// 是否在GPU上剔除并通过多重间接绘制提交箱子,只在OpenGL 4.3以上可用
+bool bUseIndirect = true;
+// 是否使用延迟渲染,几何缓冲之后按光源体积累积所有点光源
+bool bUseDeferred = false;
+// 是否使用分簇前向渲染,每个片段只计算所在簇的点光源,延迟渲染开启时不使用
+bool bUseClustered = false;
+// 是否绘制阴影,阴影贴图缓存到光源或物体改变时才重绘
+bool bUseShadows = false;
+// 是否让使用给定位置的箱子旋转,这些箱子作为动态物体投射阴影
+bool bUseAnimation = false;
+// 是否在下一帧拾取屏幕中心的箱子
+bool bIsPickRequested = false;
+
 // 窗口大小改变回调函数
 void frameBufferSizeCallback(GLFWwindow *window, int width, int height);
 // 鼠标位置改变回调函数
@@ -35,23 +88,63 @@ void cursorPosCallback(GLFWwindow *window, double x, double y);
 void scrollCallback(GLFWwindow *window, double xoffset, double yoffset);
 // 键盘输入回调函数
 void keyboardInput(GLFWwindow *window);
-// 加载贴图
-GLuint loadTexture(const std::string &path);
+// 按键事件回调函数
+void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
+// 生成箱子模型矩阵,前面的箱子使用给定位置,其余的在与数量相称的范围内随机摆放,矩阵在线程池中并行构建
+std::vector<glm::mat4> makeBoxModels(const glm::vec3 *positions, size_t positionCount, size_t count, ThreadPool &threadPool);
+// 生成点光源,第一个为给定的光源,其余的在包围盒内随机摆放并使用随机颜色
+void makePointLights(const PointLightData &firstLight, size_t count, const glm::vec3 &minimum, const glm::vec3 &maximum, PointLightList &lights);
 
 // 获取OpenGL信息
 void getDeviceGLInfo();
 
-int main()
+int main(int argc, char **argv)
 {
+    // 命令行参数: --boxes N 设置箱子数量, --benchmark 测量10到1M个箱子的绘制耗时后退出
+    // --gl33 只使用OpenGL 3.3,用于测试不支持间接绘制时的路径
+    // --deferred 使用延迟渲染, --clustered 使用分簇前向渲染, --lights N 设置这两种方式的点光源数量
+    // --shadows 绘制阴影, --animate 让动态箱子旋转, --uncompressed 不使用构建时压缩的贴图
+    size_t boxCount = 10;
+    size_t lightCount = 1;
+    bool bIsBenchmark = false;
+    bool bUseCompressedTextures = true;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if(argument == "--benchmark")
+            bIsBenchmark = true;
+        else if(argument == "--gl33")
+            GLExtension::bIsLimitedTo33 = true;
+        else if(argument == "--deferred")
+            bUseDeferred = true;
+        else if(argument == "--clustered")
+            bUseClustered = true;
+        else if(argument == "--shadows")
+            bUseShadows = true;
+        else if(argument == "--animate")
+            bUseAnimation = true;
+        else if(argument == "--uncompressed")
+            bUseCompressedTextures = false;
+        else if(argument == "--boxes" && i + 1 < argc)
+            boxCount = (size_t)std::strtoul(argv[++i], nullptr, 10);
+        else if(argument == "--lights" && i + 1 < argc)
+            lightCount = (size_t)std::strtoul(argv[++i], nullptr, 10);
+    }
+
     // 初始化GLFW
     glfwInit();
-    // 设置GLFW窗口上下文的OpenGL版本
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    // 设置GLFW窗口上下文的OpenGL版本,优先使用4.3以便在GPU上剔除,不支持时回退到3.3
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, GLExtension::bIsLimitedTo33 ? 3 : 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     // 设置GLFW窗口的OpenGL渲染模式
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     // 创建GLFW窗口
     window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    if(!window && !GLExtension::bIsLimitedTo33)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    }
     // 判断是否创建成功
     if(!window)
     {
@@ -69,6 +162,9 @@ int main()
         return EXIT_FAILURE;
     }
 
+    // 加载OpenGL 3.3以上的扩展函数
+    GLExtension::load((GLADloadproc)glfwGetProcAddress);
+
     // 获取OpenGL版本及设备信息
     getDeviceGLInfo();
 
@@ -81,9 +177,11 @@ int main()
     glfwSetCursorPosCallback(window, cursorPosCallback);
     // 设置鼠标滚轮回调函数
     glfwSetScrollCallback(window, scrollCallback);
+    // 设置按键事件回调函数
+    glfwSetKeyCallback(window, keyCallback);
 
     // 开启深度测试
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::setEnabled(GL_DEPTH_TEST, true);
 
     // 立方体顶点数据
     GLfloat cubeVertices[] = {
@@ -144,56 +242,566 @@ int main()
         glm::vec3(-1.3f,  1.0f, -1.5f)
     };
 
-    // 创建两个Shader
-    Shader lightShader("../shader/PhongLight/04/Light.vs.glsl","../shader/PhongLight/04/Light.fs.glsl");
-    Shader boxShader("../shader/PhongLight/04/Box.vs.glsl","../shader/PhongLight/04/Box.fs.glsl");
-
-    // 立方体物体VBO
-    GLuint cubeVBO;
-    glGenBuffers(1, &cubeVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-
-    // 光源物体VAO
-    GLuint lightVAO;
-    glGenVertexArrays(1, &lightVAO);
-    glBindVertexArray(lightVAO);
-    // 绑定立方体物体VBO
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    // VAO解释VBO中的数据
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8*sizeof(GL_FLOAT), (void*)0);
-    // 启用VAO中的0号属性位置
-    glEnableVertexAttribArray(0);
-
-    // 箱子立方体VAO
-    GLuint objVAO;
-    glGenVertexArrays(1, &objVAO);
-    glBindVertexArray(objVAO);
-    // 绑定立方体物体VBO
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    // VAO解释VBO中的顶点数据
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8*sizeof(GL_FLOAT), (void*)0);
-    // 启用VAO中的0号顶点属性位置
-    glEnableVertexAttribArray(0);
-    // VAO解释VBO中的法线数据
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8*sizeof(GL_FLOAT), (void*)(3*sizeof(GL_FLOAT)));
-    // 启用VAO中的1号法线属性位置
-    glEnableVertexAttribArray(1);
-    // VAO解释VBO中的UV数据
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8*sizeof(GL_FLOAT), (void*)(6*sizeof(GL_FLOAT)));
-    // 启用VAO中的2号UV属性位置
-    glEnableVertexAttribArray(2);
+    // 着色器默认使用构建时嵌入的源码,设置环境变量OPENGLTUTORIAL_SHADER_DIR后从该目录加载,用于开发时修改与热重载
+    const char *shaderDirectory = std::getenv("OPENGLTUTORIAL_SHADER_DIR");
+    if(shaderDirectory)
+    {
+        ShaderSource::setOverrideDirectory(shaderDirectory);
+    }
+
+    // 着色器库,启动时的程序先全部提交编译链接,场景创建完后统一等待
+    ShaderLibrary shaderLibrary;
+    Shader *lightShader = shaderLibrary.add("PhongLight/04/Light.vs.glsl","PhongLight/04/Light.fs.glsl");
+
+    // 着色器热重载,修改着色器文件后在下一帧开始时替换程序,只在从磁盘加载时启动
+    ShaderWatcher shaderWatcher;
+    shaderWatcher.watch(lightShader);
+    if(shaderDirectory)
+    {
+        shaderWatcher.start();
+    }
+
+    // 箱子着色器排列,切换特性时才编译对应的变体,新变体自动加入热重载
+    ShaderPermutation boxShaders("PhongLight/Phong.vs.glsl","PhongLight/Phong.fs.glsl");
+    boxShaders.setWatcher(&shaderWatcher);
+    const uint32_t emissionKeyword = boxShaders.keywordMask({"EMISSION_MAP"});
+    const uint32_t directionLightKeyword = boxShaders.keywordMask({"DIRECTION_LIGHT"});
+    const uint32_t instancedKeyword = boxShaders.keywordMask({"INSTANCED"});
+    const uint32_t indirectKeyword = boxShaders.keywordMask({"INDIRECT"});
+    const uint32_t gBufferKeyword = boxShaders.keywordMask({"GBUFFER"});
+    const uint32_t clusteredKeyword = boxShaders.keywordMask({"CLUSTERED"});
+    const uint32_t shadowKeyword = boxShaders.keywordMask({"SHADOWS"});
+
+    // GPU驱动的箱子绘制,不支持时使用实例化或逐个绘制
+    std::unique_ptr<IndirectRenderer> indirectRenderer;
+    if(IndirectRenderer::isSupported())
+        indirectRenderer.reset(new IndirectRenderer());
+    bUseIndirect = indirectRenderer != nullptr;
+    uint32_t boxKeywords = boxShaders.keywordMask({"MATERIAL_MAPS"}) | (bUseIndirect ? indirectKeyword : instancedKeyword)
+                           | (bUseDeferred ? gBufferKeyword : (bUseClustered ? clusteredKeyword : 0))
+                           | (bUseShadows && !bUseDeferred ? shadowKeyword : 0);
+
+    // 立方体网格,合并重复顶点后按顶点缓存优化,用索引绘制
+    // 光源物体与箱子共用默认VAO,光源着色器只读取位置属性
+    Mesh cubeMesh(MeshBuilder::build("cube", cubeVertices, sizeof(cubeVertices) / (8 * sizeof(GLfloat)), 8),
+                  {{0, 3, 0}, {1, 3, 3}, {2, 2, 6}});
+
+    // 线程池,用于构建变换、剔除与并行准备绘制包,每帧先并行准备再由GL线程串行提交
+    ThreadPool threadPool;
+    ThreadPool *preparePool = &threadPool;
+    // 准备阶段每块至少处理的物体数量
+    const size_t PrepareChunkSize = 4096;
+
+    // 每帧动态数据的环形缓冲,三个帧区域,支持时持久映射
+    RingBuffer frameRing(1 << 20);
+    // 箱子模型矩阵与法线矩阵,箱子不动,法线矩阵只在创建时计算一次
+    // 实例化绘制时每帧把可见箱子的实例变换写入环形缓冲
+    std::vector<glm::mat4> boxModels;
+    std::vector<glm::mat3> boxNormalMatrices;
+    InstanceBuffer boxInstances(frameRing);
+    // 箱子包围球,边长为1的立方体只有旋转,半径为半对角线
+    SphereBounds boxBounds;
+    // 箱子轴对齐包围盒及其层次结构,用于剔除与拾取
+    BoxBounds boxAABBs;
+    BVH boxBVH;
+    // 间接绘制的物体数据,箱子只有一个网格与一个材质
+    std::vector<IndirectObjectData> boxObjects;
+    if(indirectRenderer)
+    {
+        IndirectMeshRange cubeRange = {(GLuint)cubeMesh.getIndexCount(), 0, 0, 0};
+        indirectRenderer->setMeshes(&cubeRange, 1);
+    }
+    // 箱子包围球,xyz为球心,w为半径,阴影贴图按包围球判断物体是否在光源范围内
+    std::vector<glm::vec4> boxSpheres;
+    // 动态箱子为前面使用给定位置的箱子,开启动画时绕自身的y轴旋转,其余箱子不动
+    size_t dynamicBoxCount = 0;
+    std::vector<glm::mat4> dynamicBaseModels;
+    float animationTime = 0.0f;
+    // 阴影贴图,静态箱子与动态箱子分两层缓存
+    ShadowMaps shadowMaps(2048, 512, cubeMesh);
+    shadowMaps.setWatcher(&shaderWatcher);
+
+    // 由模型矩阵更新一个箱子的法线矩阵、包围体与间接绘制数据,只写该箱子的下标,可以并行
+    auto updateBox = [&](size_t i)
+    {
+        // 旋转后立方体的轴对齐包围盒,每个轴的半长为旋转矩阵对应行的绝对值之和的一半
+        const glm::mat4 &model = boxModels[i];
+        glm::vec3 center(model[3]);
+        glm::vec3 extent = 0.5f * glm::vec3(std::fabs(model[0][0]) + std::fabs(model[1][0]) + std::fabs(model[2][0]),
+                                            std::fabs(model[0][1]) + std::fabs(model[1][1]) + std::fabs(model[2][1]),
+                                            std::fabs(model[0][2]) + std::fabs(model[1][2]) + std::fabs(model[2][2]));
+        boxNormalMatrices[i] = TransformMath::normalMatrix(model);
+        boxBounds.set(i, center, 0.5f * std::sqrt(3.0f));
+        boxAABBs.set(i, center - extent, center + extent);
+        boxSpheres[i] = glm::vec4(center, 0.5f * std::sqrt(3.0f));
+        if(indirectRenderer)
+        {
+            IndirectObjectData &object = boxObjects[i];
+            object.model = model;
+            for(int column = 0; column < 3; column++)
+                object.normalMatrix[column] = glm::vec4(boxNormalMatrices[i][column], 0.0f);
+            object.boundingSphere = boxSpheres[i];
+            object.meshIndex = 0;
+            object.materialIndex = 0;
+        }
+    };
+    auto setBoxCount = [&](size_t count)
+    {
+        boxModels = makeBoxModels(cubePositions, sizeof(cubePositions) / sizeof(cubePositions[0]), count, *preparePool);
+        boxNormalMatrices.resize(boxModels.size());
+        boxBounds.resize(boxModels.size());
+        boxAABBs.resize(boxModels.size());
+        boxSpheres.resize(boxModels.size());
+        boxObjects.resize(indirectRenderer ? boxModels.size() : 0);
+        preparePool->parallelFor(boxModels.size(), PrepareChunkSize, [&](size_t begin, size_t end, size_t)
+        {
+            for(size_t i = begin; i < end; i++)
+                updateBox(i);
+        });
+        boxBVH.build(boxAABBs);
+        if(indirectRenderer)
+            indirectRenderer->setObjects(boxObjects.data(), (GLuint)boxObjects.size(), 1);
+        // 不剔除时所有箱子的实例变换都要放进一帧
+        frameRing.reserve((GLsizeiptr)boxModels.size() * sizeof(InstanceTransform));
+        dynamicBoxCount = std::min(boxModels.size(), sizeof(cubePositions) / sizeof(cubePositions[0]));
+        dynamicBaseModels.assign(boxModels.begin(), boxModels.begin() + dynamicBoxCount);
+        shadowMaps.setStaticCasters(boxModels.data() + dynamicBoxCount, boxSpheres.data() + dynamicBoxCount, boxModels.size() - dynamicBoxCount);
+        shadowMaps.setDynamicCasters(boxModels.data(), boxSpheres.data(), dynamicBoxCount);
+    };
+    setBoxCount(boxCount);
+
+    // 旋转动态箱子,time为动画时间,以秒为单位,同时更新层次结构、间接绘制数据与阴影的动态物体
+    auto animateBoxes = [&](float time)
+    {
+        for(size_t i = 0; i < dynamicBoxCount; i++)
+        {
+            boxModels[i] = glm::rotate(dynamicBaseModels[i], glm::radians(45.0f) * time, glm::vec3(0.0f, 1.0f, 0.0f));
+            updateBox(i);
+            glm::vec3 center(boxAABBs.centerX[i], boxAABBs.centerY[i], boxAABBs.centerZ[i]);
+            glm::vec3 extent(boxAABBs.extentX[i], boxAABBs.extentY[i], boxAABBs.extentZ[i]);
+            boxBVH.update((uint32_t)i, center - extent, center + extent);
+        }
+        if(indirectRenderer)
+            indirectRenderer->updateObjects(0, boxObjects.data(), (GLuint)dynamicBoxCount);
+        shadowMaps.setDynamicCasters(boxModels.data(), boxSpheres.data(), dynamicBoxCount);
+    };
 
+    // 箱子实例化VAO,顶点属性与默认VAO相同,另外从实例缓冲读取模型矩阵
+    GLuint objInstancedVAO = cubeMesh.createVertexArray();
+    boxInstances.attach(objInstancedVAO, 3);
+    // 箱子间接绘制VAO,另外从物体下标缓冲读取物体下标
+    GLuint objIndirectVAO = 0;
+    if(indirectRenderer)
+    {
+        objIndirectVAO = cubeMesh.createVertexArray();
+        indirectRenderer->attach(3);
+    }
+
+    // 贴图流式加载,解码线程数量与硬件线程相同,每帧最多上传4MB
+    const GLsizeiptr TextureUploadBudget = 4 << 20;
+    TextureStreamer textureStreamer(0, TextureUploadBudget);
+    // 优先使用构建时压缩到构建目录texture目录的KTX2贴图,文件不存在或不支持其格式时流式加载原图
+    // bIsSRGB表示是否为颜色贴图,决定原图的Mipmap在哪个空间缩小
+    auto loadBoxTexture = [&](const std::string &name, const std::string &extension, bool bIsSRGB)
+    {
+        GLuint texture = bUseCompressedTextures ? TextureStreamer::loadCompressed("texture/" + name + ".ktx2") : 0;
+        return texture ? texture : textureStreamer.load("../texture/" + name + extension, bIsSRGB);
+    };
     // 创建箱子diffuse贴图
-    GLuint boxDiffuseTexId = loadTexture("../texture/box_diffuse.png");
-    // 创建箱子的specular贴图
-    GLuint boxSpecularTexId = loadTexture("../texture/box_specular.png");
+    GLuint boxDiffuseTexId = loadBoxTexture("box_diffuse", ".png", true);
+    // 创建箱子的specular贴图,高光遮罩是线性数据
+    GLuint boxSpecularTexId = loadBoxTexture("box_specular", ".png", false);
+    // 创建箱子的emission贴图
+    GLuint boxEmissionTexId = loadBoxTexture("box_emission", ".jpg", true);
+
+    // 分簇光源列表的纹理缓冲从材质贴图之后的纹理单元开始,阴影贴图在其后
+    const GLuint ClusterTextureUnit = 3;
+    const GLuint ShadowTextureUnit = ClusterTextureUnit + ClusteredLighting::TextureCount;
+
+    // 选择箱子着色器变体,获取Uniform句柄并设置纹理单元,渲染循环中不再做字符串查找
+    Shader *boxShader = nullptr;
+    UniformHandle boxMVPHandle;
+    UniformHandle boxModelHandle;
+    UniformHandle boxNormalMatrixHandle;
+    UniformHandle materialShininessHandle;
+    auto selectBoxShader = [&](uint32_t keywords)
+    {
+        boxShader = boxShaders.get(keywords);
+        boxMVPHandle = boxShader->uniform("mvp");
+        boxModelHandle = boxShader->uniform("model");
+        boxNormalMatrixHandle = boxShader->uniform("normalMatrix");
+        materialShininessHandle = boxShader->uniform("material.shininess");
+        boxShader->set(boxShader->uniform("material.diffuse"), 0);
+        boxShader->set(boxShader->uniform("material.specular"), 1);
+        boxShader->set(boxShader->uniform("material.emission"), 2);
+        boxShader->set(boxShader->uniform("clusterGrid"), (int)ClusterTextureUnit);
+        boxShader->set(boxShader->uniform("clusterLightIndices"), (int)ClusterTextureUnit + 1);
+        boxShader->set(boxShader->uniform("clusterLights"), (int)ClusterTextureUnit + 2);
+        ShadowMaps::setSamplers(boxShader, ShadowTextureUnit);
+    };
+    // 按当前开关选择箱子着色器变体,开关改变后才重新选择
+    auto updateBoxShader = [&]()
+    {
+        uint32_t keywords = boxKeywords & ~(emissionKeyword | directionLightKeyword | instancedKeyword | indirectKeyword | gBufferKeyword
+                                            | clusteredKeyword | shadowKeyword);
+        if(bUseEmission)
+            keywords |= emissionKeyword;
+        if(bUseDirectionLight)
+            keywords |= directionLightKeyword;
+        if(bUseIndirect)
+            keywords |= indirectKeyword;
+        else if(bUseInstancing)
+            keywords |= instancedKeyword;
+        if(bUseDeferred)
+            keywords |= gBufferKeyword;
+        else if(bUseClustered)
+            keywords |= clusteredKeyword;
+        if(bUseShadows && !bUseDeferred)
+            keywords |= shadowKeyword;
+        if(keywords != boxKeywords)
+        {
+            boxKeywords = keywords;
+            selectBoxShader(boxKeywords);
+        }
+    };
+
+    // 每帧数据与光源数据的uniform缓冲,所有程序共享,每帧只上传一次
+    UniformBuffer frameUniformBuffer(UniformBlockBinding::Frame, sizeof(FrameData));
+    UniformBuffer lightUniformBuffer(UniformBlockBinding::Light, sizeof(LightData));
+    FrameData frameData;
+    LightData lightData;
+
+    // 点光源,环境光一般较弱,漫反射光源一般为光实际的颜色,镜面光一般设置为最大(白色)
+    // 前向渲染只使用第一个,延迟渲染使用全部
+    PointLightData primaryLight;
+    primaryLight.position = lightPos;
+    primaryLight.constant = 1.0f;
+    primaryLight.linear = 0.7f;
+    primaryLight.quadratic = 1.8f;
+    primaryLight.ambient = glm::vec3(0.2f);
+    primaryLight.diffuse = glm::vec3(0.8f);
+    primaryLight.specular = glm::vec3(1.0f);
+    PointLightList pointLights;
+    DeferredRenderer deferredRenderer(width, height);
+    deferredRenderer.setWatcher(&shaderWatcher);
+    deferredRenderer.setShadowTextureUnit(ShadowTextureUnit);
+    // 分簇前向渲染,光源在准备阶段的线程池中分配到簇
+    ClusteredLighting clusteredLighting(preparePool);
+    // 其余光源随机摆放在箱子所在的范围内
+    auto setLightCount = [&](size_t count)
+    {
+        glm::vec3 minimum(FLT_MAX);
+        glm::vec3 maximum(-FLT_MAX);
+        for(size_t i = 0; i < boxAABBs.size(); i++)
+        {
+            glm::vec3 center(boxAABBs.centerX[i], boxAABBs.centerY[i], boxAABBs.centerZ[i]);
+            minimum = glm::min(minimum, center);
+            maximum = glm::max(maximum, center);
+        }
+        makePointLights(primaryLight, count, minimum, maximum, pointLights);
+        deferredRenderer.setLights(pointLights);
+        clusteredLighting.setLights(pointLights);
+    };
+    setLightCount(lightCount);
+
+    // 启动时已知的变体与光源程序一起在着色器库中等待,驱动并行编译,之后切换特性时才编译其余变体
+    boxShaders.prebuild({boxKeywords}, shaderLibrary);
+    shadowMaps.prebuildShaders(shaderLibrary);
+    deferredRenderer.prebuildShaders(shaderLibrary);
+    shaderLibrary.build();
+    selectBoxShader(boxKeywords);
+
+    // 获取光源物体着色器Uniform句柄
+    UniformHandle lightMVPHandle = lightShader->uniform("mvp");
+
+    // 渲染队列,绘制包的数据为箱子下标,光源与实例化绘制使用保留值
+    const uint32_t LightMaterial = 0;
+    const uint32_t BoxMaterial = 1;
+    const uint32_t LightPacket = 0xFFFFFFFFu;
+    const uint32_t InstancedBoxPacket = 0xFFFFFFFEu;
+    const uint32_t IndirectBoxPacket = 0xFFFFFFFDu;
+    const float farPlane = 100.0f;
+    // 级联阴影覆盖的距离
+    const float shadowDistance = 40.0f;
+    RenderQueue renderQueue;
+    // 准备阶段每块一个命令列表,提交前按块的顺序合并,结果与线程数量无关
+    std::vector<std::unique_ptr<RenderQueue>> commandLists;
+    // 可见箱子下标
+    std::vector<uint32_t> visibleBoxes;
+    // 逐个绘制时可见箱子的模型-视图-裁剪矩阵,与visibleBoxes一一对应
+    std::vector<glm::mat4> visibleMVPs;
+
+    // 通过层次结构剔除视锥体外的箱子,实例化绘制时各线程把可见箱子的实例变换直接写入环形缓冲
+    // 间接绘制时在GPU上剔除,不剔除时使用包含整个场景的视锥体
+    auto cullBoxes = [&](const glm::mat4 &viewProjection)
+    {
+        if(bUseIndirect)
+        {
+            Frustum frustum = Frustum::fromMatrix(viewProjection);
+            if(!bUseCulling)
+            {
+                for(glm::vec4 &plane : frustum.planes)
+                    plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            }
+            indirectRenderer->cull(frustum);
+            return;
+        }
+        if(bUseCulling)
+        {
+            boxBVH.cullFrustum(Frustum::fromMatrix(viewProjection), visibleBoxes);
+        }
+        else
+        {
+            visibleBoxes.resize(boxModels.size());
+            std::iota(visibleBoxes.begin(), visibleBoxes.end(), 0u);
+        }
+        if(bUseInstancing)
+        {
+            InstanceTransform *instances = boxInstances.map((GLsizei)visibleBoxes.size());
+            if(instances)
+            {
+                preparePool->parallelFor(visibleBoxes.size(), PrepareChunkSize, [&](size_t begin, size_t end, size_t)
+                {
+                    TransformMath::computeInstances(viewProjection, boxModels.data(), boxNormalMatrices.data(),
+                                                    visibleBoxes.data() + begin, end - begin, instances + begin);
+                });
+            }
+            boxInstances.unmap();
+        }
+    };
+    glm::mat4 lightModel = glm::scale(glm::translate(glm::mat4(1.0f), lightPos), glm::vec3(0.2));
+
+    // 准备阶段,各线程为一块可见箱子计算模型-视图-裁剪矩阵并生成绘制包,写入该块的命令列表,返回使用的块数量
+    // 绘制包的数据为可见列表中的下标,深度为观察空间中到相机的距离除以远平面
+    auto prepareBoxPackets = [&](const glm::mat4 &view, const glm::mat4 &viewProjection)
+    {
+        size_t chunks = preparePool->getChunkCount(visibleBoxes.size(), PrepareChunkSize);
+        while(commandLists.size() < chunks)
+            commandLists.emplace_back(new RenderQueue());
+        visibleMVPs.resize(visibleBoxes.size());
+        uint32_t boxProgram = boxShader->getId();
+        GLuint boxVertexArray = cubeMesh.getVertexArray();
+        // 只需要观察空间的z,取视图矩阵的第三行
+        glm::vec4 viewZ(view[0][2], view[1][2], view[2][2], view[3][2]);
+        preparePool->parallelFor(visibleBoxes.size(), PrepareChunkSize, [&](size_t begin, size_t end, size_t chunk)
+        {
+            RenderQueue &commandList = *commandLists[chunk];
+            commandList.clear();
+            for(size_t i = begin; i < end; i++)
+            {
+                uint32_t index = visibleBoxes[i];
+                TransformMath::multiply(viewProjection, boxModels[index], visibleMVPs[i]);
+                float depth = -glm::dot(viewZ, boxModels[index][3]) / farPlane;
+                commandList.push(RenderQueue::makeKey(RenderQueue::Opaque, boxProgram, BoxMaterial, boxVertexArray, depth), (uint32_t)i);
+            }
+        });
+        return chunks;
+    };
+
+    // 收集本帧的绘制包并排序,逐个绘制时先并行准备命令列表,再按块的顺序合并
+    auto fillRenderQueue = [&](const glm::mat4 &view, const glm::mat4 &viewProjection)
+    {
+        renderQueue.clear();
+        // 延迟渲染时光源物体在光照阶段之后前向绘制
+        if(!bUseDeferred)
+        {
+            float lightDepth = -(view * lightModel[3]).z / farPlane;
+            renderQueue.push(RenderQueue::makeKey(RenderQueue::Opaque, lightShader->getId(), LightMaterial, cubeMesh.getVertexArray(), lightDepth), LightPacket);
+        }
+        if(bUseIndirect)
+        {
+            if(indirectRenderer->getObjectCount() > 0)
+                renderQueue.push(RenderQueue::makeKey(RenderQueue::Opaque, boxShader->getId(), BoxMaterial, objIndirectVAO, 0.0f), IndirectBoxPacket);
+        }
+        else if(bUseInstancing)
+        {
+            if(boxInstances.getCount() > 0)
+                renderQueue.push(RenderQueue::makeKey(RenderQueue::Opaque, boxShader->getId(), BoxMaterial, objInstancedVAO, 0.0f), InstancedBoxPacket);
+        }
+        else
+        {
+            size_t chunks = prepareBoxPackets(view, viewProjection);
+            for(size_t chunk = 0; chunk < chunks; chunk++)
+                renderQueue.append(*commandLists[chunk]);
+        }
+        renderQueue.sort();
+    };
+
+    // 绘制一帧场景
+    auto renderScene = [&]()
+    {
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+        // 视图矩阵
+        glm::mat4 view = camera.getViewMatrix();
+        // 裁剪矩阵
+        glm::mat4 projection = glm::perspective(glm::radians(camera.getCameraFOV()), (float)width/(float)height, 0.1f, farPlane);
+
+        // 上传光源数据,光源分解为3个分量
+        lightData.light = primaryLight;
+        lightData.directionLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+        lightData.directionLight.ambient = glm::vec3(0.2f);
+        lightData.directionLight.diffuse = glm::vec3(0.5f);
+        lightData.directionLight.specular = glm::vec3(1.0f);
+        lightUniformBuffer.update(lightData);
+
+        // 阴影贴图只重绘失效且本帧用到的部分,点光源在不只使用平行光时用到,绘制过后恢复窗口的视口
+        if(bUseShadows)
+        {
+            shadowMaps.setDirectionLight(lightData.directionLight.direction);
+            shadowMaps.setPointLight(lightData.light);
+            bool bUsePointLight = !bUseDirectionLight || bUseDeferred || bUseClustered;
+            if(shadowMaps.update(view, glm::radians(camera.getCameraFOV()), (float)width/(float)height, 0.1f, shadowDistance,
+                                 bUseDirectionLight, bUsePointLight))
+                glViewport(0, 0, framebufferWidth, framebufferHeight);
+            shadowMaps.bind(ShadowTextureUnit);
+        }
+
+        if(bUseDeferred)
+        {
+            // 几何缓冲跟随窗口大小,先绑定并清除几何缓冲
+            deferredRenderer.resize(framebufferWidth, framebufferHeight);
+            deferredRenderer.beginGeometryPass();
+        }
+        else
+        {
+            // 设置颜色缓冲区清除颜色
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            // 清除颜色缓冲区与深度缓冲区
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+        // 切换到环形缓冲的下一个帧区域
+        frameRing.beginFrame();
+
+        // 上传每帧数据:视图矩阵、裁剪矩阵、相机位置
+        frameData.view = view;
+        frameData.projection = projection;
+        TransformMath::multiply(projection, view, frameData.viewProjection);
+        frameData.cameraPosition = camera.getCameraPosition();
+        frameUniformBuffer.update(frameData);
+
+        // 分簇前向渲染每帧按相机把光源分配到簇
+        bool bIsClustered = bUseClustered && !bUseDeferred;
+        if(bIsClustered)
+        {
+            clusteredLighting.assign(pointLights, view, glm::radians(camera.getCameraFOV()), (float)width/(float)height, 0.1f, farPlane);
+            clusteredLighting.upload(framebufferWidth, framebufferHeight);
+        }
+
+        // 剔除后收集绘制包,按键的顺序提交,材质改变时切换程序并设置材质,程序与纹理的重复绑定由GLStateCache跳过
+        const glm::mat4 &viewProjection = frameData.viewProjection;
+        cullBoxes(viewProjection);
+        fillRenderQueue(view, viewProjection);
+        uint32_t currentMaterial = 0xFFFFFFFFu;
+        for(size_t i = 0; i < renderQueue.size(); i++)
+        {
+            const RenderPacket &packet = renderQueue[i];
+            uint32_t material = RenderQueue::getMaterial(packet.key);
+            if(material != currentMaterial)
+            {
+                currentMaterial = material;
+                if(LightMaterial == material)
+                {
+                    lightShader->use();
+                }
+                else
+                {
+                    boxShader->use();
+                    // 材质属性由本身的材质特点决定,值未改变时不会重复上传
+                    boxShader->set(materialShininessHandle, 64.0f);
+                    GLStateCache::bindTexture(0, GL_TEXTURE_2D, boxDiffuseTexId);
+                    GLStateCache::bindTexture(1, GL_TEXTURE_2D, boxSpecularTexId);
+                    GLStateCache::bindTexture(2, GL_TEXTURE_2D, boxEmissionTexId);
+                    if(bIsClustered)
+                        clusteredLighting.bind(ClusterTextureUnit);
+                }
+            }
+
+            if(LightPacket == packet.payload)
+            {
+                glm::mat4 lightMVP;
+                TransformMath::multiply(viewProjection, lightModel, lightMVP);
+                lightShader->set(lightMVPHandle, lightMVP);
+                cubeMesh.draw();
+            }
+            else if(InstancedBoxPacket == packet.payload)
+            {
+                cubeMesh.drawInstanced(objInstancedVAO, boxInstances.getCount());
+            }
+            else if(IndirectBoxPacket == packet.payload)
+            {
+                indirectRenderer->draw(objIndirectVAO, cubeMesh.getIndexType(), 0);
+            }
+            else
+            {
+                uint32_t index = visibleBoxes[packet.payload];
+                boxShader->set(boxMVPHandle, visibleMVPs[packet.payload]);
+                boxShader->set(boxModelHandle, boxModels[index]);
+                boxShader->set(boxNormalMatrixHandle, boxNormalMatrices[index]);
+                cubeMesh.draw();
+            }
+        }
+        // 延迟渲染累积光照后前向绘制光源物体,再复制到默认帧缓冲
+        if(bUseDeferred)
+        {
+            deferredRenderer.drawLights(viewProjection, bUseDirectionLight, bUseShadows);
+            deferredRenderer.beginForwardPass();
+            glm::mat4 lightMVP;
+            TransformMath::multiply(viewProjection, lightModel, lightMVP);
+            lightShader->set(lightMVPHandle, lightMVP);
+            lightShader->use();
+            cubeMesh.draw();
+            deferredRenderer.present();
+        }
+        // 本帧的动态数据在GPU读取完之前不会被覆盖
+        frameRing.endFrame();
+    };
 
-    // 激活着色器
-    boxShader.use();
-    // 设置纹理激活单元
-    boxShader.setUniform1i("material.diffuse", 0);
-    boxShader.setUniform1i("material.specular", 1);
+    // 依次测量各子系统的耗时后退出
+    if(bIsBenchmark)
+    {
+        // 箱子贴图上传完成后再测量
+        textureStreamer.finish();
+        BenchmarkScene scene;
+        scene.switches = {&bUseInstancing, &bUseIndirect, &bUseCulling, &bUseDeferred, &bUseClustered, &bUseShadows, &bUseAnimation,
+                          &bUseDirectionLight};
+        scene.camera = &camera;
+        scene.width = width;
+        scene.height = height;
+        scene.farPlane = farPlane;
+        scene.boxModels = &boxModels;
+        scene.boxBounds = &boxBounds;
+        scene.boxAABBs = &boxAABBs;
+        scene.dynamicBoxCount = &dynamicBoxCount;
+        scene.renderQueue = &renderQueue;
+        scene.indirectRenderer = indirectRenderer.get();
+        scene.frameRing = &frameRing;
+        scene.pointLights = &pointLights;
+        scene.clusteredLighting = &clusteredLighting;
+        scene.lightCount = lightCount;
+        scene.shadowMaps = &shadowMaps;
+        scene.threadPool = &threadPool;
+        scene.preparePool = &preparePool;
+        scene.textureUploadBudget = TextureUploadBudget;
+        scene.setBoxCount = setBoxCount;
+        scene.setLightCount = setLightCount;
+        scene.updateBoxShader = updateBoxShader;
+        scene.animateBoxes = animateBoxes;
+        scene.makeBoxModels = [&](size_t count, ThreadPool &pool)
+        {
+            return makeBoxModels(cubePositions, sizeof(cubePositions) / sizeof(cubePositions[0]), count, pool);
+        };
+        scene.renderScene = renderScene;
+        scene.cullBoxes = cullBoxes;
+        scene.fillRenderQueue = fillRenderQueue;
+        scene.prepareBoxPackets = prepareBoxPackets;
+        Benchmark::run(scene);
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return EXIT_SUCCESS;
+    }
 
     // 渲染循环
     while(!glfwWindowShouldClose(window))
@@ -203,79 +811,49 @@ int main()
         deltaTime = currentTime - lastTime;
         lastTime = currentTime;
 
-        // 设置颜色缓冲区清除颜色
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        // 清除颜色缓冲区与深度缓冲区
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // 开始统计本帧的GL状态调用
+        GLStateCache::beginFrame();
+        // 每秒输出一次上一帧的GL状态调用统计
+        if((int)currentTime != (int)(currentTime - deltaTime))
+        {
+            GLStateCounters counters = GLStateCache::getFrameCounters();
+            std::cout << "## GL state ## issued = " << counters.issued << ", elided = " << counters.elided
+                      << ", uniforms issued = " << counters.uniformsIssued << ", skipped = " << counters.uniformsSkipped << std::endl;
+        }
 
-        // 键盘输入
-        keyboardInput(window);
+        // 按P拾取屏幕中心的箱子,射线从相机位置沿相机方向
+        if(bIsPickRequested)
+        {
+            bIsPickRequested = false;
+            BVHHit hit;
+            if(boxBVH.raycast(camera.getCameraPosition(), camera.getCameraFront(), farPlane, hit))
+                std::cout << "## Pick ## box " << hit.index << " at distance " << hit.distance << std::endl;
+            else
+                std::cout << "## Pick ## nothing" << std::endl;
+        }
 
-        // 视图矩阵
-        glm::mat4 view = camera.getViewMatrix();
-        // 裁剪矩阵
-        glm::mat4 projection = glm::perspective(glm::radians(camera.getCameraFOV()), (float)width/(float)height, 0.1f, 100.0f);
-
-        // 设置光源物体着色器
-        lightShader.use();
-
-        // 设置光源物体顶点着色器模型矩阵
-        glm::mat4 lightModel(1.0f);
-        lightModel = glm::translate(lightModel, lightPos);
-        lightModel = glm::scale(lightModel, glm::vec3(0.2));
-        lightShader.setUniformMatrix4fv("model", lightModel);
-        // 设置光源物体顶点着色器视图矩阵
-        lightShader.setUniformMatrix4fv("view", view);
-        // 设置光源物体顶点着色器裁剪矩阵
-        lightShader.setUniformMatrix4fv("projection", projection);
-
-        // 绘制光源物体
-        glBindVertexArray(lightVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // 设置立方体物体着色器
-        boxShader.use();
-
-        // 设置箱子立方体物体顶点着色器视图矩阵、裁剪矩阵
-        boxShader.setUniformMatrix4fv("view", view);
-        boxShader.setUniformMatrix4fv("projection", projection);
-
-        // 相机位置
-        boxShader.setUniform3fv("cameraPosition", camera.getCameraPosition());
-
-        // 材质属性由本身的材质特点决定
-        boxShader.setUniform1f("material.shininess", 64.0f);
-
-        // 光源分解为3个分量,环境光一般较弱,漫反射光源一般为光实际的颜色,镜面光一般设置为最大(白色)4
-        boxShader.setUniform3fv("light.position", lightPos);
-
-        boxShader.setUniform1f("light.constant", 1.0f);
-        boxShader.setUniform1f("light.linear", 0.7f);
-        boxShader.setUniform1f("light.quadratic", 1.8f);
-
-        boxShader.setUniform3fv("light.ambient", glm::vec3(0.2f));
-        boxShader.setUniform3fv("light.diffuse", glm::vec3(0.8f));
-        boxShader.setUniform3fv("light.specular", glm::vec3(1.0f));
-        //boxShader.setUniform3fv("light.position", lightPos);
-
-        // 绑定贴图
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, boxDiffuseTexId);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, boxSpecularTexId);
-
-        // 绘制立方体物体
-        glBindVertexArray(objVAO);
-        for (unsigned int i = 0; i < 10; i++)
+        // 替换后台重新读取的着色器程序
+        shaderWatcher.update();
+        // 上传解码完成的贴图
+        textureStreamer.update();
+
+        // 按M切换动态箱子的旋转
+        if(bUseAnimation)
         {
-            glm::mat4 objModel = glm::mat4(1.0f);
-            objModel = glm::translate(objModel, cubePositions[i]);
-            float angle = 20.0f * i;
-            objModel = glm::rotate(objModel, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            boxShader.setUniformMatrix4fv("model", objModel);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            animationTime += deltaTime;
+            animateBoxes(animationTime);
         }
 
+        // 键盘输入
+        keyboardInput(window);
+
+        // 按E切换自发光贴图,按L切换平行光与点光源,按I切换实例化绘制,按G切换间接绘制,按R切换延迟渲染,按K切换分簇前向渲染
+        // 按H切换阴影,变体在第一次切换时编译
+        updateBoxShader();
+
+        // 绘制场景
+        renderScene();
+
         // 双缓冲交换
         glfwSwapBuffers(window);
         // 事件处理
@@ -337,55 +915,63 @@ void keyboardInput(GLFWwindow *window)
     }
 }
 
-// 加载贴图
-GLuint loadTexture(const std::string &path)
+// 按键事件回调函数,只处理切换类按键,移动由keyboardInput每帧查询
+void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
-    // 贴图ID
-    GLuint textureID;
-    // 生成贴图
-    glGenTextures(1, &textureID);
-    // 图片信息
-    int width, height, channel;
-    // 加载图片
-    unsigned char *data = stbi_load(path.c_str(), &width, &height, &channel, 0);
-    // 判断是否加载图片成功
-    if(data)
-    {
-        GLenum format;
-
-        // 判断图片通道
-        if(1 == channel)
-            format = GL_RED;
-        else if(3 == channel)
-            format = GL_RGB;
-        else if(4 == channel)
-            format = GL_RGBA;
-
-        // 绑定贴图
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        // 设置贴图数据
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-
-        // 生成Mipmap
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // 设置贴图UV过大情况
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        // 设置贴图缩小生成Mipmap
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        // 设置贴图放大,失真时做线性差值融合
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if(action != GLFW_PRESS)
+    {
+        return;
     }
-    else
+    // 切换自发光贴图
+    if(key == GLFW_KEY_E)
     {
-        std::cout << "Texture Load Fail, Path = " << path << std::endl;
+        bUseEmission = !bUseEmission;
+    }
+    // 切换平行光与点光源
+    if(key == GLFW_KEY_L)
+    {
+        bUseDirectionLight = !bUseDirectionLight;
+    }
+    // 切换实例化绘制与逐个绘制
+    if(key == GLFW_KEY_I)
+    {
+        bUseInstancing = !bUseInstancing;
+    }
+    // 切换GPU剔除与间接绘制,关闭后使用实例化或逐个绘制
+    if(key == GLFW_KEY_G && IndirectRenderer::isSupported())
+    {
+        bUseIndirect = !bUseIndirect;
+    }
+    // 切换视锥体剔除
+    if(key == GLFW_KEY_C)
+    {
+        bUseCulling = !bUseCulling;
+    }
+    // 切换延迟渲染与前向渲染,延迟渲染时平行光叠加在所有点光源之上
+    if(key == GLFW_KEY_R)
+    {
+        bUseDeferred = !bUseDeferred;
+    }
+    // 切换分簇前向渲染,平行光叠加在所有点光源之上
+    if(key == GLFW_KEY_K)
+    {
+        bUseClustered = !bUseClustered;
+    }
+    // 切换阴影
+    if(key == GLFW_KEY_H)
+    {
+        bUseShadows = !bUseShadows;
+    }
+    // 切换动态箱子的旋转
+    if(key == GLFW_KEY_M)
+    {
+        bUseAnimation = !bUseAnimation;
+    }
+    // 拾取屏幕中心的箱子
+    if(key == GLFW_KEY_P)
+    {
+        bIsPickRequested = true;
     }
-    // 释放资源数据
-    stbi_image_free(data);
-
-    return textureID;
 }
 
 // 获取OpenGL信息
@@ -400,3 +986,73 @@ void getDeviceGLInfo()
 
     std::cout << "vendor = " << vendor << ",renderer = " << renderer << ",version = " << version << std::endl;
 }
+
+// 生成箱子模型矩阵,前面的箱子使用给定位置,其余的在与数量相称的范围内随机摆放,矩阵在线程池中并行构建
+std::vector<glm::mat4> makeBoxModels(const glm::vec3 *positions, size_t positionCount, size_t count, ThreadPool &threadPool)
+{
+    // 箱子的摆放参数,随机数按顺序生成,场景与线程数量无关
+    struct BoxPlacement
+    {
+        glm::vec3 position;
+        glm::vec3 axis;
+        float angle;
+    };
+    std::vector<BoxPlacement> placements;
+    placements.reserve(count);
+    for(size_t i = 0; i < count && i < positionCount; i++)
+    {
+        placements.push_back({positions[i], glm::vec3(1.0f, 0.3f, 0.5f), 20.0f * i});
+    }
+
+    // 固定随机种子,每次运行场景相同;范围随数量的立方根增长,保持箱子密度不变
+    std::mt19937 random(20240101);
+    float extent = 2.0f * std::cbrt((float)count);
+    std::uniform_real_distribution<float> offset(-extent, extent);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    while(placements.size() < count)
+    {
+        glm::vec3 position(offset(random), offset(random), offset(random) - extent);
+        glm::vec3 axis(unit(random), unit(random), unit(random));
+        if(glm::dot(axis, axis) < 1e-4f)
+            axis = glm::vec3(0.0f, 1.0f, 0.0f);
+        placements.push_back({position, glm::normalize(axis), angle(random)});
+    }
+
+    std::vector<glm::mat4> models(count);
+    threadPool.parallelFor(count, 4096, [&](size_t begin, size_t end, size_t)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, placements[i].position);
+            model = glm::rotate(model, glm::radians(placements[i].angle), placements[i].axis);
+            models[i] = model;
+        }
+    });
+    return models;
+}
+
+// 生成点光源,第一个为给定的光源,其余的在包围盒内随机摆放并使用随机颜色
+void makePointLights(const PointLightData &firstLight, size_t count, const glm::vec3 &minimum, const glm::vec3 &maximum, PointLightList &lights)
+{
+    // 固定随机种子,每次运行光源相同;衰减与第一个光源相同,不带环境光,避免大量光源叠加后整体变亮
+    std::mt19937 random(20240607);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    lights.resize(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        if(0 == i)
+        {
+            lights.set(i, firstLight);
+            continue;
+        }
+        PointLightData light = firstLight;
+        light.position = minimum + (maximum - minimum) * glm::vec3(unit(random), unit(random), unit(random));
+        glm::vec3 color(unit(random), unit(random), unit(random));
+        light.ambient = glm::vec3(0.0f);
+        light.diffuse = 0.8f * color;
+        light.specular = color;
+        lights.set(i, light);
+    }
+}
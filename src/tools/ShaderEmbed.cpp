@@ -0,0 +1,155 @@
+// 着色器嵌入工具,构建时把shader目录中的文件转换为C++常量表
+// 用法: ShaderEmbed <输出文件> <着色器根目录> <相对路径>...
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 嵌入的文件
+struct ShaderFile
+{
+    // 相对于着色器根目录的路径,使用'/'分隔
+    std::string path;
+    // 文件内容
+    std::string content;
+};
+
+// FNV-1a 64位哈希,与ShaderCache::hash一致
+static uint64_t hash(const std::string &data)
+{
+    uint64_t result = 14695981039346656037ULL;
+    for(unsigned char c : data)
+    {
+        result ^= c;
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
+
+// 转换为C++字符串字面量,每行一段
+// 非ASCII字符使用八进制转义,十六进制转义会吞掉后面的十六进制字符;问号转义避免三字符组
+static std::string toLiteral(const std::string &content)
+{
+    if(content.empty())
+    {
+        return "    \"\"";
+    }
+    std::string result;
+    std::string line;
+    for(size_t i = 0; i < content.size(); i++)
+    {
+        unsigned char c = (unsigned char)content[i];
+        switch(c)
+        {
+            case '\n': line.append("\\n"); break;
+            case '\r': line.append("\\r"); break;
+            case '\t': line.append("\\t"); break;
+            case '"': line.append("\\\""); break;
+            case '\\': line.append("\\\\"); break;
+            case '?': line.append("\\?"); break;
+            default:
+                if(c < 0x20 || c >= 0x7F)
+                {
+                    char escape[8];
+                    std::snprintf(escape, sizeof(escape), "\\%03o", c);
+                    line.append(escape);
+                }
+                else
+                {
+                    line.push_back((char)c);
+                }
+                break;
+        }
+        if(c == '\n' || i + 1 == content.size())
+        {
+            if(!result.empty())
+                result.push_back('\n');
+            result.append("    \"").append(line).append("\"");
+            line.clear();
+        }
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 3)
+    {
+        std::cerr << "Usage: ShaderEmbed <output> <shader directory> <relative path>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string outputPath = argv[1];
+    std::string rootDirectory = argv[2];
+
+    std::vector<ShaderFile> files;
+    for(int i = 3; i < argc; i++)
+    {
+        ShaderFile file;
+        file.path = argv[i];
+        std::replace(file.path.begin(), file.path.end(), '\\', '/');
+        std::ifstream stream(rootDirectory + "/" + file.path, std::ios::binary);
+        if(!stream)
+        {
+            std::cerr << "ShaderEmbed: Read File Fail, Path = " << rootDirectory << "/" << file.path << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::ostringstream content;
+        content << stream.rdbuf();
+        file.content = content.str();
+        files.push_back(file);
+    }
+    // 按路径排序,运行时二分查找
+    std::sort(files.begin(), files.end(), [](const ShaderFile &a, const ShaderFile &b)
+    {
+        return a.path < b.path;
+    });
+
+    std::ostringstream output;
+    output << "// 由ShaderEmbed根据shader目录生成,不要手动修改\n";
+    output << "#include \"EmbeddedShaders.h\"\n\n";
+    output << "namespace\n{\n";
+    for(size_t i = 0; i < files.size(); i++)
+    {
+        output << "// " << files[i].path << "\n";
+        output << "constexpr char ShaderData" << i << "[] =\n" << toLiteral(files[i].content) << ";\n";
+    }
+    output << "\n// 按路径排序,最后一项为结束标记\n";
+    output << "constexpr EmbeddedShader EmbeddedShaderTable[] = {\n";
+    for(size_t i = 0; i < files.size(); i++)
+    {
+        char hashText[24];
+        std::snprintf(hashText, sizeof(hashText), "0x%016llXULL", (unsigned long long)hash(files[i].content));
+        output << "    {\"" << files[i].path << "\", ShaderData" << i << ", " << files[i].content.size() << ", " << hashText << "},\n";
+    }
+    output << "    {nullptr, nullptr, 0, 0}\n";
+    output << "};\n";
+    output << "}\n\n";
+    output << "const EmbeddedShader *const EmbeddedShaders::entries = EmbeddedShaderTable;\n";
+    output << "const size_t EmbeddedShaders::count = " << files.size() << ";\n";
+
+    // 内容不变时不改写文件,避免重新编译
+    std::string text = output.str();
+    {
+        std::ifstream existing(outputPath, std::ios::binary);
+        if(existing)
+        {
+            std::ostringstream content;
+            content << existing.rdbuf();
+            if(content.str() == text)
+                return EXIT_SUCCESS;
+        }
+    }
+    std::ofstream stream(outputPath, std::ios::binary);
+    if(!stream)
+    {
+        std::cerr << "ShaderEmbed: Write File Fail, Path = " << outputPath << std::endl;
+        return EXIT_FAILURE;
+    }
+    stream << text;
+    return stream ? EXIT_SUCCESS : EXIT_FAILURE;
+}
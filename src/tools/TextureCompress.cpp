@@ -0,0 +1,122 @@
+// 贴图压缩工具,构建时把图片压缩为带完整Mipmap链的KTX2文件
+// 用法: TextureCompress <输出目录> <图片路径>...
+// 文件名以_normal结尾的图片编码为BC5,有透明像素的编码为BC3,其余编码为BC1
+// Mipmap链由MipmapGenerator生成,按贴图的用途选择缩小的空间,与压缩格式无关
+// 文件名以_specular或_normal结尾的图片保存的是数据,按存储的值缩小,其余按sRGB颜色在线性空间缩小
+#include "BlockCompressor.h"
+#include "KTXTexture.h"
+#include "MipmapGenerator.h"
+#include "ThreadPool.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 去掉目录与扩展名的文件名
+static std::string getStem(const std::string &path)
+{
+    size_t slash = path.find_last_of("/\\");
+    std::string name = std::string::npos == slash ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return std::string::npos == dot ? name : name.substr(0, dot);
+}
+
+// 保存数据而不是颜色的贴图的文件名后缀
+static const char *const LinearSuffixes[] = {"_specular", "_normal"};
+
+// 文件名是否以suffix结尾
+static bool hasSuffix(const std::string &stem, const std::string &suffix)
+{
+    return stem.size() >= suffix.size() && 0 == stem.compare(stem.size() - suffix.size(), suffix.size(), suffix);
+}
+
+// 按文件名判断贴图是否为颜色贴图
+static bool isColorTexture(const std::string &stem)
+{
+    for(const char *suffix : LinearSuffixes)
+    {
+        if(hasSuffix(stem, suffix))
+            return false;
+    }
+    return true;
+}
+
+// 按文件名与透明度选择压缩格式
+static BlockCompressor::Format chooseFormat(const std::string &stem, const unsigned char *pixels, size_t pixelCount)
+{
+    if(hasSuffix(stem, "_normal"))
+        return BlockCompressor::BC5;
+    for(size_t i = 0; i < pixelCount; i++)
+    {
+        if(pixels[i * 4 + 3] != 255)
+            return BlockCompressor::BC3;
+    }
+    return BlockCompressor::BC1;
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 3)
+    {
+        std::cerr << "Usage: TextureCompress <output directory> <image path>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string outputDirectory = argv[1];
+
+    ThreadPool threadPool;
+    BlockCompressor compressor(&threadPool);
+    MipmapGenerator generator(&threadPool);
+    for(int i = 2; i < argc; i++)
+    {
+        std::string path = argv[i];
+        auto startTime = std::chrono::steady_clock::now();
+        int width, height, channel;
+        unsigned char *data = stbi_load(path.c_str(), &width, &height, &channel, 4);
+        if(!data)
+        {
+            std::cerr << "TextureCompress: Read File Fail, Path = " << path << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::string stem = getStem(path);
+        BlockCompressor::Format format = chooseFormat(stem, data, (size_t)width * height);
+        std::vector<unsigned char> pixels(data, data + (size_t)width * height * 4);
+        stbi_image_free(data);
+
+        // 从原图开始逐级缩小到1x1,每一级压缩后再缩小
+        bool bIsSRGB = isColorTexture(stem);
+        std::vector<unsigned char> nextPixels;
+        std::vector<std::vector<unsigned char>> levels;
+        int levelWidth = width;
+        int levelHeight = height;
+        size_t compressedSize = 0;
+        for(;;)
+        {
+            levels.emplace_back(BlockCompressor::getCompressedSize(format, levelWidth, levelHeight));
+            compressor.compress(format, pixels.data(), levelWidth, levelHeight, levels.back().data());
+            compressedSize += levels.back().size();
+            if(1 == levelWidth && 1 == levelHeight)
+                break;
+            nextPixels.resize((size_t)std::max(levelWidth / 2, 1) * std::max(levelHeight / 2, 1) * 4);
+            generator.downsample(pixels.data(), levelWidth, levelHeight, bIsSRGB, nextPixels.data());
+            pixels.swap(nextPixels);
+            levelWidth = std::max(levelWidth / 2, 1);
+            levelHeight = std::max(levelHeight / 2, 1);
+        }
+
+        std::string outputPath = outputDirectory + "/" + stem + ".ktx2";
+        if(!KTXTexture::write(outputPath, format, bIsSRGB, width, height, levels))
+        {
+            std::cerr << "TextureCompress: Write File Fail, Path = " << outputPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "## TextureCompress ## " << path << " -> " << outputPath << ", " << BlockCompressor::getFormatName(format)
+                  << (bIsSRGB ? " sRGB " : " linear ") << width << "x" << height << ", " << levels.size() << " levels, " << compressedSize << " bytes, "
+                  << BlockCompressor::getInstructionSetName(BlockCompressor::getBestInstructionSet()) << " x "
+                  << threadPool.getThreadCount() << " threads, " << milliseconds << " ms" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}